@@ -0,0 +1,22 @@
+/*******************************************************************************
+ * @file bench_config.h
+ *
+ * @brief Build switch for the Blink Lab benchmarks.
+ *
+ * The false sharing, lock, IPI, memory, interrupt latency and work stealing
+ * benchmarks take the harts for a while before the blink loop starts, print
+ * pages of results on UART0 and, for the memory benchmark, add a
+ * MEM_BENCH_DDR_SIZE buffer to .bss that start-up has to clear. They are
+ * left out unless the project is built with -DBLINK_BENCHMARKS=1; with it
+ * unset each *_bench.c compiles to nothing and the harts go straight to the
+ * blink loop.
+ */
+
+#ifndef BENCH_CONFIG_H_
+#define BENCH_CONFIG_H_
+
+#ifndef BLINK_BENCHMARKS
+#define BLINK_BENCHMARKS        0
+#endif
+
+#endif /* BENCH_CONFIG_H_ */
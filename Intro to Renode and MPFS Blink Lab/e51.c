@@ -4,66 +4,160 @@
 #include "drivers/mss_uart/mss_uart.h"
 
 #include "inc/common.h"
+#include "hart_data.h"
+#include "false_sharing_bench.h"
+#include "fast_mem.h"
+#include "irq_stats.h"
+#include "irq_plan.h"
+#include "irq_affinity.h"
+#include "uart0.h"
+#include "lock_bench.h"
+#include "ipi_bench.h"
+#include "mem_bench.h"
+
+/* Calls and run time of each GPIO handler, kept in the scratchpad with the
+ * handlers. e51_application() prints them every IRQ_REPORT_PASSES passes. */
+#define IRQ_REPORT_PASSES       16u
+
+static irq_stat_t g_irq_gpio0_0 LIM_DATA =
+        IRQ_STAT_INIT("gpio0_0", GPIO0_BIT0_or_GPIO2_BIT0_PLIC_0, 0u);
+static irq_stat_t g_irq_gpio0_1 LIM_DATA =
+        IRQ_STAT_INIT("gpio0_1", GPIO0_BIT1_or_GPIO2_BIT1_PLIC_1, 0u);
+static irq_stat_t g_irq_gpio0_2 LIM_DATA =
+        IRQ_STAT_INIT("gpio0_2", GPIO0_BIT2_or_GPIO2_BIT2_PLIC_2, 0u);
+static irq_stat_t g_irq_gpio0_nd LIM_DATA =
+        IRQ_STAT_INIT("gpio0_nd", GPIO0_NON_DIRECT_PLIC, 0u);
+static irq_stat_t g_irq_gpio1_nd LIM_DATA =
+        IRQ_STAT_INIT("gpio1_nd", GPIO1_NON_DIRECT_PLIC, 0u);
+static irq_stat_t g_irq_gpio2_nd LIM_DATA =
+        IRQ_STAT_INIT("gpio2_nd", GPIO2_NON_DIRECT_PLIC, 0u);
+
+static irq_stat_t * const g_irq_stats[] =
+{
+    &g_irq_gpio0_0, &g_irq_gpio0_1, &g_irq_gpio0_2,
+    &g_irq_gpio0_nd, &g_irq_gpio1_nd, &g_irq_gpio2_nd
+};
+
+/* The button handlers print, so they are logging class and let everything
+ * else in while they wait on the UART. The non-direct handlers are short and
+ * must get in within 10 us. */
+#define IRQ_IO_TARGET   (LIBERO_SETTING_MSS_COREPLEX_CPU_CLK / 100000u)
+
+static const irq_plan_entry_t g_irq_plan[] =
+{
+    { GPIO0_BIT0_or_GPIO2_BIT0_PLIC_0, IRQ_PRIO_LOG, IRQ_PLAN_NESTS, 0u, &g_irq_gpio0_0 },
+    { GPIO0_BIT1_or_GPIO2_BIT1_PLIC_1, IRQ_PRIO_LOG, IRQ_PLAN_NESTS, 0u, &g_irq_gpio0_1 },
+    { GPIO0_BIT2_or_GPIO2_BIT2_PLIC_2, IRQ_PRIO_LOG, IRQ_PLAN_NESTS, 0u, &g_irq_gpio0_2 },
+    { GPIO0_NON_DIRECT_PLIC, IRQ_PRIO_IO, 0u, IRQ_IO_TARGET, &g_irq_gpio0_nd },
+    { GPIO1_NON_DIRECT_PLIC, IRQ_PRIO_IO, 0u, IRQ_IO_TARGET, &g_irq_gpio1_nd },
+    { GPIO2_NON_DIRECT_PLIC, IRQ_PRIO_IO, 0u, IRQ_IO_TARGET, &g_irq_gpio2_nd },
+};
+
+/* Harts 1 to 4 take the GPIO interrupts. The balancer moves them off the
+ * E51 on its first run and then spreads them by handler time, every
+ * IRQ_REPORT_PASSES passes. */
+static irq_balance_src_t g_irq_balance_srcs[] =
+{
+    IRQ_BALANCE_SRC(GPIO0_BIT0_or_GPIO2_BIT0_PLIC_0, &g_irq_gpio0_0),
+    IRQ_BALANCE_SRC(GPIO0_BIT1_or_GPIO2_BIT1_PLIC_1, &g_irq_gpio0_1),
+    IRQ_BALANCE_SRC(GPIO0_BIT2_or_GPIO2_BIT2_PLIC_2, &g_irq_gpio0_2),
+    IRQ_BALANCE_SRC(GPIO0_NON_DIRECT_PLIC, &g_irq_gpio0_nd),
+    IRQ_BALANCE_SRC(GPIO1_NON_DIRECT_PLIC, &g_irq_gpio1_nd),
+    IRQ_BALANCE_SRC(GPIO2_NON_DIRECT_PLIC, &g_irq_gpio2_nd),
+};
+
+static irq_balancer_t g_irq_balancer;
 
-uint64_t uart_lock;
+/* How often, and for how long, the harts queue for UART0. */
+static lock_stats_t * const g_lock_stats[] = { &g_uart0_lock.stats };
 
 
-uint8_t gpio0_bit0_or_gpio2_bit13_plic_0_IRQHandler(void)
+/* The GPIO handlers run from the L2 scratchpad (fast_mem.h), so a button
+ * press is not held up by cache misses to DDR. */
+uint8_t RAM_TEXT gpio0_bit0_or_gpio2_bit13_plic_0_IRQHandler(void)
 {
-	MSS_UART_polled_tx_string(&g_mss_uart0_lo,
-			"\r\nSetting output 0 to high\r\n");
+	irq_nest_t nest;
+
+	IRQ_STATS_ENTER(&g_irq_gpio0_0);
+	irq_nest_enter(&nest, IRQ_PRIO_LOG, &g_irq_gpio0_0);
+	uart0_tx_string("\r\nSetting output 0 to high\r\n");
+	irq_nest_exit(&nest);
 
 	MSS_GPIO_set_output(GPIO1_LO, MSS_GPIO_0, 1);
 	MSS_GPIO_clear_irq(GPIO0_LO, MSS_GPIO_0);
+	IRQ_STATS_EXIT(&g_irq_gpio0_0);
 	return EXT_IRQ_KEEP_ENABLED;
 }
 
 
-uint8_t gpio0_bit1_or_gpio2_bit13_plic_1_IRQHandler(void)
+uint8_t RAM_TEXT gpio0_bit1_or_gpio2_bit13_plic_1_IRQHandler(void)
 {
-	MSS_UART_polled_tx_string(&g_mss_uart0_lo,
-			"\r\nSetting output 1 to high\r\n");
+	irq_nest_t nest;
+
+	IRQ_STATS_ENTER(&g_irq_gpio0_1);
+	irq_nest_enter(&nest, IRQ_PRIO_LOG, &g_irq_gpio0_1);
+	uart0_tx_string("\r\nSetting output 1 to high\r\n");
+	irq_nest_exit(&nest);
 
 	MSS_GPIO_set_output(GPIO1_LO, MSS_GPIO_1, 1);
 	MSS_GPIO_clear_irq(GPIO0_LO, MSS_GPIO_1);
+	IRQ_STATS_EXIT(&g_irq_gpio0_1);
 	return EXT_IRQ_KEEP_ENABLED;
 }
 
 
-uint8_t gpio0_bit2_or_gpio2_bit13_plic_2_IRQHandler(void)
+uint8_t RAM_TEXT gpio0_bit2_or_gpio2_bit13_plic_2_IRQHandler(void)
 {
-	MSS_UART_polled_tx_string(&g_mss_uart0_lo,
-			"\r\nSetting output 2 to high\r\n");
+	irq_nest_t nest;
+
+	IRQ_STATS_ENTER(&g_irq_gpio0_2);
+	irq_nest_enter(&nest, IRQ_PRIO_LOG, &g_irq_gpio0_2);
+	uart0_tx_string("\r\nSetting output 2 to high\r\n");
+	irq_nest_exit(&nest);
 
 	MSS_GPIO_set_output(GPIO1_LO, MSS_GPIO_2, 1);
 	MSS_GPIO_clear_irq(GPIO0_LO, MSS_GPIO_2);
+	IRQ_STATS_EXIT(&g_irq_gpio0_2);
 	return EXT_IRQ_KEEP_ENABLED;
 }
 
 
 uint8_t gpio0_non_direct_plic_IRQHandler(void)
 {
+	IRQ_STATS_ENTER(&g_irq_gpio0_nd);
+	IRQ_STATS_EXIT(&g_irq_gpio0_nd);
 	return EXT_IRQ_KEEP_ENABLED;
 }
 
 
 uint8_t gpio1_non_direct_plic_IRQHandler(void)
 {
+	IRQ_STATS_ENTER(&g_irq_gpio1_nd);
+	IRQ_STATS_EXIT(&g_irq_gpio1_nd);
 	return EXT_IRQ_KEEP_ENABLED;
 }
 
 
 uint8_t gpio2_non_direct_plic_IRQHandler(void)
 {
+	IRQ_STATS_ENTER(&g_irq_gpio2_nd);
+	IRQ_STATS_EXIT(&g_irq_gpio2_nd);
 	return EXT_IRQ_KEEP_ENABLED;
 }
 
 
+void Software_h0_IRQHandler(void)
+{
+#if BLINK_BENCHMARKS
+	ipi_bench_irq();
+#endif
+}
+
+
 void e51_setup(void)
 {
-    /*This mutex is used to serialize accesses to UART0 when all harts want to
-     * TX/RX on UART0. This mutex is shared across all harts.*/
-    mss_init_mutex((uint64_t)&uart_lock);
+    /* Copy .ram_text/.lim_data to the scratchpad before any of it can run. */
+    fast_mem_init();
 
     /* Bring the UART0, GPIO0, GPIO1 and GPIO2 out of Reset */
     SYSREG->SOFT_RESET_CR &= ~((1u << 0u) | (1u << 4u) | (1u << 5u)
@@ -82,14 +176,7 @@ void e51_setup(void)
 
     /*************************************************************************/
     PLIC_init();
-    PLIC_SetPriority_Threshold(0);
-    PLIC_SetPriority(GPIO0_BIT0_or_GPIO2_BIT0_PLIC_0, 2);
-    PLIC_SetPriority(GPIO0_BIT1_or_GPIO2_BIT1_PLIC_1, 2);
-    PLIC_SetPriority(GPIO0_BIT2_or_GPIO2_BIT2_PLIC_2, 2);
-
-    PLIC_SetPriority(GPIO0_NON_DIRECT_PLIC, 2);
-    PLIC_SetPriority(GPIO1_NON_DIRECT_PLIC, 2);
-    PLIC_SetPriority(GPIO2_NON_DIRECT_PLIC, 2);
+    irq_plan_apply(g_irq_plan, sizeof(g_irq_plan) / sizeof(g_irq_plan[0]));
 
     __disable_local_irq((int8_t) MMUART0_E51_INT);
     __enable_irq();
@@ -110,6 +197,10 @@ void e51_setup(void)
     MSS_GPIO_enable_irq(GPIO0_LO, MSS_GPIO_1);
     MSS_GPIO_enable_irq(GPIO0_LO, MSS_GPIO_2);
 
+    irq_balance_init(&g_irq_balancer, g_irq_balance_srcs,
+                     sizeof(g_irq_balance_srcs) / sizeof(g_irq_balance_srcs[0]),
+                     IRQ_AFFINITY_U54S);
+
     /* GPIO1 */
     MSS_GPIO_init(GPIO1_LO);
     MSS_GPIO_config(GPIO1_LO, MSS_GPIO_0, MSS_GPIO_OUTPUT_MODE);
@@ -132,12 +223,32 @@ void e51_setup(void)
      * enough time for the hart1 to be in sleep when this point of code is
      * reached. */
     raise_soft_interrupt(1u);
+    raise_soft_interrupt(2u);
+    raise_soft_interrupt(3u);
+    raise_soft_interrupt(4u);
 }
 
 
 void e51_application(void)
 {
-    safe_MSS_UART0_polled_tx_string("Hello World from e51 (hart 0).\r\n");
+    uint32_t pass = 0u;
+
+    uart0_tx_string("Hello World from e51 (hart 0).\r\n");
+
+#if BLINK_BENCHMARKS
+    /* Hart 1 runs its half as soon as it is out of WFI. */
+    false_sharing_bench_run(0u);
+    false_sharing_bench_report(uart0_tx_string);
+
+    /* Harts 1 to 4 join in once they are up. */
+    lock_bench_run(0u);
+    lock_bench_report(uart0_tx_string);
+
+    ipi_bench_run(0u);
+    ipi_bench_report(uart0_tx_string);
+    mem_bench_run(0u);
+    mem_bench_report(uart0_tx_string);
+#endif
 
     while (1)
     {
@@ -150,7 +261,7 @@ void e51_application(void)
             delay_loop_sum = delay_loop_sum + i;
         }
 
-        safe_MSS_UART0_polled_tx_string("Setting outputs 0, 1 and 2 to high\r\n");
+        uart0_tx_string("Setting outputs 0, 1 and 2 to high\r\n");
 
         MSS_GPIO_set_output(GPIO1_LO, MSS_GPIO_0, 1);
         MSS_GPIO_set_output(GPIO1_LO, MSS_GPIO_1, 1);
@@ -160,10 +271,27 @@ void e51_application(void)
             delay_loop_sum = delay_loop_sum + i;
         }
 
-        safe_MSS_UART0_polled_tx_string("Setting outputs 0, 1 and 2 to low\r\n");
+        uart0_tx_string("Setting outputs 0, 1 and 2 to low\r\n");
         MSS_GPIO_set_output(GPIO1_LO, MSS_GPIO_0, 0);
         MSS_GPIO_set_output(GPIO1_LO, MSS_GPIO_1, 0);
         MSS_GPIO_set_output(GPIO1_LO, MSS_GPIO_2, 0);
+
+        if (0u == (++pass % IRQ_REPORT_PASSES))
+        {
+            if (0u != irq_balance_run(&g_irq_balancer))
+            {
+                uart0_tx_string("GPIO interrupts rebalanced\r\n");
+            }
+            irq_stats_report(g_irq_stats,
+                             sizeof(g_irq_stats) / sizeof(g_irq_stats[0]),
+                             uart0_tx_string);
+            (void)irq_plan_check(g_irq_plan,
+                                 sizeof(g_irq_plan) / sizeof(g_irq_plan[0]),
+                                 uart0_tx_string);
+            lock_stats_report(g_lock_stats,
+                              sizeof(g_lock_stats) / sizeof(g_lock_stats[0]),
+                              uart0_tx_string);
+        }
     }
 }
 
@@ -0,0 +1,145 @@
+/*******************************************************************************
+ * @file false_sharing_bench.c
+ *
+ * @brief Cost of per-hart counters sharing a cache line.
+ *
+ * See "false_sharing_bench.h" for details of how to use this module.
+ */
+
+#include "false_sharing_bench.h"
+#include "hart_data.h"
+#include "fmt.h"
+
+#if BLINK_BENCHMARKS
+
+/*------------------------------------------------------------------------------
+  Low word of mcycle; one phase is well under 2^32 cycles.
+ */
+static inline uint32_t bench_cycles(void)
+{
+    unsigned long cycles;
+
+    __asm volatile ("csrr %0, mcycle" : "=r"(cycles));
+    return (uint32_t)cycles;
+}
+
+/* Packed: every hart's counter in the same line. */
+static volatile uint64_t g_packed[FS_BENCH_HARTS] CACHE_ALIGNED;
+
+/* Padded: one line per hart. */
+typedef struct fs_padded_counter
+{
+    volatile uint64_t value;
+    CACHE_LINE_PAD(sizeof(uint64_t));
+} fs_padded_counter_t;
+
+static fs_padded_counter_t g_padded[FS_BENCH_HARTS] CACHE_ALIGNED;
+
+/* Results, written once per hart per phase. */
+typedef struct fs_result
+{
+    uint32_t packed_cycles;
+    uint32_t padded_cycles;
+    CACHE_LINE_PAD(2u * sizeof(uint32_t));
+} fs_result_t;
+
+static fs_result_t g_results[FS_BENCH_HARTS] CACHE_ALIGNED;
+
+/* Sense reversing barrier, on a line of its own. */
+static struct
+{
+    uint32_t count;
+    uint32_t generation;
+} g_barrier CACHE_ALIGNED;
+
+static void barrier_wait(void)
+{
+    uint32_t generation = __atomic_load_n(&g_barrier.generation, __ATOMIC_ACQUIRE);
+
+    if (FS_BENCH_HARTS == __atomic_add_fetch(&g_barrier.count, 1u, __ATOMIC_ACQ_REL))
+    {
+        __atomic_store_n(&g_barrier.count, 0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&g_barrier.generation, generation + 1u, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        while (generation == __atomic_load_n(&g_barrier.generation, __ATOMIC_ACQUIRE))
+        {
+            ;
+        }
+    }
+}
+
+/***************************************************************************//**
+ * See "false_sharing_bench.h" for details of how to use this function.
+ */
+void false_sharing_bench_run(uint64_t hartid)
+{
+    uint32_t idx;
+    uint32_t start;
+
+    if (hartid >= FS_BENCH_HARTS)
+    {
+        return;
+    }
+
+    barrier_wait();
+    start = bench_cycles();
+    for (idx = 0u; idx < FS_BENCH_ITERATIONS; idx++)
+    {
+        g_packed[hartid]++;
+    }
+    g_results[hartid].packed_cycles = bench_cycles() - start;
+
+    barrier_wait();
+    start = bench_cycles();
+    for (idx = 0u; idx < FS_BENCH_ITERATIONS; idx++)
+    {
+        g_padded[hartid].value++;
+    }
+    g_results[hartid].padded_cycles = bench_cycles() - start;
+
+    barrier_wait();
+}
+
+/***************************************************************************//**
+ * See "false_sharing_bench.h" for details of how to use this function.
+ */
+void false_sharing_bench_report(fs_bench_out_t out)
+{
+    char line[80];
+    char * p;
+    uint32_t hart;
+    uint32_t packed;
+    uint32_t padded;
+
+    p = line;
+    p = fmt_str(p, "\r\nfalse sharing, ");
+    p = fmt_u32(p, FS_BENCH_ITERATIONS, 0u, ' ');
+    p = fmt_str(p, " increments per hart (cycles):\r\n");
+    *p = '\0';
+    out(line);
+
+    for (hart = 0u; hart < FS_BENCH_HARTS; hart++)
+    {
+        packed = g_results[hart].packed_cycles;
+        padded = g_results[hart].padded_cycles;
+
+        p = line;
+        p = fmt_str(p, "  hart ");
+        p = fmt_u32(p, hart, 0u, ' ');
+        p = fmt_str(p, "  shared line=");
+        p = fmt_u32(p, packed, 10u, ' ');
+        p = fmt_str(p, "  own line=");
+        p = fmt_u32(p, padded, 10u, ' ');
+        p = fmt_str(p, "  x");
+        p = fmt_fixed(p, (int32_t)(((uint64_t)packed << 8) /
+                                   ((0u != padded) ? padded : 1u)), 8u, 1u);
+        p = fmt_str(p, "\r\n");
+        *p = '\0';
+
+        out(line);
+    }
+}
+
+#endif /* BLINK_BENCHMARKS */
@@ -0,0 +1,55 @@
+/*******************************************************************************
+ * @file false_sharing_bench.h
+ *
+ * @brief Cost of per-hart counters sharing a cache line.
+ *
+ * Every taking-part hart increments its own counter FS_BENCH_ITERATIONS
+ * times, first with the counters packed next to each other in one cache line
+ * (the layout plain globals get), then with each counter on a line of its own
+ * (hart_data.h). The harts start each phase together at a barrier, so the
+ * packed phase makes them fight over the line.
+ *
+ * Call false_sharing_bench_run() from each of harts 0 .. FS_BENCH_HARTS - 1,
+ * then false_sharing_bench_report() from one of them.
+ */
+
+#ifndef FALSE_SHARING_BENCH_H_
+#define FALSE_SHARING_BENCH_H_
+
+#include <stdint.h>
+#include "bench_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Harts 0 to FS_BENCH_HARTS - 1 must all call false_sharing_bench_run(). */
+#ifndef FS_BENCH_HARTS
+#define FS_BENCH_HARTS          2u
+#endif
+
+#define FS_BENCH_ITERATIONS     100000u
+
+/*------------------------------------------------------------------------------
+  Called once per line of results, e.g. uart0_tx_string().
+ */
+typedef void (*fs_bench_out_t)(const char * line);
+
+/***************************************************************************//**
+ * false_sharing_bench_run() runs both phases on the calling hart and returns
+ * once every taking-part hart has finished. Harts with an id of
+ * FS_BENCH_HARTS or above return straight away.
+ */
+void false_sharing_bench_run(uint64_t hartid);
+
+/***************************************************************************//**
+ * false_sharing_bench_report() prints the cycles each hart took per phase.
+ * Call it after false_sharing_bench_run() has returned.
+ */
+void false_sharing_bench_report(fs_bench_out_t out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FALSE_SHARING_BENCH_H_ */
@@ -0,0 +1,46 @@
+/*******************************************************************************
+ * @file fast_mem.c
+ *
+ * @brief Placement of latency critical code and data in on-chip L2 RAM.
+ *
+ * See "fast_mem.h" for details of how to use this module.
+ */
+
+#include <stdint.h>
+#include "fast_mem.h"
+
+/*------------------------------------------------------------------------------
+  Defined by fast_mem.ld.
+ */
+extern uint64_t __ram_text_load;
+extern uint64_t __ram_text_start;
+extern uint64_t __ram_text_end;
+extern uint64_t __lim_data_load;
+extern uint64_t __lim_data_start;
+extern uint64_t __lim_data_end;
+
+/*------------------------------------------------------------------------------
+  Word copy; both sections are 8 byte aligned and padded by fast_mem.ld.
+ */
+static void copy_section(const uint64_t * load, uint64_t * start,
+                         const uint64_t * end)
+{
+    while (start < end)
+    {
+        *start++ = *load++;
+    }
+}
+
+/***************************************************************************//**
+ * See "fast_mem.h" for details of how to use this function.
+ */
+void fast_mem_init(void)
+{
+    copy_section(&__ram_text_load, &__ram_text_start, &__ram_text_end);
+    copy_section(&__lim_data_load, &__lim_data_start, &__lim_data_end);
+
+    /* The code was written through the data side; drop any stale lines from
+       this hart's instruction cache. Other harts have not run yet. */
+    __asm volatile ("fence rw, rw" ::: "memory");
+    __asm volatile ("fence.i" ::: "memory");
+}
@@ -0,0 +1,51 @@
+/*******************************************************************************
+ * @file fast_mem.h
+ *
+ * @brief Placement of latency critical code and data in on-chip L2 RAM.
+ *
+ * Code and data linked into DDR or eNVM are only fast while they are in the
+ * L1/L2 caches. An interrupt handler that last ran a long time ago takes a
+ * miss to DDR for every line of code and data it touches. The L2 scratchpad
+ * (and the L2 LIM) is on-chip SRAM that is never evicted to DDR, so an L1
+ * miss on code or data placed there costs an L2 access at most, on every
+ * run.
+ *
+ *   RAM_TEXT    places a function in .ram_text.
+ *   LIM_DATA    places initialised or zeroed data in .lim_data.
+ *
+ *     uint8_t gpio0_bit0_or_gpio2_bit13_plic_0_IRQHandler(void) RAM_TEXT;
+ *
+ * fast_mem.ld links both sections to run from the scratchpad and load with
+ * the rest of the image. fast_mem_init() copies them into place. It must run
+ * on hart 0 before any other hart is released and before interrupts are
+ * enabled, as no RAM_TEXT function can be called until it has.
+ *
+ * Keep the set small: the scratchpad is carved out of the L2 cache ways
+ * (see LIBERO_SETTING_WAY_ENABLE / the scratchpad way mask), so every byte
+ * placed here is a byte less of L2 for everything else.
+ *
+ * isr_latency_bench.c measures the difference it makes.
+ */
+
+#ifndef FAST_MEM_H_
+#define FAST_MEM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RAM_TEXT                __attribute__((section(".ram_text"), noinline))
+
+#define LIM_DATA                __attribute__((section(".lim_data")))
+
+/***************************************************************************//**
+ * fast_mem_init() copies .ram_text and .lim_data from their load addresses
+ * to the scratchpad and makes the copied code visible to instruction fetch.
+ */
+void fast_mem_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FAST_MEM_H_ */
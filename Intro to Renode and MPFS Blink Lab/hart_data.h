@@ -0,0 +1,42 @@
+/*******************************************************************************
+ * @file hart_data.h
+ *
+ * @brief Cache line aware placement of data written by more than one hart.
+ *
+ * The MPFS L1 and L2 caches use 64 byte lines and keep them coherent between
+ * the U54s. Two harts writing different variables that share a line still
+ * take turns owning the whole line, so every write misses. Globals written
+ * by one hart and read or written by another must not share a line with
+ * another hart's hot data.
+ *
+ *   HART_BSS(n)       puts a zero initialised variable in hart n's section,
+ *                     .bss.hartn. hart_data.ld groups each hart's section and
+ *                     aligns both ends to a cache line, so one hart's hot data
+ *                     shares lines only with its own.
+ *   CACHE_ALIGNED     starts a variable on its own line, e.g. a barrier
+ *                     shared by all harts.
+ *   CACHE_LINE_PAD(n) pads a struct of n bytes out to a whole line, for arrays
+ *                     indexed by hart id.
+ *
+ *     volatile uint64_t count_sw_ints_h1 HART_BSS(1) = 0;
+ *     static uint64_t g_hal_mutex CACHE_ALIGNED;
+ *
+ * Variables in HART_BSS() sections are zeroed with the rest of .bss and must
+ * not have a non-zero initialiser.
+ *
+ * false_sharing_bench.c measures the cost of getting this wrong.
+ */
+
+#ifndef HART_DATA_H_
+#define HART_DATA_H_
+
+#define CACHE_LINE_SIZE         64u
+
+#define CACHE_ALIGNED           __attribute__((aligned(CACHE_LINE_SIZE)))
+
+#define HART_BSS(hart)          __attribute__((section(".bss.hart" #hart), \
+                                               aligned(8)))
+
+#define CACHE_LINE_PAD(used)    uint8_t pad[CACHE_LINE_SIZE - ((used) % CACHE_LINE_SIZE)]
+
+#endif /* HART_DATA_H_ */
@@ -0,0 +1,409 @@
+/*******************************************************************************
+ * @file ipi_bench.c
+ *
+ * @brief Latency of machine software interrupts between every pair of harts.
+ *
+ * See "ipi_bench.h" for details of how to use this module.
+ */
+
+#include "mpfs_hal/mss_hal.h"
+#include "ipi_bench.h"
+#include "hart_data.h"
+#include "mcycle.h"
+#include "fmt.h"
+
+#if BLINK_BENCHMARKS
+
+#define ROLE_NONE               0u
+#define ROLE_SENDER             1u
+#define ROLE_RECEIVER           2u
+
+#define MODE_WFI                0u
+#define MODE_BUSY               1u
+#define NUM_MODES               2u
+
+/* Cycles the sender waits after the receiver says it is ready, so that it
+   is in wfi or its loop by the time the interrupt arrives. */
+#define IPI_SETTLE_CYCLES       2000u
+
+static const char * const g_mode_names[NUM_MODES] = { "wfi", "busy" };
+
+/*------------------------------------------------------------------------------
+  Per hart, written by that hart and its handler, and read by its peer;
+  except ping, which the sender writes, and pong, which the receiver does.
+ */
+typedef struct ipi_hart
+{
+    volatile uint32_t role;
+    volatile uint32_t peer;
+    volatile uint32_t seen;         /* handler has run */
+    volatile uint32_t ready;        /* round the receiver is waiting in */
+    volatile uint32_t ping;         /* calibration */
+    volatile uint32_t pong;
+    volatile uint64_t t_irq;        /* mcycle when the interrupt arrived */
+    volatile uint64_t t_ping;       /* mcycle when the ping was seen */
+    CACHE_LINE_PAD(6u * sizeof(uint32_t) + 2u * sizeof(uint64_t));
+} ipi_hart_t;
+
+static ipi_hart_t g_ipi[IPI_BENCH_HARTS] CACHE_ALIGNED;
+
+/* Results, each row written by its sender. */
+static uint64_t g_round_trip[NUM_MODES][IPI_BENCH_HARTS][IPI_BENCH_HARTS];
+static int64_t g_one_way[NUM_MODES][IPI_BENCH_HARTS][IPI_BENCH_HARTS];
+static uint64_t g_calib_rtt[IPI_BENCH_HARTS][IPI_BENCH_HARTS];
+
+/* Sense reversing barrier, on a line of its own. */
+static struct
+{
+    uint32_t count;
+    uint32_t generation;
+} g_barrier CACHE_ALIGNED;
+
+static void barrier_wait(void)
+{
+    uint32_t generation = __atomic_load_n(&g_barrier.generation, __ATOMIC_ACQUIRE);
+
+    if (IPI_BENCH_HARTS == __atomic_add_fetch(&g_barrier.count, 1u, __ATOMIC_ACQ_REL))
+    {
+        __atomic_store_n(&g_barrier.count, 0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&g_barrier.generation, generation + 1u, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        while (generation == __atomic_load_n(&g_barrier.generation, __ATOMIC_ACQUIRE))
+        {
+            ;
+        }
+    }
+}
+
+/***************************************************************************//**
+ * See "ipi_bench.h" for details of how to use this function.
+ */
+void ipi_bench_irq(void)
+{
+    uint64_t now = mcycle_read();
+    uint64_t hartid = read_csr(mhartid);
+    ipi_hart_t * me;
+
+    if (hartid >= IPI_BENCH_HARTS)
+    {
+        return;
+    }
+    me = &g_ipi[hartid];
+    if (ROLE_NONE == me->role)
+    {
+        return;
+    }
+
+    clear_soft_interrupt();
+    me->t_irq = now;
+    if (ROLE_RECEIVER == me->role)
+    {
+        raise_soft_interrupt(me->peer);
+    }
+    __atomic_store_n(&me->seen, 1u, __ATOMIC_RELEASE);
+}
+
+/*------------------------------------------------------------------------------
+  Waits for this hart's software interrupt in the given mode and returns the
+  mcycle at which it arrived.
+ */
+static uint64_t wait_for_ipi(ipi_hart_t * me, uint32_t mode)
+{
+    volatile uint32_t busy = 0u;
+    uint64_t now;
+
+    if (MODE_WFI == mode)
+    {
+        do
+        {
+            __asm volatile ("wfi");
+        } while (0u == (read_csr(mip) & MIP_MSIP));
+        now = mcycle_read();
+        clear_soft_interrupt();
+        return now;
+    }
+
+    while (0u == __atomic_load_n(&me->seen, __ATOMIC_ACQUIRE))
+    {
+        busy++;
+    }
+    return me->t_irq;
+}
+
+/*------------------------------------------------------------------------------
+  Counter offset of receiver against sender: the receiver's reading of the
+  midpoint of the fastest ping-pong.
+ */
+static int64_t calibrate(uint64_t hartid, uint32_t sender, uint32_t receiver)
+{
+    ipi_hart_t * s = &g_ipi[sender];
+    ipi_hart_t * r = &g_ipi[receiver];
+    uint64_t best = UINT64_MAX;
+    int64_t offset = 0;
+    uint64_t t0;
+    uint64_t t1;
+    uint32_t round;
+
+    for (round = 1u; round <= IPI_BENCH_CALIB; round++)
+    {
+        if (hartid == sender)
+        {
+            t0 = mcycle_read();
+            __atomic_store_n(&r->ping, round, __ATOMIC_RELEASE);
+            while (round != __atomic_load_n(&s->pong, __ATOMIC_ACQUIRE))
+            {
+                ;
+            }
+            t1 = mcycle_read();
+            if ((t1 - t0) < best)
+            {
+                best = t1 - t0;
+                offset = (int64_t)(r->t_ping - (t0 + ((t1 - t0) / 2u)));
+            }
+        }
+        else
+        {
+            while (round != __atomic_load_n(&r->ping, __ATOMIC_ACQUIRE))
+            {
+                ;
+            }
+            r->t_ping = mcycle_read();
+            __atomic_store_n(&s->pong, round, __ATOMIC_RELEASE);
+        }
+    }
+
+    if (hartid == sender)
+    {
+        g_calib_rtt[sender][receiver] = best;
+    }
+    return offset;
+}
+
+static void measure(uint64_t hartid, uint32_t sender, uint32_t receiver,
+                    uint32_t mode, int64_t offset)
+{
+    ipi_hart_t * me = &g_ipi[hartid];
+    ipi_hart_t * r = &g_ipi[receiver];
+    uint64_t round_trip = 0u;
+    int64_t one_way = 0;
+    uint64_t start;
+    uint64_t t0;
+    uint64_t t1;
+    uint32_t round;
+
+    if (MODE_WFI == mode)
+    {
+        __disable_irq();
+    }
+    else
+    {
+        __enable_irq();
+    }
+
+    for (round = 1u; round <= IPI_BENCH_ROUNDS; round++)
+    {
+        if (hartid == receiver)
+        {
+            clear_soft_interrupt();
+            me->seen = 0u;
+            __atomic_store_n(&me->ready, round, __ATOMIC_RELEASE);
+            t1 = wait_for_ipi(me, mode);
+            if (MODE_WFI == mode)
+            {
+                me->t_irq = t1;
+                __atomic_thread_fence(__ATOMIC_SEQ_CST);
+                raise_soft_interrupt(sender);
+            }
+        }
+        else
+        {
+            while (round != __atomic_load_n(&r->ready, __ATOMIC_ACQUIRE))
+            {
+                ;
+            }
+            start = mcycle_read();
+            while ((mcycle_read() - start) < IPI_SETTLE_CYCLES)
+            {
+                ;
+            }
+
+            clear_soft_interrupt();
+            me->seen = 0u;
+            t0 = mcycle_read();
+            raise_soft_interrupt(receiver);
+            t1 = wait_for_ipi(me, mode);
+
+            round_trip += t1 - t0;
+            one_way += ((int64_t)r->t_irq - offset) - (int64_t)t0;
+        }
+    }
+
+    if (hartid == sender)
+    {
+        g_round_trip[mode][sender][receiver] = round_trip / IPI_BENCH_ROUNDS;
+        g_one_way[mode][sender][receiver] = one_way / (int64_t)IPI_BENCH_ROUNDS;
+    }
+}
+
+/***************************************************************************//**
+ * See "ipi_bench.h" for details of how to use this function.
+ */
+void ipi_bench_run(uint64_t hartid)
+{
+    ipi_hart_t * me;
+    uintptr_t mie_was;
+    uint32_t sender;
+    uint32_t receiver;
+    uint32_t mode;
+    int64_t offset = 0;
+
+    if (hartid >= IPI_BENCH_HARTS)
+    {
+        return;
+    }
+    me = &g_ipi[hartid];
+    mie_was = read_csr(mstatus) & MSTATUS_MIE;
+    set_csr(mie, MIP_MSIP);
+
+    for (sender = 0u; sender < IPI_BENCH_HARTS; sender++)
+    {
+        for (receiver = 0u; receiver < IPI_BENCH_HARTS; receiver++)
+        {
+            if (sender == receiver)
+            {
+                continue;
+            }
+
+            barrier_wait();
+            if ((hartid == sender) || (hartid == receiver))
+            {
+                me->role = (hartid == sender) ? ROLE_SENDER : ROLE_RECEIVER;
+                me->peer = (hartid == sender) ? receiver : sender;
+                offset = calibrate(hartid, sender, receiver);
+
+                for (mode = 0u; mode < NUM_MODES; mode++)
+                {
+                    measure(hartid, sender, receiver, mode, offset);
+                }
+
+                me->role = ROLE_NONE;
+                me->ping = 0u;
+                me->pong = 0u;
+                me->ready = 0u;
+            }
+            barrier_wait();
+        }
+    }
+
+    clear_soft_interrupt();
+    if (0u != mie_was)
+    {
+        __enable_irq();
+    }
+    else
+    {
+        __disable_irq();
+    }
+}
+
+/*------------------------------------------------------------------------------
+  One matrix, sender by row.
+ */
+static void report_matrix(ipi_bench_out_t out, const char * title,
+                          uint32_t mode, uint8_t one_way)
+{
+    char line[96];
+    char * p;
+    uint32_t sender;
+    uint32_t receiver;
+
+    p = line;
+    p = fmt_str(p, "  ");
+    p = fmt_str(p, title);
+    p = fmt_str(p, " from ");
+    p = fmt_str(p, g_mode_names[mode]);
+    p = fmt_str(p, "\r\n    to:     ");
+    for (receiver = 0u; receiver < IPI_BENCH_HARTS; receiver++)
+    {
+        p = fmt_str(p, "    hart ");
+        p = fmt_u32(p, receiver, 0u, ' ');
+    }
+    p = fmt_str(p, "\r\n");
+    *p = '\0';
+    out(line);
+
+    for (sender = 0u; sender < IPI_BENCH_HARTS; sender++)
+    {
+        p = line;
+        p = fmt_str(p, "    hart ");
+        p = fmt_u32(p, sender, 0u, ' ');
+        for (receiver = 0u; receiver < IPI_BENCH_HARTS; receiver++)
+        {
+            if (sender == receiver)
+            {
+                p = fmt_str(p, "         -");
+            }
+            else if (0u != one_way)
+            {
+                p = fmt_i32(p, (int32_t)g_one_way[mode][sender][receiver], 10u, ' ');
+            }
+            else
+            {
+                p = fmt_u64(p, g_round_trip[mode][sender][receiver], 10u, ' ');
+            }
+        }
+        p = fmt_str(p, "\r\n");
+        *p = '\0';
+        out(line);
+    }
+}
+
+/***************************************************************************//**
+ * See "ipi_bench.h" for details of how to use this function.
+ */
+void ipi_bench_report(ipi_bench_out_t out)
+{
+    char line[96];
+    char * p;
+    uint64_t worst = 0u;
+    uint32_t sender;
+    uint32_t receiver;
+    uint32_t mode;
+
+    for (sender = 0u; sender < IPI_BENCH_HARTS; sender++)
+    {
+        for (receiver = 0u; receiver < IPI_BENCH_HARTS; receiver++)
+        {
+            if ((sender != receiver) && (g_calib_rtt[sender][receiver] > worst))
+            {
+                worst = g_calib_rtt[sender][receiver];
+            }
+        }
+    }
+
+    p = line;
+    p = fmt_str(p, "\r\nsoftware interrupt latency, mean of ");
+    p = fmt_u32(p, IPI_BENCH_ROUNDS, 0u, ' ');
+    p = fmt_str(p, " (cycles, sender by row):\r\n");
+    *p = '\0';
+    out(line);
+
+    for (mode = 0u; mode < NUM_MODES; mode++)
+    {
+        report_matrix(out, "round trip", mode, 0u);
+        report_matrix(out, "one way", mode, 1u);
+    }
+
+    p = line;
+    p = fmt_str(p, "  polling a flag, round trip up to ");
+    p = fmt_u64(p, worst, 0u, ' ');
+    p = fmt_str(p, "; one way is +/- ");
+    p = fmt_u64(p, worst / 2u, 0u, ' ');
+    p = fmt_str(p, "\r\n");
+    *p = '\0';
+    out(line);
+}
+
+#endif /* BLINK_BENCHMARKS */
@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * @file ipi_bench.h
+ *
+ * @brief Latency of machine software interrupts between every pair of harts.
+ *
+ * For each ordered pair of harts, the sender raises the receiver's software
+ * interrupt (raise_soft_interrupt()) and the receiver raises the sender's in
+ * reply, IPI_BENCH_ROUNDS times, with both harts waiting in one of two
+ * states:
+ *
+ *   wfi    asleep in wfi with MIE clear; the hart wakes on MIP_MSIP and
+ *          carries on after the wfi, as workq.h workers do. This is the
+ *          cost of a doorbell to an idle hart.
+ *   busy   running a loop with MIE set; the interrupt is taken through the
+ *          HAL trap handler and the reply raised from Software_hN_IRQHandler().
+ *          This is the cost of a doorbell to a hart that is doing something
+ *          else.
+ *
+ * The round trip is measured on the sender's mcycle. The harts' mcycle
+ * counters run at the same rate but were not started together, so for the
+ * one-way time each pair first estimates the offset between their counters
+ * with a ping-pong through shared memory, taking the fastest of
+ * IPI_BENCH_CALIB exchanges. One-way times are good to within half of that
+ * exchange, which the report gives.
+ *
+ * Both are reported as 5 x 5 matrices of mean cycles, sender by row and
+ * receiver by column. Compare them with the cost of polling a flag, about
+ * the calibration exchange, to choose between doorbells and polling.
+ *
+ * Call ipi_bench_run() from each of harts 0 .. IPI_BENCH_HARTS - 1, then
+ * ipi_bench_report() from one of them. Each hart's software interrupt
+ * handler must call ipi_bench_irq() before anything slow.
+ */
+
+#ifndef IPI_BENCH_H_
+#define IPI_BENCH_H_
+
+#include <stdint.h>
+#include "bench_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Harts 0 to IPI_BENCH_HARTS - 1 must all call ipi_bench_run(). */
+#define IPI_BENCH_HARTS         5u
+
+#define IPI_BENCH_ROUNDS        16u
+#define IPI_BENCH_CALIB         8u
+
+/*------------------------------------------------------------------------------
+  Called once per line of results, e.g. uart0_tx_string().
+ */
+typedef void (*ipi_bench_out_t)(const char * line);
+
+/***************************************************************************//**
+ * ipi_bench_irq() must be called early from every hart's software interrupt
+ * handler, e.g. Software_h1_IRQHandler(). It does nothing unless the calling
+ * hart is taking part in a measurement.
+ */
+void ipi_bench_irq(void);
+
+/***************************************************************************//**
+ * ipi_bench_run() takes part in every pair's measurements on the calling
+ * hart and returns once all pairs are done. It leaves MIE as it found it and
+ * MIP_MSIP enabled in mie. Harts with an id of IPI_BENCH_HARTS or above
+ * return straight away.
+ */
+void ipi_bench_run(uint64_t hartid);
+
+/***************************************************************************//**
+ * ipi_bench_report() prints the round trip and one-way matrices for both
+ * states. Call it after ipi_bench_run() has returned.
+ */
+void ipi_bench_report(ipi_bench_out_t out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IPI_BENCH_H_ */
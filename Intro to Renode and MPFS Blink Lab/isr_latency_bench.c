@@ -0,0 +1,213 @@
+/*******************************************************************************
+ * @file isr_latency_bench.c
+ *
+ * @brief Worst case interrupt latency of a handler in DDR against one in the
+ *        L2 scratchpad.
+ *
+ * See "isr_latency_bench.h" for details of how to use this module.
+ */
+
+#include "mpfs_hal/mss_hal.h"
+#include "isr_latency_bench.h"
+#include "fast_mem.h"
+#include "fmt.h"
+
+#if BLINK_BENCHMARKS
+
+/* L2 cache controller Flush64 register: writing an address writes back and
+   evicts the line that holds it. */
+#define L2_FLUSH64              (*(volatile uint64_t *)0x02010200UL)
+#define L2_LINE_SIZE            64u
+
+/* Bytes of handler code flushed from L2, from the function's address. */
+#define ISR_CODE_SPAN           256u
+
+#define ISR_QUEUE_LEN           16u
+
+#define VARIANT_CACHED          0u
+#define VARIANT_FAST            1u
+#define NUM_VARIANTS            2u
+
+typedef struct isr_bench_stats
+{
+    uint32_t worst_latency;
+    uint32_t worst_duration;
+    uint64_t total_latency;
+    uint64_t total_duration;
+} isr_bench_stats_t;
+
+static inline uint32_t bench_cycles(void)
+{
+    unsigned long cycles;
+
+    __asm volatile ("csrr %0, mcycle" : "=r"(cycles));
+    return (uint32_t)cycles;
+}
+
+/*------------------------------------------------------------------------------
+  The two handlers. Same code, same work: take a timestamp, push it to a
+  small queue as a driver would push a received byte.
+ */
+static void (* volatile g_hook)(void);
+static volatile uint32_t g_entry;
+static volatile uint32_t g_exit;
+static volatile uint32_t g_fired;
+
+static uint32_t g_queue_cached[ISR_QUEUE_LEN];
+static uint32_t g_head_cached;
+
+static uint32_t g_queue_fast[ISR_QUEUE_LEN] LIM_DATA;
+static uint32_t g_head_fast LIM_DATA;
+
+static void __attribute__((noinline)) handler_cached(void)
+{
+    uint32_t now = bench_cycles();
+
+    g_entry = now;
+    g_queue_cached[g_head_cached % ISR_QUEUE_LEN] = now;
+    g_head_cached++;
+    g_exit = bench_cycles();
+    g_fired = 1u;
+}
+
+static void RAM_TEXT handler_fast(void)
+{
+    uint32_t now = bench_cycles();
+
+    g_entry = now;
+    g_queue_fast[g_head_fast % ISR_QUEUE_LEN] = now;
+    g_head_fast++;
+    g_exit = bench_cycles();
+    g_fired = 1u;
+}
+
+static isr_bench_stats_t g_stats[NUM_VARIANTS];
+
+/*------------------------------------------------------------------------------
+  Flush the L1 data cache (SiFive CFLUSH.D.L1 with rs1 = x0) and the
+  instruction cache (FENCE.I).
+ */
+static inline void flush_l1(void)
+{
+    __asm volatile (".word 0xFC000073" ::: "memory");
+    __asm volatile ("fence.i" ::: "memory");
+}
+
+static void flush_l2_range(const void * start, uint32_t len)
+{
+    uintptr_t addr = (uintptr_t)start & ~((uintptr_t)L2_LINE_SIZE - 1u);
+    uintptr_t end = (uintptr_t)start + len;
+
+    for (; addr < end; addr += L2_LINE_SIZE)
+    {
+        L2_FLUSH64 = addr;
+    }
+    __asm volatile ("fence rw, rw" ::: "memory");
+}
+
+/***************************************************************************//**
+ * See "isr_latency_bench.h" for details of how to use this function.
+ */
+void isr_latency_bench_irq(void)
+{
+    void (*hook)(void) = g_hook;
+
+    if (0 != hook)
+    {
+        hook();
+    }
+}
+
+static void run_variant(uint32_t variant)
+{
+    isr_bench_stats_t * stats = &g_stats[variant];
+    uint32_t run;
+    uint32_t start;
+    uint32_t latency;
+    uint32_t duration;
+
+    g_hook = (VARIANT_FAST == variant) ? handler_fast : handler_cached;
+
+    for (run = 0u; run < ISR_BENCH_RUNS; run++)
+    {
+        if (VARIANT_CACHED == variant)
+        {
+            flush_l2_range((const void *)handler_cached, ISR_CODE_SPAN);
+            flush_l2_range(g_queue_cached, sizeof(g_queue_cached));
+            flush_l2_range(&g_head_cached, sizeof(g_head_cached));
+        }
+        flush_l1();
+
+        g_fired = 0u;
+        start = bench_cycles();
+        raise_soft_interrupt((uint32_t)read_csr(mhartid));
+        while (0u == g_fired)
+        {
+            ;
+        }
+
+        latency = g_entry - start;
+        duration = g_exit - g_entry;
+
+        if (latency > stats->worst_latency)
+        {
+            stats->worst_latency = latency;
+        }
+        if (duration > stats->worst_duration)
+        {
+            stats->worst_duration = duration;
+        }
+        stats->total_latency += latency;
+        stats->total_duration += duration;
+    }
+
+    g_hook = 0;
+}
+
+/***************************************************************************//**
+ * See "isr_latency_bench.h" for details of how to use this function.
+ */
+void isr_latency_bench_run(void)
+{
+    run_variant(VARIANT_CACHED);
+    run_variant(VARIANT_FAST);
+}
+
+/***************************************************************************//**
+ * See "isr_latency_bench.h" for details of how to use this function.
+ */
+void isr_latency_bench_report(isr_bench_out_t out)
+{
+    static const char * const names[NUM_VARIANTS] = { "DDR/.text  ", "scratchpad " };
+    char line[96];
+    char * p;
+    uint32_t variant;
+
+    p = line;
+    p = fmt_str(p, "\r\nsoftware IRQ, cold caches, ");
+    p = fmt_u32(p, ISR_BENCH_RUNS, 0u, ' ');
+    p = fmt_str(p, " runs (cycles):\r\n");
+    *p = '\0';
+    out(line);
+
+    for (variant = 0u; variant < NUM_VARIANTS; variant++)
+    {
+        p = line;
+        p = fmt_str(p, "  ");
+        p = fmt_str(p, names[variant]);
+        p = fmt_str(p, " latency worst=");
+        p = fmt_u32(p, g_stats[variant].worst_latency, 6u, ' ');
+        p = fmt_str(p, " mean=");
+        p = fmt_u32(p, (uint32_t)(g_stats[variant].total_latency / ISR_BENCH_RUNS), 6u, ' ');
+        p = fmt_str(p, "  handler worst=");
+        p = fmt_u32(p, g_stats[variant].worst_duration, 5u, ' ');
+        p = fmt_str(p, " mean=");
+        p = fmt_u32(p, (uint32_t)(g_stats[variant].total_duration / ISR_BENCH_RUNS), 5u, ' ');
+        p = fmt_str(p, "\r\n");
+        *p = '\0';
+
+        out(line);
+    }
+}
+
+#endif /* BLINK_BENCHMARKS */
@@ -0,0 +1,59 @@
+/*******************************************************************************
+ * @file isr_latency_bench.h
+ *
+ * @brief Worst case interrupt latency of a handler in DDR against one in the
+ *        L2 scratchpad.
+ *
+ * The calling hart raises its own software interrupt ISR_BENCH_RUNS times for
+ * each of two identical handlers: one linked normally, in .text with its
+ * queue in .bss, and one in RAM_TEXT with its queue in LIM_DATA (fast_mem.h).
+ * Before every run the L1 caches are flushed and the normal handler's code
+ * and data lines are flushed from L2 as well, which is the state a handler
+ * is in after the application has run through a few MB of other data. The
+ * scratchpad copy cannot be evicted from L2, so it is only flushed from L1.
+ *
+ * Latency is measured from the write that raises the interrupt to the
+ * handler's first instruction; the handler's own run time is reported too.
+ */
+
+#ifndef ISR_LATENCY_BENCH_H_
+#define ISR_LATENCY_BENCH_H_
+
+#include <stdint.h>
+#include "bench_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ISR_BENCH_RUNS          64u
+
+/*------------------------------------------------------------------------------
+  Called once per line of results, e.g. uart0_tx_string().
+ */
+typedef void (*isr_bench_out_t)(const char * line);
+
+/***************************************************************************//**
+ * isr_latency_bench_irq() must be called first thing from the calling hart's
+ * software interrupt handler, e.g. Software_h1_IRQHandler(). It does nothing
+ * unless the benchmark is running.
+ */
+void isr_latency_bench_irq(void);
+
+/***************************************************************************//**
+ * isr_latency_bench_run() runs both variants on the calling hart. The hart's
+ * software interrupt must be enabled (MIP_MSIP in mie) and fast_mem_init()
+ * must have run.
+ */
+void isr_latency_bench_run(void);
+
+/***************************************************************************//**
+ * isr_latency_bench_report() prints worst and mean cycles for both variants.
+ */
+void isr_latency_bench_report(isr_bench_out_t out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ISR_LATENCY_BENCH_H_ */
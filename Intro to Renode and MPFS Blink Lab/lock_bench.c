@@ -0,0 +1,234 @@
+/*******************************************************************************
+ * @file lock_bench.c
+ *
+ * @brief Contention between all five harts for the HAL mutex, a ticket lock
+ *        and an MCS lock (spinlock.h).
+ *
+ * See "lock_bench.h" for details of how to use this module.
+ */
+
+#include "mpfs_hal/mss_hal.h"
+#include "lock_bench.h"
+#include "spinlock.h"
+#include "hart_data.h"
+#include "mcycle.h"
+#include "fmt.h"
+
+#if BLINK_BENCHMARKS
+
+#define LOCK_HAL                0u
+#define LOCK_TICKET             1u
+#define LOCK_MCS                2u
+#define NUM_LOCKS               3u
+
+static const char * const g_lock_names[NUM_LOCKS] =
+{
+    "mss mutex", "ticket", "mcs"
+};
+
+/* The locks under test, each on its own line(s). */
+static uint64_t g_hal_mutex CACHE_ALIGNED;
+static ticket_lock_t g_ticket = TICKET_LOCK_INIT("bench ticket");
+static mcs_lock_t g_mcs = MCS_LOCK_INIT("bench mcs");
+static mcs_node_t g_mcs_nodes[LOCK_BENCH_HARTS];
+
+static lock_stats_t * const g_lock_stats[] = { &g_ticket.stats, &g_mcs.stats };
+
+/* Written only with the lock held. */
+static volatile uint32_t g_counter[NUM_LOCKS] CACHE_ALIGNED;
+
+typedef struct lock_result
+{
+    uint64_t cycles[NUM_LOCKS];
+    uint32_t max_wait[NUM_LOCKS];
+    CACHE_LINE_PAD(NUM_LOCKS * (sizeof(uint64_t) + sizeof(uint32_t)));
+} lock_result_t;
+
+static lock_result_t g_results[LOCK_BENCH_HARTS] CACHE_ALIGNED;
+
+/* Sense reversing barrier, on a line of its own. */
+static struct
+{
+    uint32_t count;
+    uint32_t generation;
+} g_barrier CACHE_ALIGNED;
+
+static void barrier_wait(void)
+{
+    uint32_t generation = __atomic_load_n(&g_barrier.generation, __ATOMIC_ACQUIRE);
+
+    if (LOCK_BENCH_HARTS == __atomic_add_fetch(&g_barrier.count, 1u, __ATOMIC_ACQ_REL))
+    {
+        __atomic_store_n(&g_barrier.count, 0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&g_barrier.generation, generation + 1u, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        while (generation == __atomic_load_n(&g_barrier.generation, __ATOMIC_ACQUIRE))
+        {
+            ;
+        }
+    }
+}
+
+static void acquire(uint32_t lock, uint64_t hartid)
+{
+    switch (lock)
+    {
+    case LOCK_HAL:
+        mss_take_mutex((uint64_t)&g_hal_mutex);
+        break;
+
+    case LOCK_TICKET:
+        ticket_lock_acquire(&g_ticket);
+        break;
+
+    default:
+        mcs_lock_acquire(&g_mcs, &g_mcs_nodes[hartid]);
+        break;
+    }
+}
+
+static void release(uint32_t lock, uint64_t hartid)
+{
+    switch (lock)
+    {
+    case LOCK_HAL:
+        mss_release_mutex((uint64_t)&g_hal_mutex);
+        break;
+
+    case LOCK_TICKET:
+        ticket_lock_release(&g_ticket);
+        break;
+
+    default:
+        mcs_lock_release(&g_mcs, &g_mcs_nodes[hartid]);
+        break;
+    }
+}
+
+/***************************************************************************//**
+ * See "lock_bench.h" for details of how to use this function.
+ */
+void lock_bench_run(uint64_t hartid)
+{
+    lock_result_t * result;
+    volatile uint32_t think;
+    uint64_t start;
+    uint64_t before;
+    uint32_t wait;
+    uint32_t lock;
+    uint32_t idx;
+
+    if (hartid >= LOCK_BENCH_HARTS)
+    {
+        return;
+    }
+    result = &g_results[hartid];
+
+    if (0u == hartid)
+    {
+        mss_init_mutex((uint64_t)&g_hal_mutex);
+    }
+
+    for (lock = 0u; lock < NUM_LOCKS; lock++)
+    {
+        result->max_wait[lock] = 0u;
+        barrier_wait();
+
+        start = mcycle_read();
+        for (idx = 0u; idx < LOCK_BENCH_ITERATIONS; idx++)
+        {
+            before = mcycle_read();
+            acquire(lock, hartid);
+            wait = (uint32_t)(mcycle_read() - before);
+            g_counter[lock]++;
+            release(lock, hartid);
+
+            if (wait > result->max_wait[lock])
+            {
+                result->max_wait[lock] = wait;
+            }
+            for (think = 0u; think < LOCK_BENCH_THINK; think++)
+            {
+                ;
+            }
+        }
+        result->cycles[lock] = mcycle_read() - start;
+    }
+
+    barrier_wait();
+}
+
+/***************************************************************************//**
+ * See "lock_bench.h" for details of how to use this function.
+ */
+void lock_bench_report(lock_bench_out_t out)
+{
+    char line[96];
+    char * p;
+    const lock_result_t * result;
+    uint64_t fastest;
+    uint64_t slowest;
+    uint32_t max_wait;
+    uint32_t lock;
+    uint32_t hart;
+    uint32_t len;
+
+    p = line;
+    p = fmt_str(p, "\r\nlock contention, ");
+    p = fmt_u32(p, LOCK_BENCH_HARTS, 0u, ' ');
+    p = fmt_str(p, " harts x ");
+    p = fmt_u32(p, LOCK_BENCH_ITERATIONS, 0u, ' ');
+    p = fmt_str(p, " acquisitions (cycles):\r\n");
+    *p = '\0';
+    out(line);
+    out("  lock          fastest hart  slowest hart     max wait\r\n");
+
+    for (lock = 0u; lock < NUM_LOCKS; lock++)
+    {
+        fastest = UINT64_MAX;
+        slowest = 0u;
+        max_wait = 0u;
+        for (hart = 0u; hart < LOCK_BENCH_HARTS; hart++)
+        {
+            result = &g_results[hart];
+            if (result->cycles[lock] < fastest)
+            {
+                fastest = result->cycles[lock];
+            }
+            if (result->cycles[lock] > slowest)
+            {
+                slowest = result->cycles[lock];
+            }
+            if (result->max_wait[lock] > max_wait)
+            {
+                max_wait = result->max_wait[lock];
+            }
+        }
+
+        p = line;
+        p = fmt_str(p, "  ");
+        p = fmt_str(p, g_lock_names[lock]);
+        for (len = 0u; '\0' != g_lock_names[lock][len]; len++)
+        {
+            ;
+        }
+        for (; len < 12u; len++)
+        {
+            p = fmt_char(p, ' ');
+        }
+        p = fmt_u64(p, fastest, 14u, ' ');
+        p = fmt_u64(p, slowest, 14u, ' ');
+        p = fmt_u32(p, max_wait, 13u, ' ');
+        p = fmt_str(p, ((LOCK_BENCH_HARTS * LOCK_BENCH_ITERATIONS) == g_counter[lock])
+                       ? "  ok\r\n" : "  LOST UPDATES\r\n");
+        *p = '\0';
+
+        out(line);
+    }
+
+    lock_stats_report(g_lock_stats, sizeof(g_lock_stats) / sizeof(g_lock_stats[0]), out);
+}
+
+#endif /* BLINK_BENCHMARKS */
@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * @file lock_bench.h
+ *
+ * @brief Contention between all five harts for the HAL mutex, a ticket lock
+ *        and an MCS lock (spinlock.h).
+ *
+ * Every hart takes the lock under test LOCK_BENCH_ITERATIONS times, adds one
+ * to a shared counter while it holds it, and spends LOCK_BENCH_THINK loop
+ * iterations outside it before trying again, so the lock is nearly always
+ * wanted by several harts at once. The harts start each lock together at a
+ * barrier.
+ *
+ * For each lock the report gives the fastest and slowest hart's total time,
+ * whose ratio shows how fair the lock is, the longest single wait seen by
+ * any hart, and whether the counter came out right. The ticket and MCS
+ * locks' own counts (lock_stats_report()) follow.
+ *
+ * Call lock_bench_run() from each of harts 0 .. LOCK_BENCH_HARTS - 1, then
+ * lock_bench_report() from one of them.
+ */
+
+#ifndef LOCK_BENCH_H_
+#define LOCK_BENCH_H_
+
+#include <stdint.h>
+#include "bench_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Harts 0 to LOCK_BENCH_HARTS - 1 must all call lock_bench_run(). */
+#define LOCK_BENCH_HARTS        5u
+
+#define LOCK_BENCH_ITERATIONS   2000u
+#define LOCK_BENCH_THINK        50u
+
+/*------------------------------------------------------------------------------
+  Called once per line of results, e.g. uart0_tx_string().
+ */
+typedef void (*lock_bench_out_t)(const char * line);
+
+/***************************************************************************//**
+ * lock_bench_run() runs every lock on the calling hart and returns once all
+ * harts have finished. Harts with an id of LOCK_BENCH_HARTS or above return
+ * straight away.
+ */
+void lock_bench_run(uint64_t hartid);
+
+/***************************************************************************//**
+ * lock_bench_report() prints the results. Call it after lock_bench_run() has
+ * returned.
+ */
+void lock_bench_report(lock_bench_out_t out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOCK_BENCH_H_ */
@@ -0,0 +1,467 @@
+/*******************************************************************************
+ * @file mem_bench.c
+ *
+ * @brief Bandwidth and latency of each memory region, from each hart.
+ *
+ * See "mem_bench.h" for details of how to use this module.
+ */
+
+#include "mpfs_hal/mss_hal.h"
+#include "mem_bench.h"
+#include "hart_data.h"
+#include "mcycle.h"
+#include "fmt.h"
+
+#if BLINK_BENCHMARKS
+
+#define KERNEL_COPY             0u
+#define KERNEL_SCALE            1u
+#define KERNEL_ADD              2u
+#define KERNEL_TRIAD            3u
+#define NUM_KERNELS             4u
+
+#define PASS_ALONE              0u
+#define PASS_ALL_HARTS          1u
+#define NUM_PASSES              2u
+
+/* Best of this many runs of each test. */
+#define MEM_BENCH_REPS          3u
+
+/* Each kernel run moves at least this much, so small working sets are
+   timed over many sweeps. */
+#define MEM_BENCH_MIN_BYTES     (1024u * 1024u)
+
+#define MEM_BENCH_CHASE_STEPS   65536u
+#define MEM_LINE_SIZE           64u
+
+#define MEM_CLK_MHZ             (LIBERO_SETTING_MSS_COREPLEX_CPU_CLK / 1000000u)
+
+typedef struct mem_region
+{
+    const char * name;
+    void * base;
+    uint32_t size;
+} mem_region_t;
+
+static uint64_t g_ddr[MEM_BENCH_DDR_SIZE / sizeof(uint64_t)] CACHE_ALIGNED;
+
+static const mem_region_t g_regions[] =
+{
+    { "ddr", g_ddr, MEM_BENCH_DDR_SIZE },
+    { "lim", (void *)MEM_BENCH_LIM_BASE, MEM_BENCH_LIM_SIZE },
+    { "scratchpad", (void *)MEM_BENCH_SCRATCH_BASE, MEM_BENCH_SCRATCH_SIZE },
+};
+
+#define NUM_REGIONS             (sizeof(g_regions) / sizeof(g_regions[0]))
+
+static const uint32_t g_working_sets[] =
+{
+    4u * 1024u, 16u * 1024u, 64u * 1024u, 256u * 1024u,
+    1024u * 1024u, 4u * 1024u * 1024u
+};
+
+#define NUM_WORKING_SETS        (sizeof(g_working_sets) / sizeof(g_working_sets[0]))
+
+/* Arrays each kernel reads and writes. */
+static const uint32_t g_kernel_arrays[NUM_KERNELS] = { 2u, 2u, 3u, 3u };
+
+typedef struct mem_result
+{
+    uint32_t mbps[NUM_KERNELS];     /* 0 where the test did not run */
+    uint32_t chase_q8;              /* cycles per load, scaled by 256 */
+} mem_result_t;
+
+static mem_result_t g_results[NUM_PASSES][MEM_BENCH_HARTS][NUM_REGIONS][NUM_WORKING_SETS];
+
+/* Sense reversing barrier, on a line of its own. */
+static struct
+{
+    uint32_t count;
+    uint32_t generation;
+} g_barrier CACHE_ALIGNED;
+
+static void barrier_wait(void)
+{
+    uint32_t generation = __atomic_load_n(&g_barrier.generation, __ATOMIC_ACQUIRE);
+
+    if (MEM_BENCH_HARTS == __atomic_add_fetch(&g_barrier.count, 1u, __ATOMIC_ACQ_REL))
+    {
+        __atomic_store_n(&g_barrier.count, 0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&g_barrier.generation, generation + 1u, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        while (generation == __atomic_load_n(&g_barrier.generation, __ATOMIC_ACQUIRE))
+        {
+            ;
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------
+  The STREAM kernels over n words.
+ */
+static void run_kernel(uint32_t kernel, uint64_t * a, uint64_t * b,
+                       uint64_t * c, uint32_t n)
+{
+    const uint64_t scalar = 3u;
+    uint32_t idx;
+
+    switch (kernel)
+    {
+    case KERNEL_COPY:
+        for (idx = 0u; idx < n; idx++)
+        {
+            c[idx] = a[idx];
+        }
+        break;
+
+    case KERNEL_SCALE:
+        for (idx = 0u; idx < n; idx++)
+        {
+            b[idx] = scalar * c[idx];
+        }
+        break;
+
+    case KERNEL_ADD:
+        for (idx = 0u; idx < n; idx++)
+        {
+            c[idx] = a[idx] + b[idx];
+        }
+        break;
+
+    default:
+        for (idx = 0u; idx < n; idx++)
+        {
+            a[idx] = b[idx] + (scalar * c[idx]);
+        }
+        break;
+    }
+}
+
+static void stream(uint8_t * base, uint32_t working_set, mem_result_t * result)
+{
+    uint32_t n = working_set / (3u * sizeof(uint64_t));
+    uint64_t * a = (uint64_t *)base;
+    uint64_t * b = a + n;
+    uint64_t * c = b + n;
+    uint32_t sweeps = MEM_BENCH_MIN_BYTES / working_set;
+    uint32_t kernel;
+    uint32_t rep;
+    uint32_t sweep;
+    uint32_t idx;
+    uint64_t best;
+    uint64_t start;
+    uint64_t cycles;
+    uint64_t bytes;
+
+    if (0u == sweeps)
+    {
+        sweeps = 1u;
+    }
+    for (idx = 0u; idx < n; idx++)
+    {
+        a[idx] = 1u;
+        b[idx] = 2u;
+        c[idx] = 0u;
+    }
+
+    for (kernel = 0u; kernel < NUM_KERNELS; kernel++)
+    {
+        best = UINT64_MAX;
+        for (rep = 0u; rep < MEM_BENCH_REPS; rep++)
+        {
+            start = mcycle_read();
+            for (sweep = 0u; sweep < sweeps; sweep++)
+            {
+                run_kernel(kernel, a, b, c, n);
+            }
+            cycles = mcycle_read() - start;
+            if (cycles < best)
+            {
+                best = cycles;
+            }
+        }
+
+        bytes = (uint64_t)g_kernel_arrays[kernel] * n * sizeof(uint64_t) * sweeps;
+        result->mbps[kernel] = (uint32_t)((bytes * MEM_CLK_MHZ) / ((0u != best) ? best : 1u));
+    }
+}
+
+/*------------------------------------------------------------------------------
+  Links the first word of every line into one cycle in random order
+  (Sattolo's shuffle), then follows it.
+ */
+static void chase(uint8_t * base, uint32_t working_set, uint32_t seed,
+                  mem_result_t * result)
+{
+    uint32_t lines = working_set / MEM_LINE_SIZE;
+    uint64_t state = seed;
+    uintptr_t * node;
+    uintptr_t * p;
+    uintptr_t tmp;
+    uint64_t best = UINT64_MAX;
+    uint64_t start;
+    uint64_t cycles;
+    uint32_t idx;
+    uint32_t other;
+    uint32_t rep;
+    uint32_t step;
+
+    for (idx = 0u; idx < lines; idx++)
+    {
+        *(uintptr_t *)(base + (idx * MEM_LINE_SIZE)) = idx;
+    }
+    for (idx = lines - 1u; idx > 0u; idx--)
+    {
+        state = (state * 6364136223846793005ull) + 1442695040888963407ull;
+        other = (uint32_t)((state >> 33) % idx);
+        node = (uintptr_t *)(base + (idx * MEM_LINE_SIZE));
+        p = (uintptr_t *)(base + (other * MEM_LINE_SIZE));
+        tmp = *node;
+        *node = *p;
+        *p = tmp;
+    }
+    for (idx = 0u; idx < lines; idx++)
+    {
+        node = (uintptr_t *)(base + (idx * MEM_LINE_SIZE));
+        *node = (uintptr_t)(base + (*node * MEM_LINE_SIZE));
+    }
+
+    for (rep = 0u; rep < MEM_BENCH_REPS; rep++)
+    {
+        p = (uintptr_t *)base;
+        start = mcycle_read();
+        for (step = 0u; step < MEM_BENCH_CHASE_STEPS; step++)
+        {
+            p = (uintptr_t *)*p;
+        }
+        cycles = mcycle_read() - start;
+        if (cycles < best)
+        {
+            best = cycles;
+        }
+    }
+
+    /* Keep the chain live. */
+    __asm volatile ("" :: "r"(p));
+    result->chase_q8 = (uint32_t)((best << 8) / MEM_BENCH_CHASE_STEPS);
+}
+
+static void run_tests(uint64_t hartid, uint32_t pass, uint32_t region,
+                      uint32_t ws)
+{
+    const mem_region_t * r = &g_regions[region];
+    uint32_t working_set = g_working_sets[ws];
+    uint8_t * base = (uint8_t *)r->base;
+    mem_result_t * result = &g_results[pass][hartid][region][ws];
+
+    if (PASS_ALL_HARTS == pass)
+    {
+        base += hartid * working_set;
+    }
+
+    stream(base, working_set, result);
+    if (PASS_ALL_HARTS == pass)
+    {
+        /* Start the chases together too. */
+        barrier_wait();
+    }
+    chase(base, working_set, (uint32_t)hartid + 1u, result);
+}
+
+static uint8_t fits(uint32_t pass, uint32_t region, uint32_t ws)
+{
+    uint32_t needed = g_working_sets[ws];
+
+    if (PASS_ALL_HARTS == pass)
+    {
+        needed *= MEM_BENCH_HARTS;
+    }
+    return (needed <= g_regions[region].size) ? 1u : 0u;
+}
+
+/***************************************************************************//**
+ * See "mem_bench.h" for details of how to use this function.
+ */
+void mem_bench_run(uint64_t hartid)
+{
+    uint32_t hart;
+    uint32_t region;
+    uint32_t ws;
+
+    if (hartid >= MEM_BENCH_HARTS)
+    {
+        return;
+    }
+
+    /* One hart at a time. */
+    for (hart = 0u; hart < MEM_BENCH_HARTS; hart++)
+    {
+        barrier_wait();
+        if (hart == hartid)
+        {
+            for (region = 0u; region < NUM_REGIONS; region++)
+            {
+                for (ws = 0u; ws < NUM_WORKING_SETS; ws++)
+                {
+                    if (0u != fits(PASS_ALONE, region, ws))
+                    {
+                        run_tests(hartid, PASS_ALONE, region, ws);
+                    }
+                }
+            }
+        }
+    }
+
+#if MEM_BENCH_ALL_HARTS
+    /* All at once, each on its own part of the region. */
+    for (region = 0u; region < NUM_REGIONS; region++)
+    {
+        for (ws = 0u; ws < NUM_WORKING_SETS; ws++)
+        {
+            if (0u != fits(PASS_ALL_HARTS, region, ws))
+            {
+                barrier_wait();
+                run_tests(hartid, PASS_ALL_HARTS, region, ws);
+            }
+        }
+    }
+#endif
+
+    barrier_wait();
+}
+
+/*------------------------------------------------------------------------------
+  Where a ddr working set of this size is served from.
+ */
+static const char * level_of(uint32_t region, uint32_t working_set)
+{
+    if (0u != region)
+    {
+        return "";
+    }
+    if (working_set <= MEM_BENCH_L1_SIZE)
+    {
+        return " (l1)";
+    }
+    return (working_set <= MEM_BENCH_L2_SIZE) ? " (l2)" : " (ddr)";
+}
+
+/*------------------------------------------------------------------------------
+  One table; for the all harts pass, bandwidth is the harts' total and the
+  chase their mean.
+ */
+static void report_pass(mem_bench_out_t out, uint32_t pass, uint32_t hart)
+{
+    char line[112];
+    char * p;
+    const char * label;
+    const mem_result_t * result;
+    uint32_t harts = (PASS_ALL_HARTS == pass) ? MEM_BENCH_HARTS : 1u;
+    uint32_t first = (PASS_ALL_HARTS == pass) ? 0u : hart;
+    uint32_t region;
+    uint32_t ws;
+    uint32_t kernel;
+    uint32_t idx;
+    uint32_t len;
+    uint32_t mbps;
+    uint32_t chase_q8;
+
+    p = line;
+    if (PASS_ALL_HARTS == pass)
+    {
+        p = fmt_str(p, "\r\n  all harts at once (total MB/s, mean cycles per load):\r\n");
+    }
+    else
+    {
+        p = fmt_str(p, "\r\n  hart ");
+        p = fmt_u32(p, hart, 0u, ' ');
+        p = fmt_str(p, " alone (MB/s, cycles per load):\r\n");
+    }
+    *p = '\0';
+    out(line);
+    out("    region           size     copy    scale      add    triad    chase\r\n");
+
+    for (region = 0u; region < NUM_REGIONS; region++)
+    {
+        for (ws = 0u; ws < NUM_WORKING_SETS; ws++)
+        {
+            if (0u == fits(pass, region, ws))
+            {
+                continue;
+            }
+
+            p = line;
+            p = fmt_str(p, "    ");
+            p = fmt_str(p, g_regions[region].name);
+            label = level_of(region, g_working_sets[ws]);
+            p = fmt_str(p, label);
+            for (len = 0u; '\0' != g_regions[region].name[len]; len++)
+            {
+                ;
+            }
+            for (idx = 0u; '\0' != label[idx]; idx++)
+            {
+                len++;
+            }
+            for (; len < 12u; len++)
+            {
+                p = fmt_char(p, ' ');
+            }
+            p = fmt_u32(p, g_working_sets[ws] / 1024u, 8u, ' ');
+            p = fmt_char(p, 'K');
+
+            for (kernel = 0u; kernel < NUM_KERNELS; kernel++)
+            {
+                mbps = 0u;
+                for (idx = first; idx < (first + harts); idx++)
+                {
+                    result = &g_results[pass][idx][region][ws];
+                    mbps += result->mbps[kernel];
+                }
+                p = fmt_u32(p, mbps, 9u, ' ');
+            }
+
+            chase_q8 = 0u;
+            for (idx = first; idx < (first + harts); idx++)
+            {
+                chase_q8 += g_results[pass][idx][region][ws].chase_q8;
+            }
+            chase_q8 /= harts;
+            p = fmt_u32(p, chase_q8 >> 8, 7u, ' ');
+            p = fmt_char(p, '.');
+            p = fmt_u32(p, ((chase_q8 & 0xFFu) * 10u) >> 8, 0u, ' ');
+            p = fmt_str(p, "\r\n");
+            *p = '\0';
+            out(line);
+        }
+    }
+}
+
+/***************************************************************************//**
+ * See "mem_bench.h" for details of how to use this function.
+ */
+void mem_bench_report(mem_bench_out_t out)
+{
+    char line[64];
+    char * p;
+    uint32_t hart;
+
+    p = line;
+    p = fmt_str(p, "\r\nmemory bandwidth and latency, best of ");
+    p = fmt_u32(p, MEM_BENCH_REPS, 0u, ' ');
+    p = fmt_str(p, " runs:\r\n");
+    *p = '\0';
+    out(line);
+
+    for (hart = 0u; hart < MEM_BENCH_HARTS; hart++)
+    {
+        report_pass(out, PASS_ALONE, hart);
+    }
+#if MEM_BENCH_ALL_HARTS
+    report_pass(out, PASS_ALL_HARTS, 0u);
+#endif
+}
+
+#endif /* BLINK_BENCHMARKS */
@@ -0,0 +1,110 @@
+/*******************************************************************************
+ * @file mem_bench.h
+ *
+ * @brief Bandwidth and latency of each memory region, from each hart.
+ *
+ * For each region and each working set size that fits in it, the calling
+ * hart runs:
+ *
+ *   copy, scale, add, triad   the STREAM kernels on three arrays of 64-bit
+ *                             words filling the working set, reported in
+ *                             MB/s (bytes read and written, 10^6 per s).
+ *   chase                     a load-to-load chain through one word per
+ *                             64 byte line, in a random order covering the
+ *                             whole working set, so every load waits for
+ *                             the one before and no prefetcher can help;
+ *                             reported in cycles per load.
+ *
+ * The regions are:
+ *
+ *   ddr         a MEM_BENCH_DDR_SIZE buffer in .bss, cached. Working sets up
+ *               to MEM_BENCH_L1_SIZE fit the U54 L1 data cache (the E51 has
+ *               none), up to MEM_BENCH_L2_SIZE the L2 cache, and larger ones
+ *               go to DDR; the report marks which.
+ *   lim         MEM_BENCH_LIM_SIZE bytes of the L2 LIM at MEM_BENCH_LIM_BASE.
+ *   scratchpad  MEM_BENCH_SCRATCH_SIZE bytes of the L2 scratchpad at
+ *               MEM_BENCH_SCRATCH_BASE.
+ *
+ * Set the LIM and scratchpad windows to memory that nothing else in the
+ * image uses for the project's L2 configuration (see fast_mem.ld); a size
+ * of 0 leaves the region out. The benchmark overwrites them. The LIM is left
+ * out by default, since code may be running from it; build with, e.g.,
+ * -DMEM_BENCH_LIM_SIZE=0x20000 and a MEM_BENCH_LIM_BASE that is free.
+ *
+ * The harts first run one at a time, each alone on the memory system. With
+ * MEM_BENCH_ALL_HARTS set, they then run every test at once, each on its own
+ * part of the region, to show what they take from each other on the shared
+ * L2 and DDR; the report gives their total bandwidth and mean latency.
+ *
+ * Call mem_bench_run() from each of harts 0 .. MEM_BENCH_HARTS - 1, then
+ * mem_bench_report() from one of them.
+ */
+
+#ifndef MEM_BENCH_H_
+#define MEM_BENCH_H_
+
+#include <stdint.h>
+#include "bench_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Harts 0 to MEM_BENCH_HARTS - 1 must all call mem_bench_run(). */
+#define MEM_BENCH_HARTS         5u
+
+#ifndef MEM_BENCH_DDR_SIZE
+#define MEM_BENCH_DDR_SIZE      (8u * 1024u * 1024u)
+#endif
+
+/* Off unless a window is given: the boot loader, or an image linked with
+   mpfs-lim.ld, may be running from the LIM. */
+#ifndef MEM_BENCH_LIM_BASE
+#define MEM_BENCH_LIM_BASE      0x08000000UL
+#endif
+#ifndef MEM_BENCH_LIM_SIZE
+#define MEM_BENCH_LIM_SIZE      0u
+#endif
+
+/* Above the 64 KiB that fast_mem.ld uses. */
+#ifndef MEM_BENCH_SCRATCH_BASE
+#define MEM_BENCH_SCRATCH_BASE  0x0A010000UL
+#endif
+#ifndef MEM_BENCH_SCRATCH_SIZE
+#define MEM_BENCH_SCRATCH_SIZE  (64u * 1024u)
+#endif
+
+/* Cache sizes the report labels ddr working sets by. */
+#define MEM_BENCH_L1_SIZE       (32u * 1024u)
+#ifndef MEM_BENCH_L2_SIZE
+#define MEM_BENCH_L2_SIZE       (1024u * 1024u)
+#endif
+
+/* Also run every test on all harts at once. */
+#ifndef MEM_BENCH_ALL_HARTS
+#define MEM_BENCH_ALL_HARTS     1
+#endif
+
+/*------------------------------------------------------------------------------
+  Called once per line of results, e.g. uart0_tx_string().
+ */
+typedef void (*mem_bench_out_t)(const char * line);
+
+/***************************************************************************//**
+ * mem_bench_run() takes part in every pass on the calling hart and returns
+ * once all harts have finished. Harts with an id of MEM_BENCH_HARTS or above
+ * return straight away.
+ */
+void mem_bench_run(uint64_t hartid);
+
+/***************************************************************************//**
+ * mem_bench_report() prints one table per hart, and one for all harts at
+ * once. Call it after mem_bench_run() has returned.
+ */
+void mem_bench_report(mem_bench_out_t out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEM_BENCH_H_ */
@@ -1,19 +1,57 @@
-#include <stdio.h>
 #include "mpfs_hal/mss_hal.h"
 #include "drivers/mss_uart/mss_uart.h"
 #include "inc/common.h"
-
-volatile uint64_t count_sw_ints_h1 = 0;
-volatile uint64_t dummy_h1 = 0;
+#include "telemetry.h"
+#include "telemetry_records.h"
+#include "hart_data.h"
+#include "false_sharing_bench.h"
+#include "isr_latency_bench.h"
+#include "irq_stats.h"
+#include "irq_affinity.h"
+#include "workq.h"
+#include "workq_bench.h"
+#include "uart0.h"
+#include "lock_bench.h"
+#include "ipi_bench.h"
+#include "mem_bench.h"
+
+/* Written only by hart 1; kept off the lines other harts write. */
+volatile uint64_t count_sw_ints_h1 HART_BSS(1) = 0;
+volatile uint64_t dummy_h1 HART_BSS(1) = 0;
+
+/* Status records for the host decoder, lib/telemetry_decode.py, on MMUART1
+ * so the frames do not land in the middle of the text on UART0. */
+static telemetry_t g_tlm_h1 HART_BSS(1);
+
+/* Software interrupt calls and run time, sent with each status record. */
+static irq_stat_t g_irq_sw_h1 CACHE_ALIGNED =
+        IRQ_STAT_INIT("software", IRQ_STAT_SOFTWARE, 1u);
+static irq_stat_t * const g_irq_stats_h1[] = { &g_irq_sw_h1 };
+
+
+/* Only hart 1 writes MMUART1, so it needs no lock. Frames contain 0x00, so
+ * they go out with MSS_UART_polled_tx() rather than the string function. */
+static void telemetry_write_h1(const uint8_t *buf, size_t len)
+{
+    MSS_UART_polled_tx(&g_mss_uart1_lo, buf, (uint32_t)len);
+}
 
 
 void Software_h1_IRQHandler(void)
 {
+#if BLINK_BENCHMARKS
+	isr_latency_bench_irq();
+	ipi_bench_irq();
+#endif
+	IRQ_STATS_ENTER(&g_irq_sw_h1);
+
 	uint32_t hart_id = read_csr(mhartid);
 	if (hart_id == 1)
 	{
 		count_sw_ints_h1++;
 	}
+
+	IRQ_STATS_EXIT(&g_irq_sw_h1);
 }
 
 /* Synchronizing the hart's applications because they have interdependencies */
@@ -36,13 +74,18 @@ void u54_1_init_hal(void)
      * can enable and use any interrupts as required*/
     clear_soft_interrupt();
 
-    __enable_irq();
+    /* Also take any GPIO interrupts the E51 routes here. */
+    irq_affinity_serve();
 }
 
 
 void u54_1_setup(void)
 {
-    
+    (void)mss_config_clk_rst(MSS_PERIPH_MMUART1, (uint8_t)MPFS_HAL_LAST_HART,
+                             PERIPHERAL_ON);
+    MSS_UART_init(&g_mss_uart1_lo, MSS_UART_115200_BAUD,
+            MSS_UART_DATA_8_BITS | MSS_UART_NO_PARITY | MSS_UART_ONE_STOP_BIT);
+    telemetry_init(&g_tlm_h1, (uint8_t)read_csr(mhartid), telemetry_write_h1);
 }
 
 
@@ -52,7 +95,20 @@ void u54_1_application(void)
     volatile uint64_t loop_count_h1 = 0;
     const uint64_t num_loops        = 100000;
     uint64_t hartid                 = read_csr(mhartid);
-    char uart_buf[100];
+
+#if BLINK_BENCHMARKS
+    false_sharing_bench_run(hartid);
+    lock_bench_run(hartid);
+    ipi_bench_run(hartid);
+    mem_bench_run(hartid);
+    isr_latency_bench_run();
+    isr_latency_bench_report(uart0_tx_string);
+
+    /* Hart 1 forks and joins; harts 2 to 4 steal. */
+    workq_bench_run();
+    workq_bench_report(uart0_tx_string);
+    workq_report(uart0_tx_string);
+#endif
 
     while (1)
     {
@@ -62,10 +118,13 @@ void u54_1_application(void)
             dummy_h1 = i;
         }
 
-        sprintf(uart_buf, "Hart %ld, mcycle_delta=%ld SW_IRQs=%ld mcycle=%ld\r\n",
-                hartid, mcycle.delta, count_sw_ints_h1, readmcycle());
-
-        safe_MSS_UART0_polled_tx_string(uart_buf);
+        telemetry_begin(&g_tlm_h1, TLM_HART_STATUS);
+        telemetry_put_u64(&g_tlm_h1, hartid);
+        telemetry_put_u64(&g_tlm_h1, mcycle.delta);
+        telemetry_put_u64(&g_tlm_h1, count_sw_ints_h1);
+        telemetry_put_u64(&g_tlm_h1, readmcycle());
+        (void)telemetry_end(&g_tlm_h1);
+        irq_stats_send(g_irq_stats_h1, 1u, &g_tlm_h1);
 
         hartid       = read_csr(mhartid);
         mcycle.end   = readmcycle();
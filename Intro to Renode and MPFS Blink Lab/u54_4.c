@@ -0,0 +1,56 @@
+#include "mpfs_hal/mss_hal.h"
+#include "irq_affinity.h"
+#include "workq.h"
+#include "lock_bench.h"
+#include "ipi_bench.h"
+#include "mem_bench.h"
+
+/* Hart 4 has no application of its own. It runs tasks for the work
+ * stealing runtime (workq.h) and serves the PLIC sources that the balancer
+ * in e51.c routes to it (irq_affinity.h). */
+
+void Software_h4_IRQHandler(void)
+{
+#if BLINK_BENCHMARKS
+    ipi_bench_irq();
+#endif
+}
+
+
+void u54_4_init_hal(void)
+{
+    /* Clear pending software interrupt in case there was any.
+     * Enable only the software interrupt so that the E51 core can bring this
+     * core out of WFI by raising a software interrupt. */
+    clear_soft_interrupt();
+    set_csr(mie, MIP_MSIP);
+
+    /* Put this hart into sleep with WFI. Keep putting hart into sleep until
+     * a correct IRQ is received */
+    do
+    {
+        __asm("wfi");
+    } while (0 == (read_csr(mip) & MIP_MSIP));
+
+    /* The hart is out of WFI, clear the SW interrupt. */
+    clear_soft_interrupt();
+}
+
+
+/* Main function for the HART4(U54_4 processor).
+ *
+ * The HART4 goes into WFI until HART0 raises the first Software interrupt to
+ * this HART, then works for the runtime, sleeping in WFI when there is no
+ * work, and takes the external interrupts routed to it.
+ */
+void u54_4(void)
+{
+    u54_4_init_hal();
+    irq_affinity_serve();
+#if BLINK_BENCHMARKS
+    lock_bench_run(read_csr(mhartid));
+    ipi_bench_run(read_csr(mhartid));
+    mem_bench_run(read_csr(mhartid));
+#endif
+    workq_worker();
+}
@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * @file uart0.c
+ *
+ * @brief UART0 output shared by all five harts.
+ *
+ * See "uart0.h" for details of how to use this module.
+ */
+
+#include "mpfs_hal/mss_hal.h"
+#include "drivers/mss_uart/mss_uart.h"
+#include "irq_plan.h"
+#include "uart0.h"
+
+ticket_lock_t g_uart0_lock = TICKET_LOCK_INIT("uart0");
+
+/*------------------------------------------------------------------------------
+  Take the lock with the hart's PLIC threshold raised to IRQ_PRIO_LOG, so no
+  handler that prints can interrupt this hart while it holds the lock.
+  Returns the threshold to restore.
+ */
+static uint32_t uart0_lock(void)
+{
+    uint32_t threshold = irq_plan_threshold();
+
+    if (threshold < IRQ_PRIO_LOG)
+    {
+        irq_plan_set_threshold(IRQ_PRIO_LOG);
+    }
+    ticket_lock_acquire(&g_uart0_lock);
+
+    return threshold;
+}
+
+static void uart0_unlock(uint32_t threshold)
+{
+    ticket_lock_release(&g_uart0_lock);
+    irq_plan_set_threshold(threshold);
+}
+
+/***************************************************************************//**
+ * See "uart0.h" for details of how to use this function.
+ */
+void uart0_tx_string(const char * str)
+{
+    uint32_t threshold = uart0_lock();
+
+    MSS_UART_polled_tx_string(&g_mss_uart0_lo, (const uint8_t *)str);
+    uart0_unlock(threshold);
+}
+
+/***************************************************************************//**
+ * See "uart0.h" for details of how to use this function.
+ */
+void uart0_tx(const uint8_t * buf, size_t len)
+{
+    uint32_t threshold = uart0_lock();
+
+    MSS_UART_polled_tx(&g_mss_uart0_lo, buf, (uint32_t)len);
+    uart0_unlock(threshold);
+}
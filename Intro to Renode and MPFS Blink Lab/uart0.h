@@ -0,0 +1,47 @@
+/*******************************************************************************
+ * @file uart0.h
+ *
+ * @brief UART0 output shared by all five harts.
+ *
+ * Every hart writes its messages to UART0. A message goes out whole under
+ * g_uart0_lock, a ticket lock (spinlock.h), so messages from different harts
+ * do not interleave and a hart that is waiting gets the UART in turn rather
+ * than whenever its swap happens to win, as with the HAL mutex this
+ * replaces.
+ *
+ * Interrupt handlers may print too, from an irq_nest window at IRQ_PRIO_LOG
+ * (irq_plan.h), as the GPIO handlers in e51.c do. While a hart holds the
+ * lock its PLIC threshold is at least IRQ_PRIO_LOG, so a handler that prints
+ * cannot interrupt it and then wait forever for the lock it holds; handlers
+ * above IRQ_PRIO_LOG are still taken, and must not print.
+ */
+
+#ifndef UART0_H_
+#define UART0_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "spinlock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern ticket_lock_t g_uart0_lock;
+
+/***************************************************************************//**
+ * uart0_tx_string() sends a NUL terminated string.
+ */
+void uart0_tx_string(const char * str);
+
+/***************************************************************************//**
+ * uart0_tx() sends len bytes, which may include NULs, e.g. a telemetry
+ * frame.
+ */
+void uart0_tx(const uint8_t * buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UART0_H_ */
@@ -0,0 +1,278 @@
+/*******************************************************************************
+ * @file workq_bench.c
+ *
+ * @brief Scaling of the work stealing runtime (workq.h) over 1 to 4 harts.
+ *
+ * See "workq_bench.h" for details of how to use this module.
+ */
+
+#include "workq_bench.h"
+#include "workq.h"
+#include "mcycle.h"
+#include "fmt.h"
+
+#if BLINK_BENCHMARKS
+
+#define FIR_TAPS                16u
+#define FIR_GRAIN               512u
+#define CRC_BLOCK_SIZE          1024u
+#define FRAME_MAX_ITER          64u
+#define WQ_NAME_WIDTH           8u
+
+#define WL_FIR                  0u
+#define WL_CRC                  1u
+#define WL_FRAME                2u
+#define NUM_WORKLOADS           3u
+
+static const char * const g_names[NUM_WORKLOADS] = { "fir", "crc32", "frame" };
+
+/* Inputs, and outputs every run overwrites. */
+static int16_t g_samples[WQ_BENCH_SAMPLES + FIR_TAPS];
+static int16_t g_filtered[WQ_BENCH_SAMPLES];
+static uint32_t g_crcs[WQ_BENCH_BLOCKS];
+static uint8_t g_frame[WQ_BENCH_HEIGHT][WQ_BENCH_WIDTH];
+
+static const int16_t g_taps[FIR_TAPS] =
+{
+    -12, -31, 0, 142, 398, 702, 950, 1047,
+    1047, 950, 702, 398, 142, 0, -31, -12
+};
+
+typedef struct wq_result
+{
+    uint64_t cycles[WORKQ_HARTS];   /* best run on 1, 2, ... harts */
+    uint32_t checksum;              /* of the one hart output */
+    uint8_t mismatch;
+} wq_result_t;
+
+static wq_result_t g_results[NUM_WORKLOADS];
+
+/*------------------------------------------------------------------------------
+  Workloads. Each index writes only its own outputs.
+ */
+static void fir_range(void * arg, uint32_t begin, uint32_t end)
+{
+    uint32_t idx;
+    uint32_t tap;
+    int32_t acc;
+
+    (void)arg;
+    for (idx = begin; idx < end; idx++)
+    {
+        acc = 0;
+        for (tap = 0u; tap < FIR_TAPS; tap++)
+        {
+            acc += (int32_t)g_samples[idx + tap] * g_taps[tap];
+        }
+        g_filtered[idx] = (int16_t)(acc >> 13);
+    }
+}
+
+static void crc_range(void * arg, uint32_t begin, uint32_t end)
+{
+    const uint8_t * data = (const uint8_t *)g_samples;
+    uint32_t block;
+    uint32_t idx;
+    uint32_t bit;
+    uint32_t crc;
+
+    (void)arg;
+    for (block = begin; block < end; block++)
+    {
+        crc = 0xFFFFFFFFu;
+        for (idx = block * CRC_BLOCK_SIZE; idx < (block + 1u) * CRC_BLOCK_SIZE; idx++)
+        {
+            crc ^= data[idx];
+            for (bit = 0u; bit < 8u; bit++)
+            {
+                crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+            }
+        }
+        g_crcs[block] = ~crc;
+    }
+}
+
+static void frame_range(void * arg, uint32_t begin, uint32_t end)
+{
+    uint32_t row;
+    uint32_t col;
+    uint32_t iter;
+    int32_t cr;
+    int32_t ci;
+    int32_t zr;
+    int32_t zi;
+    int32_t zr2;
+    int32_t zi2;
+
+    (void)arg;
+    for (row = begin; row < end; row++)
+    {
+        /* Q12: the frame covers re [-2.5, 1), im [-1.25, 1.25). */
+        ci = (int32_t)((row * 10240u) / WQ_BENCH_HEIGHT) - 5120;
+        for (col = 0u; col < WQ_BENCH_WIDTH; col++)
+        {
+            cr = (int32_t)((col * 14336u) / WQ_BENCH_WIDTH) - 10240;
+            zr = 0;
+            zi = 0;
+            for (iter = 0u; iter < FRAME_MAX_ITER; iter++)
+            {
+                zr2 = (zr * zr) >> 12;
+                zi2 = (zi * zi) >> 12;
+                if ((zr2 + zi2) > (4 << 12))
+                {
+                    break;
+                }
+                zi = ((zr * zi) >> 11) + ci;
+                zr = zr2 - zi2 + cr;
+            }
+            g_frame[row][col] = (uint8_t)iter;
+        }
+    }
+}
+
+static uint32_t checksum(const void * data, uint32_t len)
+{
+    const uint8_t * p = (const uint8_t *)data;
+    uint32_t sum = 0u;
+    uint32_t idx;
+
+    for (idx = 0u; idx < len; idx++)
+    {
+        sum = (sum * 31u) + p[idx];
+    }
+    return sum;
+}
+
+static uint64_t run_workload(uint32_t workload, uint32_t * sum)
+{
+    uint64_t start = mcycle_read();
+    uint64_t cycles;
+
+    switch (workload)
+    {
+    case WL_FIR:
+        workq_parallel_for(fir_range, 0, 0u, WQ_BENCH_SAMPLES, FIR_GRAIN);
+        cycles = mcycle_read() - start;
+        *sum = checksum(g_filtered, sizeof(g_filtered));
+        break;
+
+    case WL_CRC:
+        workq_parallel_for(crc_range, 0, 0u, WQ_BENCH_BLOCKS, 1u);
+        cycles = mcycle_read() - start;
+        *sum = checksum(g_crcs, sizeof(g_crcs));
+        break;
+
+    default:
+        workq_parallel_for(frame_range, 0, 0u, WQ_BENCH_HEIGHT, 1u);
+        cycles = mcycle_read() - start;
+        *sum = checksum(g_frame, sizeof(g_frame));
+        break;
+    }
+
+    return cycles;
+}
+
+/***************************************************************************//**
+ * See "workq_bench.h" for details of how to use this function.
+ */
+void workq_bench_run(void)
+{
+    uint32_t seed = 12345u;
+    uint32_t idx;
+    uint32_t harts;
+    uint32_t workload;
+    uint32_t run;
+    uint32_t sum;
+    uint64_t cycles;
+    wq_result_t * result;
+
+    for (idx = 0u; idx < (WQ_BENCH_SAMPLES + FIR_TAPS); idx++)
+    {
+        seed = (seed * 1103515245u) + 12345u;
+        g_samples[idx] = (int16_t)(seed >> 16);
+    }
+
+    for (harts = 1u; harts <= WORKQ_HARTS; harts++)
+    {
+        workq_set_harts(harts);
+        for (workload = 0u; workload < NUM_WORKLOADS; workload++)
+        {
+            result = &g_results[workload];
+            result->cycles[harts - 1u] = UINT64_MAX;
+            for (run = 0u; run < WQ_BENCH_RUNS; run++)
+            {
+                cycles = run_workload(workload, &sum);
+                if (cycles < result->cycles[harts - 1u])
+                {
+                    result->cycles[harts - 1u] = cycles;
+                }
+
+                if ((1u == harts) && (0u == run))
+                {
+                    result->checksum = sum;
+                    result->mismatch = 0u;
+                }
+                else if (sum != result->checksum)
+                {
+                    result->mismatch = 1u;
+                }
+            }
+        }
+    }
+
+    workq_set_harts(WORKQ_HARTS);
+}
+
+/***************************************************************************//**
+ * See "workq_bench.h" for details of how to use this function.
+ */
+void workq_bench_report(wq_bench_out_t out)
+{
+    char line[128];
+    char * p;
+    const wq_result_t * result;
+    uint32_t workload;
+    uint32_t harts;
+    uint32_t len;
+    uint64_t base;
+    uint64_t cycles;
+
+    p = line;
+    p = fmt_str(p, "\r\nwork stealing, best of ");
+    p = fmt_u32(p, WQ_BENCH_RUNS, 0u, ' ');
+    p = fmt_str(p, " runs (kcycles, speedup over 1 hart):\r\n");
+    *p = '\0';
+    out(line);
+    out("  workload    1 hart        2 harts        3 harts        4 harts\r\n");
+
+    for (workload = 0u; workload < NUM_WORKLOADS; workload++)
+    {
+        result = &g_results[workload];
+        base = result->cycles[0];
+
+        p = line;
+        p = fmt_str(p, "  ");
+        p = fmt_str(p, g_names[workload]);
+        for (len = 0u; ('\0' != g_names[workload][len]) && (len < WQ_NAME_WIDTH); len++)
+        {
+            ;
+        }
+        for (; len < WQ_NAME_WIDTH; len++)
+        {
+            p = fmt_char(p, ' ');
+        }
+        for (harts = 0u; harts < WORKQ_HARTS; harts++)
+        {
+            cycles = result->cycles[harts];
+            p = fmt_u64(p, cycles / 1000u, (0u == harts) ? 10u : 8u, ' ');
+            p = fmt_str(p, "  x");
+            p = fmt_fixed(p, (int32_t)((base << 8) / ((0u != cycles) ? cycles : 1u)), 8u, 2u);
+        }
+        p = fmt_str(p, (0u != result->mismatch) ? "  MISMATCH\r\n" : "  ok\r\n");
+        *p = '\0';
+
+        out(line);
+    }
+}
+
+#endif /* BLINK_BENCHMARKS */
@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * @file workq_bench.h
+ *
+ * @brief Scaling of the work stealing runtime (workq.h) over 1 to 4 harts.
+ *
+ * Three workloads are run with workq_parallel_for() on 1, 2, 3 and then 4
+ * U54 harts (workq_set_harts()), best of WQ_BENCH_RUNS runs each:
+ *
+ *   fir     16 tap FIR filter over WQ_BENCH_SAMPLES 16-bit samples; even
+ *           work per index, mostly memory bound.
+ *   crc32   bitwise CRC-32 of WQ_BENCH_BLOCKS 1 KB blocks; even work per
+ *           index, compute bound.
+ *   frame   escape-time fractal, one task per row of a WQ_BENCH_WIDTH by
+ *           WQ_BENCH_HEIGHT frame; rows take very different times, so this
+ *           one scales only if idle harts steal.
+ *
+ * The output of every run is checked against the run on one hart.
+ *
+ * Call workq_bench_run() from hart 1 once harts 2 to 4 are in
+ * workq_worker(), then workq_bench_report().
+ */
+
+#ifndef WORKQ_BENCH_H_
+#define WORKQ_BENCH_H_
+
+#include <stdint.h>
+#include "bench_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WQ_BENCH_RUNS           3u
+#define WQ_BENCH_SAMPLES        16384u
+#define WQ_BENCH_BLOCKS         32u
+#define WQ_BENCH_WIDTH          128u
+#define WQ_BENCH_HEIGHT         96u
+
+/*------------------------------------------------------------------------------
+  Called once per line of results, e.g. uart0_tx_string().
+ */
+typedef void (*wq_bench_out_t)(const char * line);
+
+/***************************************************************************//**
+ * workq_bench_run() runs every workload on each number of harts and leaves
+ * the runtime with all of them.
+ */
+void workq_bench_run(void);
+
+/***************************************************************************//**
+ * workq_bench_report() prints the cycles per workload and hart count, the
+ * speedup over one hart, and whether the results matched.
+ */
+void workq_bench_report(wq_bench_out_t out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORKQ_BENCH_H_ */
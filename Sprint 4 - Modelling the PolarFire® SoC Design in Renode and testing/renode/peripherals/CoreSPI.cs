@@ -0,0 +1,249 @@
+//
+// CoreSPI: Microchip's FPGA fabric SPI controller, modelled as far as the
+// CoreSPI driver uses it in master mode.
+//
+// Frames complete instantly: writing TXDATA or TXLAST shifts the frame out
+// to the attached peripheral MSB first, one byte per 8 bits of frameWidth,
+// and queues what came back in the receive FIFO. With selectPerFrame (the
+// Discovery Kit design, where the MAX7219 LOAD pin is the slave select and
+// rises after every 16 bit frame) each frame also ends the transmission;
+// otherwise only TXLAST does.
+//
+// FramesTransferred and BytesTransferred count the traffic, for measuring
+// display update costs from the monitor or a test:
+//
+//     sysbus.corespi FramesTransferred
+//
+using System.Collections.Generic;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Core.Structure;
+using Antmicro.Renode.Core.Structure.Registers;
+using Antmicro.Renode.Exceptions;
+using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.Bus;
+
+namespace Antmicro.Renode.Peripherals.SPI
+{
+    public class CoreSPI : NullRegistrationPointPeripheralContainer<ISPIPeripheral>, IDoubleWordPeripheral, IBytePeripheral,
+        IProvidesRegisterCollection<DoubleWordRegisterCollection>, IKnownSize
+    {
+        public CoreSPI(IMachine machine, int frameWidth = 8, int fifoDepth = 4, bool selectPerFrame = true) : base(machine)
+        {
+            if(frameWidth < 4 || frameWidth > 32)
+            {
+                throw new ConstructionException("frameWidth must be between 4 and 32");
+            }
+            if(fifoDepth < 1)
+            {
+                throw new ConstructionException("fifoDepth must be at least 1");
+            }
+
+            this.frameWidth = frameWidth;
+            this.fifoDepth = fifoDepth;
+            this.selectPerFrame = selectPerFrame;
+            frameMask = frameWidth == 32 ? uint.MaxValue : (1u << frameWidth) - 1;
+
+            IRQ = new GPIO();
+            receiveFifo = new Queue<uint>();
+            RegistersCollection = new DoubleWordRegisterCollection(this);
+            DefineRegisters();
+            Reset();
+        }
+
+        public override void Reset()
+        {
+            RegistersCollection.Reset();
+            receiveFifo.Clear();
+            firstFrame = true;
+            done = false;
+            receiveOverflow = false;
+            FramesTransferred = 0;
+            BytesTransferred = 0;
+            UpdateInterrupts();
+        }
+
+        public uint ReadDoubleWord(long offset)
+        {
+            return RegistersCollection.Read(offset);
+        }
+
+        public void WriteDoubleWord(long offset, uint value)
+        {
+            RegistersCollection.Write(offset, value);
+        }
+
+        // The driver reads STATUS and writes COMMAND and TXLAST 8 bits wide.
+        public byte ReadByte(long offset)
+        {
+            return (byte)(RegistersCollection.Read(offset & ~3L) >> (int)(8 * (offset & 3)));
+        }
+
+        public void WriteByte(long offset, byte value)
+        {
+            if((offset & 3) != 0)
+            {
+                this.Log(LogLevel.Warning, "Unaligned byte write of 0x{0:X} at 0x{1:X} ignored", value, offset);
+                return;
+            }
+            RegistersCollection.Write(offset, value);
+        }
+
+        public long Size => 0x100;
+
+        public GPIO IRQ { get; }
+
+        public DoubleWordRegisterCollection RegistersCollection { get; }
+
+        public ulong FramesTransferred { get; private set; }
+
+        public ulong BytesTransferred { get; private set; }
+
+        private void DefineRegisters()
+        {
+            Registers.Control1.Define(this)
+                .WithFlag(0, out enabled, name: "ENABLE")
+                .WithFlag(1, out master, name: "MASTER")
+                .WithValueField(2, 6, name: "INT_ENABLES")
+                .WithReservedBits(8, 24);
+
+            Registers.InterruptClear.Define(this)
+                .WithFlag(0, FieldMode.WriteOneToClear, writeCallback: (_, val) => { if(val) txDoneInterrupt.Value = false; }, name: "TXDONE")
+                .WithFlag(1, FieldMode.WriteOneToClear, writeCallback: (_, val) => { if(val) rxDoneInterrupt.Value = false; }, name: "RXDONE")
+                .WithFlag(2, FieldMode.WriteOneToClear, writeCallback: (_, val) => { if(val) receiveOverflow = false; }, name: "RXOVERFLOW")
+                .WithReservedBits(3, 29)
+                .WithWriteCallback((_, __) => UpdateInterrupts());
+
+            Registers.ReceiveData.Define(this)
+                .WithValueField(0, 32, FieldMode.Read, valueProviderCallback: _ => receiveFifo.Count > 0 ? receiveFifo.Dequeue() : 0u, name: "RXDATA");
+
+            Registers.TransmitData.Define(this)
+                .WithValueField(0, 32, FieldMode.Write, writeCallback: (_, val) => TransferFrame((uint)val, false), name: "TXDATA");
+
+            Registers.InterruptMask.Define(this)
+                .WithFlag(0, out txDoneEnabled, name: "TXDONE")
+                .WithFlag(1, out rxDoneEnabled, name: "RXDONE")
+                .WithReservedBits(2, 30)
+                .WithWriteCallback((_, __) => UpdateInterrupts());
+
+            Registers.InterruptRaw.Define(this)
+                .WithFlag(0, out txDoneInterrupt, FieldMode.Read, name: "TXDONE")
+                .WithFlag(1, out rxDoneInterrupt, FieldMode.Read, name: "RXDONE")
+                .WithFlag(2, FieldMode.Read, valueProviderCallback: _ => receiveOverflow, name: "RXOVERFLOW")
+                .WithReservedBits(3, 29);
+
+            Registers.Control2.Define(this)
+                .WithValueField(0, 8, name: "CTRL2");
+
+            Registers.Command.Define(this)
+                .WithFlag(0, FieldMode.Write, writeCallback: (_, val) => { if(val) receiveFifo.Clear(); }, name: "RXFIFORST")
+                .WithFlag(1, FieldMode.Write, name: "TXFIFORST")
+                .WithReservedBits(2, 30);
+
+            Registers.Status.Define(this)
+                .WithFlag(0, FieldMode.Read, valueProviderCallback: _ => firstFrame, name: "FIRSTFRAME")
+                .WithFlag(1, FieldMode.Read, valueProviderCallback: _ => done, name: "DONE")
+                .WithFlag(2, FieldMode.Read, valueProviderCallback: _ => receiveFifo.Count == 0, name: "RXEMPTY")
+                .WithFlag(3, FieldMode.Read, valueProviderCallback: _ => false, name: "TXFULL")
+                .WithFlag(4, FieldMode.Read, valueProviderCallback: _ => receiveOverflow, name: "RXOVFLOW")
+                .WithFlag(5, FieldMode.Read, valueProviderCallback: _ => false, name: "TXUNDERRUN")
+                .WithFlag(6, FieldMode.Read, valueProviderCallback: _ => false, name: "SSEL")
+                .WithFlag(7, FieldMode.Read, valueProviderCallback: _ => false, name: "ACTIVE")
+                .WithReservedBits(8, 24);
+
+            Registers.SlaveSelect.Define(this)
+                .WithValueField(0, 8, name: "SSEL")
+                .WithReservedBits(8, 24);
+
+            Registers.TransmitDataLast.Define(this)
+                .WithValueField(0, 32, FieldMode.Write, writeCallback: (_, val) => TransferFrame((uint)val, true), name: "TXLAST");
+
+            Registers.ClockDivider.Define(this)
+                .WithValueField(0, 8, name: "CLK_DIV")
+                .WithReservedBits(8, 24);
+        }
+
+        private void TransferFrame(uint value, bool last)
+        {
+            if(!enabled.Value || !master.Value)
+            {
+                this.Log(LogLevel.Warning, "Frame 0x{0:X} written while not enabled as master, dropped", value);
+                return;
+            }
+
+            var received = 0u;
+            var bytes = (frameWidth + 7) / 8;
+            if(RegisteredPeripheral == null)
+            {
+                this.Log(LogLevel.Warning, "Frame 0x{0:X} sent with no peripheral attached", value);
+            }
+            else
+            {
+                for(var i = bytes - 1; i >= 0; i--)
+                {
+                    received = (received << 8) | RegisteredPeripheral.Transmit((byte)(value >> (8 * i)));
+                }
+                if(last || selectPerFrame)
+                {
+                    RegisteredPeripheral.FinishTransmission();
+                }
+            }
+
+            FramesTransferred++;
+            BytesTransferred += (ulong)bytes;
+            firstFrame = last;
+            done = true;
+
+            if(receiveFifo.Count < fifoDepth)
+            {
+                receiveFifo.Enqueue(received & frameMask);
+            }
+            else
+            {
+                receiveOverflow = true;
+            }
+
+            txDoneInterrupt.Value = true;
+            rxDoneInterrupt.Value = true;
+            UpdateInterrupts();
+        }
+
+        private void UpdateInterrupts()
+        {
+            var pending = (txDoneEnabled.Value && txDoneInterrupt.Value)
+                || (rxDoneEnabled.Value && rxDoneInterrupt.Value);
+            IRQ.Set(pending);
+        }
+
+        private IFlagRegisterField enabled;
+        private IFlagRegisterField master;
+        private IFlagRegisterField txDoneEnabled;
+        private IFlagRegisterField rxDoneEnabled;
+        private IFlagRegisterField txDoneInterrupt;
+        private IFlagRegisterField rxDoneInterrupt;
+        private bool firstFrame;
+        private bool done;
+        private bool receiveOverflow;
+
+        private readonly int frameWidth;
+        private readonly int fifoDepth;
+        private readonly bool selectPerFrame;
+        private readonly uint frameMask;
+        private readonly Queue<uint> receiveFifo;
+
+        private enum Registers
+        {
+            Control1 = 0x00,
+            InterruptClear = 0x04,
+            ReceiveData = 0x08,
+            TransmitData = 0x0C,
+            InterruptMask = 0x10,
+            InterruptRaw = 0x14,
+            Control2 = 0x18,
+            Command = 0x1C,
+            Status = 0x20,
+            SlaveSelect = 0x24,
+            TransmitDataLast = 0x28,
+            ClockDivider = 0x2C,
+        }
+    }
+}
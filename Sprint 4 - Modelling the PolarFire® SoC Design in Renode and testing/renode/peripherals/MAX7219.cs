@@ -0,0 +1,191 @@
+//
+// MAX7219 8-digit LED display driver on an SPI bus.
+//
+// Each 16 bit frame is a register address in bits 11:8 and data in bits
+// 7:0, latched when the transmission ends (LOAD rising). The digit
+// registers are decoded into a line of text, DIG7 on the left: Code B
+// digits where the decode mode asks for them, otherwise the segment
+// patterns the demos use (DP A B C D E F G, bit 7 to bit 0). The text is
+// logged whenever it changes and can be read from the monitor or a test:
+//
+//     sysbus.corespi.max7219 Text
+//
+// Frames and Updates count latched frames and visible changes, so
+// Frames / Updates is the SPI cost of one display update.
+//
+using System.Collections.Generic;
+using System.Text;
+using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.SPI;
+
+namespace Antmicro.Renode.Peripherals.Miscellaneous
+{
+    public class MAX7219 : ISPIPeripheral
+    {
+        public MAX7219()
+        {
+            digits = new byte[DigitCount];
+            Reset();
+        }
+
+        public void Reset()
+        {
+            shift = 0;
+            bytesInFrame = 0;
+            for(var i = 0; i < DigitCount; i++)
+            {
+                digits[i] = 0;
+            }
+            decodeMode = 0;
+            Intensity = 0;
+            scanLimit = DigitCount - 1;
+            Shutdown = true;
+            DisplayTest = false;
+            Frames = 0;
+            Updates = 0;
+            Text = Render();
+        }
+
+        public byte Transmit(byte data)
+        {
+            // DOUT is the frame shifted in 16 clocks earlier, for daisy chaining.
+            var output = (byte)(shift >> 8);
+            shift = (ushort)((shift << 8) | data);
+            bytesInFrame++;
+            return output;
+        }
+
+        public void FinishTransmission()
+        {
+            if(bytesInFrame >= 2)
+            {
+                Latch(shift);
+            }
+            else if(bytesInFrame != 0)
+            {
+                this.Log(LogLevel.Warning, "LOAD after {0} byte(s); frame ignored", bytesInFrame);
+            }
+            bytesInFrame = 0;
+        }
+
+        public string Text { get; private set; }
+
+        public ulong Frames { get; private set; }
+
+        public ulong Updates { get; private set; }
+
+        public int Intensity { get; private set; }
+
+        public bool Shutdown { get; private set; }
+
+        public bool DisplayTest { get; private set; }
+
+        private void Latch(ushort frame)
+        {
+            var address = (frame >> 8) & 0xF;
+            var data = (byte)frame;
+
+            Frames++;
+            switch(address)
+            {
+            case 0x0:
+                break;
+            case 0x9:
+                decodeMode = data;
+                break;
+            case 0xA:
+                Intensity = data & 0xF;
+                break;
+            case 0xB:
+                scanLimit = data & 0x7;
+                break;
+            case 0xC:
+                Shutdown = (data & 1) == 0;
+                break;
+            case 0xF:
+                DisplayTest = (data & 1) != 0;
+                break;
+            default:
+                if(address >= 1 && address <= DigitCount)
+                {
+                    digits[address - 1] = data;
+                }
+                else
+                {
+                    this.Log(LogLevel.Warning, "Write of 0x{0:X} to unused register 0x{1:X}", data, address);
+                }
+                break;
+            }
+
+            var text = Render();
+            if(text != Text)
+            {
+                Text = text;
+                Updates++;
+                this.Log(LogLevel.Info, "display [{0}]", text);
+            }
+        }
+
+        private string Render()
+        {
+            if(DisplayTest)
+            {
+                return "8.8.8.8.8.8.8.8.";
+            }
+            if(Shutdown)
+            {
+                return new string(' ', DigitCount);
+            }
+
+            var text = new StringBuilder();
+            for(var i = DigitCount - 1; i >= 0; i--)
+            {
+                var data = digits[i];
+                if(i > scanLimit)
+                {
+                    text.Append(' ');
+                    continue;
+                }
+                if((decodeMode & (1 << i)) != 0)
+                {
+                    text.Append(CodeB[data & 0xF]);
+                }
+                else
+                {
+                    text.Append(Segments.TryGetValue((byte)(data & 0x7F), out var c) ? c : '?');
+                }
+                if((data & 0x80) != 0)
+                {
+                    text.Append('.');
+                }
+            }
+            return text.ToString();
+        }
+
+        private ushort shift;
+        private int bytesInFrame;
+        private int decodeMode;
+        private int scanLimit;
+        private readonly byte[] digits;
+
+        private const int DigitCount = 8;
+
+        private static readonly char[] CodeB =
+        {
+            '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '-', 'E', 'H', 'L', 'P', ' '
+        };
+
+        // 9 is drawn both with the bottom segment (0x7B) and without it (0x73,
+        // the form the Sprint9 firmware uses), so both decode as '9'.
+        private static readonly Dictionary<byte, char> Segments = new Dictionary<byte, char>
+        {
+            { 0x00, ' ' }, { 0x7E, '0' }, { 0x30, '1' }, { 0x6D, '2' }, { 0x79, '3' },
+            { 0x33, '4' }, { 0x5B, '5' }, { 0x5F, '6' }, { 0x70, '7' }, { 0x7F, '8' },
+            { 0x7B, '9' }, { 0x77, 'A' }, { 0x1F, 'b' }, { 0x4E, 'C' }, { 0x3D, 'd' },
+            { 0x4F, 'E' }, { 0x47, 'F' }, { 0x37, 'H' }, { 0x58, 'J' }, { 0x0E, 'L' },
+            { 0x76, 'N' }, { 0x15, 'n' }, { 0x1D, 'o' }, { 0x67, 'P' }, { 0x73, '9' },
+            { 0x05, 'r' }, { 0x0F, 't' }, { 0x3E, 'U' }, { 0x3B, 'y' }, { 0x01, '-' },
+            { 0x08, '_' },
+        };
+    }
+}
@@ -0,0 +1,160 @@
+"""Robot Framework keywords for the performance budgets in perf.robot.
+
+Metrics are compared with perf_baseline.json: a metric fails if it is more
+than tolerance_percent above its baseline (every metric here is a cost, so
+lower is better). The baseline lists every metric the suite measures; one
+that is missing from it, or listed as null (not recorded yet), fails too,
+so a new metric cannot slip in without a budget.
+
+To record or refresh the baseline after an intended change, run the suite
+with PERF_UPDATE_BASELINE=1 and commit the rewritten perf_baseline.json
+together with the change that moved the numbers.
+
+MMIO and UART figures come from Renode's peripheral access log
+(sysbus LogPeripheralAccess), which perf.robot writes to a log file; symbol
+addresses come from the ELF via nm/objdump ($NM, $OBJDUMP, default the
+riscv64-unknown-elf tools).
+"""
+
+import json
+import os
+import re
+import subprocess
+
+from robot.api import logger
+
+ACCESS = re.compile(
+    r"\]\s+(?P<periph>[\w.]+):\s+(?:\[[^\]]*\]\s+)?"
+    r"(?P<dir>Read|Write)\w*\s+(?:to|from)\s+0x(?P<offset>[0-9A-Fa-f]+)"
+    r"(?:\s+\([^)]*\))?,\s+(?:value|returned)\s+0x(?P<value>[0-9A-Fa-f]+)")
+
+RETURNS = re.compile(r"^\s*([0-9a-f]+):\s+(?:ret|mret|jr\s+ra)\b")
+
+
+class perf_budget(object):
+    ROBOT_LIBRARY_SCOPE = "GLOBAL"
+
+    def __init__(self, baseline_path):
+        self.path = baseline_path
+        with open(baseline_path) as handle:
+            self.baseline = json.load(handle)
+        self.baseline.setdefault("tolerance_percent", 5)
+        self.baseline.setdefault("metrics", {})
+        self.measured = {}
+        self.update = os.environ.get("PERF_UPDATE_BASELINE", "") not in ("", "0")
+
+    # ------------------------------------------------------------------
+    # Budgets
+
+    def check_budget(self, name, value):
+        """Fails if value exceeds the baseline for name by more than the
+        tolerance. With PERF_UPDATE_BASELINE set, records it instead. value
+        may be monitor output such as "0x1F4"."""
+        value = self.to_number(value)
+        self.measured[name] = value
+        logger.info("%s = %g" % (name, value))
+        if self.update:
+            return
+
+        if name not in self.baseline["metrics"]:
+            raise AssertionError("%s = %g is not in the baseline; record it with "
+                                 "PERF_UPDATE_BASELINE=1" % (name, value))
+        base = self.baseline["metrics"][name]
+        if base is None:
+            raise AssertionError("%s = %g has no recorded baseline; record it with "
+                                 "PERF_UPDATE_BASELINE=1" % (name, value))
+
+        limit = base * (1.0 + self.baseline["tolerance_percent"] / 100.0)
+        if value > limit:
+            raise AssertionError("%s regressed: %g against baseline %g (limit %g)"
+                                 % (name, value, base, limit))
+        if value < base:
+            logger.info("%s improved on baseline %g; consider updating it"
+                        % (name, base))
+
+    @staticmethod
+    def to_number(text):
+        """Parses a number as printed by the monitor or computed in Robot."""
+        if isinstance(text, (int, float)):
+            return float(text)
+        text = str(text).strip()
+        try:
+            return float(int(text, 0))
+        except ValueError:
+            return float(text)
+
+    def ratio(self, numerator, denominator):
+        """numerator / denominator, failing if the denominator is 0."""
+        denominator = self.to_number(denominator)
+        if denominator == 0:
+            raise AssertionError("nothing to divide by: the event never happened")
+        return self.to_number(numerator) / denominator
+
+    def save_baseline(self):
+        """Writes the metrics measured in this run to the baseline file when
+        PERF_UPDATE_BASELINE is set; does nothing otherwise."""
+        if not self.update:
+            return
+        self.baseline["metrics"].update(self.measured)
+        with open(self.path, "w") as handle:
+            json.dump(self.baseline, handle, indent=2, sort_keys=True)
+            handle.write("\n")
+        logger.info("baseline updated with %d metrics" % len(self.measured))
+
+    # ------------------------------------------------------------------
+    # Peripheral access log
+
+    def count_peripheral_accesses(self, log_path):
+        """Returns {peripheral: accesses} from a Renode log file."""
+        counts = {}
+        for match in self._accesses(log_path):
+            name = match.group("periph").split(".")[-1]
+            counts[name] = counts.get(name, 0) + 1
+        return counts
+
+    def count_uart_bytes(self, log_path, uart, tx_offset=0):
+        """Returns (bytes, lines): writes to the UART's transmit register,
+        and how many of them were a newline."""
+        sent = lines = 0
+        for match in self._accesses(log_path):
+            if (match.group("periph").split(".")[-1] == uart
+                    and match.group("dir") == "Write"
+                    and int(match.group("offset"), 16) == int(tx_offset)):
+                sent += 1
+                if int(match.group("value"), 16) & 0xFF == 0x0A:
+                    lines += 1
+        return sent, lines
+
+    @staticmethod
+    def _accesses(log_path):
+        with open(log_path, errors="replace") as handle:
+            for line in handle:
+                match = ACCESS.search(line)
+                if match:
+                    yield match
+
+    # ------------------------------------------------------------------
+    # ELF symbols
+
+    def symbol_address(self, elf, symbol):
+        """Returns the address of symbol as a hex string."""
+        nm = os.environ.get("NM", "riscv64-unknown-elf-nm")
+        output = subprocess.run([nm, elf], check=True, capture_output=True,
+                                text=True).stdout
+        for line in output.splitlines():
+            parts = line.split()
+            if len(parts) == 3 and parts[2] == symbol:
+                return "0x" + parts[0]
+        raise AssertionError("%s not found in %s" % (symbol, elf))
+
+    def return_addresses(self, elf, symbol):
+        """Returns the addresses of the return instructions in symbol."""
+        objdump = os.environ.get("OBJDUMP", "riscv64-unknown-elf-objdump")
+        output = subprocess.run([objdump, "-d", "--no-show-raw-insn",
+                                 "--disassemble=" + symbol, elf],
+                                check=True, capture_output=True, text=True).stdout
+        found = ["0x" + match.group(1) for match in
+                 (RETURNS.match(line) for line in output.splitlines()) if match]
+        if not found:
+            raise AssertionError("no return instruction found in %s" % symbol)
+        return found
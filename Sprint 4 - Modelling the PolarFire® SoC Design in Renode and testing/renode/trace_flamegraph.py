@@ -0,0 +1,259 @@
+#!/usr/bin/env python3
+"""Per-function profile and flamegraph from a Renode execution trace.
+
+Record a trace of each hart of interest from the Renode monitor; the
+PCAndOpcode format lets the cycle estimate tell loads, multiplies and
+divides from other instructions, the PC format only counts instructions:
+
+    sysbus.u54_1 CreateExecutionTracing "t1" @/tmp/u54_1.trace PCAndOpcode
+    emulation RunFor "2"
+    sysbus.u54_1 DisableExecutionTracing
+
+then symbolize it against the image the simulation ran:
+
+    trace_flamegraph.py app.elf u54_1=/tmp/u54_1.trace e51=/tmp/e51.trace \\
+        --folded app.folded --svg app.svg
+
+Each trace line is one executed instruction. The call stack is rebuilt from
+the PC sequence: arriving at the first instruction of a function is a call,
+arriving back in a function already on the stack is a return, so trap
+handlers appear on top of whatever they interrupted. Each instruction is
+charged to every function on the stack (total) and to the innermost one
+(self).
+
+Output is a table per hart of the top functions by estimated cycles, plus,
+if asked for, collapsed stacks ("hart;main;f;g weight" lines, the input of
+flamegraph.pl and speedscope) and a self-contained SVG flamegraph.
+
+Cycle estimates are a rough in-order model (the COST_ constants below; --cpi
+per instruction for PC-only traces); use them to compare functions, not to
+predict wall-clock time.
+"""
+
+import argparse
+import bisect
+import html
+import os
+import re
+import subprocess
+import sys
+import zlib
+
+MAX_DEPTH = 64
+
+# Estimated cycles per instruction class on the U54 and Mi-V pipelines,
+# assuming cache hits.
+COST_LOAD = 2
+COST_JUMP = 2
+COST_MUL = 3
+COST_DIV = 20
+
+HEX = re.compile(r"0x([0-9A-Fa-f]+)")
+
+
+class Symbols:
+    """Function lookup by address, from nm."""
+
+    def __init__(self, elf, nm):
+        output = subprocess.run([nm, "-S", "-n", "--defined-only", elf],
+                                check=True, capture_output=True, text=True).stdout
+        starts, ends, names = [], [], []
+        for line in output.splitlines():
+            parts = line.split()
+            if len(parts) != 4 or parts[2] not in "tTwW":
+                continue
+            start = int(parts[0], 16)
+            starts.append(start)
+            ends.append(start + int(parts[1], 16))
+            names.append(parts[3])
+        self.starts, self.ends, self.names = starts, ends, names
+        self.cache = {}
+
+    def lookup(self, pc):
+        """(name, is_entry) for pc; unknown code is grouped per 4k page."""
+        hit = self.cache.get(pc)
+        if hit is not None:
+            return hit
+        idx = bisect.bisect_right(self.starts, pc) - 1
+        if idx >= 0 and pc < max(self.ends[idx], self.starts[idx] + 1):
+            hit = (self.names[idx], pc == self.starts[idx])
+        else:
+            hit = ("[0x%x]" % (pc & ~0xFFF), False)
+        self.cache[pc] = hit
+        return hit
+
+
+def cycles(opcode, cpi):
+    """Estimated cycles of one instruction, or cpi when it is not known."""
+    if opcode is None:
+        return cpi
+    if opcode & 0x3 != 0x3:
+        # Compressed: c.lw/c.ld and c.lwsp/c.ldsp are loads, c.j/c.jr jumps.
+        quadrant, funct3 = opcode & 0x3, (opcode >> 13) & 0x7
+        if quadrant in (0, 2) and funct3 in (2, 3):
+            return COST_LOAD
+        if (quadrant == 1 and funct3 in (1, 5)) or (quadrant == 2 and funct3 == 4
+                                                     and (opcode >> 2) & 0x1F == 0):
+            return COST_JUMP
+        return 1
+    major = opcode & 0x7F
+    if major in (0x03, 0x07):
+        return COST_LOAD
+    if major in (0x6F, 0x67):
+        return COST_JUMP
+    if major in (0x33, 0x3B) and (opcode >> 25) == 0x01:
+        return COST_DIV if (opcode >> 12) & 0x4 else COST_MUL
+    return 1
+
+
+class Profile:
+    def __init__(self, hart):
+        self.hart = hart
+        self.instructions = 0
+        self.cycles = 0.0
+        self.self_cycles = {}
+        self.total_cycles = {}
+        self.calls = {}
+        self.stacks = {}
+
+
+def profile_trace(hart, path, symbols, cpi):
+    prof = Profile(hart)
+    stack = []
+    current_key = None
+    with open(path, errors="replace") as handle:
+        for line in handle:
+            found = HEX.findall(line)
+            if not found:
+                continue
+            pc = int(found[0], 16)
+            opcode = int(found[1], 16) if len(found) > 1 else None
+            name, entry = symbols.lookup(pc)
+
+            if not stack or name != stack[-1]:
+                if name in stack and not entry:
+                    del stack[stack.index(name) + 1:]      # return
+                else:
+                    if len(stack) >= MAX_DEPTH:
+                        stack = []
+                    stack.append(name)                     # call or trap
+                    if entry:
+                        prof.calls[name] = prof.calls.get(name, 0) + 1
+                current_key = ";".join(stack)
+
+            cost = cycles(opcode, cpi)
+            prof.instructions += 1
+            prof.cycles += cost
+            prof.self_cycles[name] = prof.self_cycles.get(name, 0) + cost
+            for func in set(stack):
+                prof.total_cycles[func] = prof.total_cycles.get(func, 0) + cost
+            prof.stacks[current_key] = prof.stacks.get(current_key, 0) + cost
+    return prof
+
+
+def print_table(prof, top):
+    print("%s: %d instructions, ~%d cycles" % (prof.hart, prof.instructions, prof.cycles))
+    if not prof.cycles:
+        print()
+        return
+    print("  %7s %7s %12s %8s  %s" % ("self%", "total%", "self cyc", "calls", "function"))
+    ranked = sorted(prof.self_cycles.items(), key=lambda item: -item[1])[:top]
+    for name, self_cycles in ranked:
+        print("  %6.1f%% %6.1f%% %12d %8s  %s" % (
+            100.0 * self_cycles / prof.cycles,
+            100.0 * prof.total_cycles.get(name, 0) / prof.cycles,
+            self_cycles, prof.calls.get(name, "-"), name))
+    print()
+
+
+def write_folded(profiles, path):
+    with open(path, "w") as handle:
+        for prof in profiles:
+            for key, weight in sorted(prof.stacks.items()):
+                handle.write("%s;%s %d\n" % (prof.hart, key, round(weight)))
+
+
+def write_svg(profiles, path, title):
+    """Minimal flamegraph: one frame per stack prefix, widths by cycles."""
+    tree = {}
+    for prof in profiles:
+        for key, weight in prof.stacks.items():
+            node = tree
+            for frame in [prof.hart] + key.split(";"):
+                child = node.setdefault(frame, [0.0, {}])
+                child[0] += weight
+                node = child[1]
+
+    total = sum(child[0] for child in tree.values()) or 1.0
+    width, row, top = 1200.0, 16, 40
+    rects = []
+
+    def depth_of(node):
+        return 1 + max((depth_of(child[1]) for child in node.values()), default=0)
+
+    depth = depth_of(tree)
+    height = top + depth * row + 10
+
+    def emit(node, x, level):
+        for name, (weight, children) in sorted(node.items()):
+            w = width * weight / total
+            if w >= 0.5:
+                y = height - 10 - (level + 1) * row
+                hue = 0 if level == 0 else (zlib.crc32(name.encode()) % 40)
+                label = html.escape(name)
+                text = label if w > 7 * len(name) else ""
+                rects.append(
+                    '<g><title>%s (%d cycles, %.1f%%)</title>'
+                    '<rect x="%.1f" y="%d" width="%.1f" height="%d" fill="hsl(%d,80%%,%d%%)"/>'
+                    '<text x="%.1f" y="%d">%s</text></g>'
+                    % (label, weight, 100.0 * weight / total, x, y, w, row - 1,
+                       hue + 10, 60 if level else 75, x + 3, y + row - 4, text))
+            emit(children, x, level + 1)
+            x += w
+
+    emit(tree, 0.0, 0)
+    with open(path, "w") as handle:
+        handle.write('<svg xmlns="http://www.w3.org/2000/svg" width="%d" height="%d" '
+                     'font-family="monospace" font-size="11">\n' % (width, height))
+        handle.write('<text x="%d" y="20" text-anchor="middle" font-size="15">%s</text>\n'
+                     % (width / 2, html.escape(title)))
+        handle.write("\n".join(rects))
+        handle.write("\n</svg>\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="image the simulation ran")
+    parser.add_argument("traces", nargs="+",
+                        help="trace files, as hart=path or path (hart named after the file)")
+    parser.add_argument("--nm", default=os.environ.get("NM", "riscv64-unknown-elf-nm"))
+    parser.add_argument("--cpi", type=float, default=1.0,
+                        help="cycles per instruction when the trace has no opcodes")
+    parser.add_argument("--top", type=int, default=20, help="functions listed per hart")
+    parser.add_argument("--folded", help="write collapsed stacks here")
+    parser.add_argument("--svg", help="write a flamegraph here")
+    args = parser.parse_args()
+
+    symbols = Symbols(args.elf, args.nm)
+    if not symbols.starts:
+        sys.exit("no function symbols in %s" % args.elf)
+
+    profiles = []
+    for spec in args.traces:
+        hart, sep, path = spec.partition("=")
+        if not sep:
+            path = spec
+            hart = os.path.splitext(os.path.basename(spec))[0]
+        profiles.append(profile_trace(hart, path, symbols, args.cpi))
+
+    for prof in profiles:
+        print_table(prof, args.top)
+    if args.folded:
+        write_folded(profiles, args.folded)
+    if args.svg:
+        write_svg(profiles, args.svg, os.path.basename(args.elf))
+
+
+if __name__ == "__main__":
+    main()
@@ -12,13 +12,23 @@
  *
  */
 
-#include <stdio.h>
 #include "mpfs_hal/mss_hal.h"
 #include "drivers/mss/mss_mmuart/mss_uart.h"
 #include "drivers/mss/mss_rtc/mss_rtc.h"
 #include "inc/uart_mapping.h"
+#include "fmt.h"
+#include "console.h"
+#include "irq_plan.h"
 extern struct mss_uart_instance* p_uartmap_u54_1;
 
+/* PLIC priority of each source this hart may take (irq_plan.h). The main
+   loop polls the RTC update flag, so the RTC interrupt is not enabled yet;
+   its class is the one the Sprint10 clock gives it. */
+static const irq_plan_entry_t g_irq_plan[] =
+{
+    { RTC_WAKEUP_PLIC, IRQ_PRIO_DISPLAY, 0u, 0u, 0 },
+};
+
 /* Constant used for setting RTC control register. */
 #define BIT_SET 0x00010000U
 
@@ -28,17 +38,27 @@ extern struct mss_uart_instance* p_uartmap_u54_1;
 uint8_t display_buffer[100];
 
 /* Function prototypes */
-void handle_user_input(void);
-void set_time(void);
-void set_date(void);
-uint8_t get_user_input(void);
+size_t console_rx(uint8_t *buf, size_t size);
+void console_tx(const char *text);
+void cmd_time(console_t *con, uint32_t argc, char *argv[]);
+void cmd_date(console_t *con, uint32_t argc, char *argv[]);
+
+/* Console commands. */
+const console_command_t g_commands[] =
+{
+    { "time", "HH:MM:SS    set the time", cmd_time },
+    { "date", "DD/MM/YYY   set the date", cmd_date },
+};
+
+console_t g_console;
 
 /******************************************************************************
  *  Greeting messages displayed over the UART.
  */
 const uint8_t g_greeting_msg[] =
         "\r\n\r\n\t  ******* PolarFire SoC RTC Time Example *******\n\n\n\r\
-The example project demonstrates the RTC time mode. \r\n\n\n\
+The example project demonstrates the RTC time mode. \r\n\
+Type \"help\" for the list of commands. \r\n\n\n\
 ";
 
 /* Main function for the hart1(U54_1 processor).
@@ -47,6 +67,7 @@ The example project demonstrates the RTC time mode. \r\n\n\n\
 void u54_1(void)
 {
     mss_rtc_calender_t calendar_count;
+    char *p;
 
     /* Clear pending software interrupt in case there was any.
        Enable only the software interrupt so that the E51 core can bring this
@@ -69,7 +90,7 @@ void u54_1(void)
     PLIC_init();
     __enable_irq();
 
-    PLIC_SetPriority(RTC_WAKEUP_PLIC, 2);
+    irq_plan_apply(g_irq_plan, sizeof(g_irq_plan) / sizeof(g_irq_plan[0]));
 
     (void)mss_config_clk_rst(MSS_PERIPH_MMUART_U54_1, (uint8_t)MPFS_HAL_LAST_HART, PERIPHERAL_ON);
     (void)mss_config_clk_rst(MSS_PERIPH_RTC, (uint8_t)MPFS_HAL_LAST_HART, PERIPHERAL_ON);
@@ -92,169 +113,86 @@ void u54_1(void)
     /* Enable RTC to start incrementing. */
     MSS_RTC_start();
 
+    console_init(&g_console, console_rx, console_tx, "rtc> ",
+                 g_commands, sizeof(g_commands) / sizeof(g_commands[0]));
+
     for (;;)
     {
         volatile uint32_t rtc_count_updated;
 
         /* Update displayed time if value read from RTC changed since last read. */
         rtc_count_updated = MSS_RTC_get_update_flag();
-        if (rtc_count_updated)
+        // Hold the seconds line back while a command is being typed
+        if (rtc_count_updated && !console_is_editing(&g_console))
         {
             MSS_RTC_get_calendar_count(&calendar_count);
-            snprintf((char *)display_buffer, sizeof(display_buffer),
-                     "Seconds: %02d",(int)(calendar_count.second));
+            p = (char *)display_buffer;
+            p = fmt_str(p, "Seconds: ");
+            p = fmt_u32(p, calendar_count.second, 2u, '0');
+            p = fmt_str(p, "\r\n");
+            *p = '\0';
 
             MSS_UART_polled_tx_string(p_uartmap_u54_1, display_buffer);
-            MSS_UART_polled_tx_string(p_uartmap_u54_1, "\r\n");
             MSS_RTC_clear_update_flag();
         }
 
-        /* Check for user input to set time or date. */
-        handle_user_input();
+        /* Feed any typed characters to the console; never waits. */
+        console_poll(&g_console);
     }
     /* never return*/
 }
 
-/* Handle user input for setting time or date. */
-/* Handle user input for setting time or date. */
-void handle_user_input(void)
+/* Console I/O on the U54_1 UART. */
+size_t console_rx(uint8_t *buf, size_t size)
 {
-    uint8_t rx_buff[1];
-    size_t rx_size;
-
-    rx_size = MSS_UART_get_rx(p_uartmap_u54_1, rx_buff, sizeof(rx_buff));
-    if (rx_size > 0)
-    {
-        MSS_UART_polled_tx(p_uartmap_u54_1, rx_buff, sizeof(rx_buff));  // Echo back received character
-        switch (rx_buff[0])
-        {
-            case 't':
-                MSS_RTC_stop();
-                set_time();
-                MSS_RTC_start(); // Restart RTC after setting time
-                break;
-            case 'd':
-                MSS_RTC_stop();
-                set_date();
-                MSS_RTC_start(); // Restart RTC after setting date
-                break;
-            default:
-                break;
-        }
-    }
+    return MSS_UART_get_rx(p_uartmap_u54_1, buf, size);
 }
 
-/* Set the time based on user input. */
-void set_time(void)
+void console_tx(const char *text)
 {
-    mss_rtc_calender_t new_calendar_time;
-    uint8_t user_input;
-
-    /* Get hours from user. */
-    MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\rEnter hours (0-23): ");
-    user_input = get_user_input();
-    if (user_input <= 23)
-    {
-        new_calendar_time.hour = user_input;
-
-        /* Get minutes from user. */
-        MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\rEnter minutes (0-59): ");
-        user_input = get_user_input();
-        if (user_input <= 59)
-        {
-            new_calendar_time.minute = user_input;
-
-            /* Get seconds from user. */
-            MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\rEnter seconds (0-59): ");
-            user_input = get_user_input();
-            if (user_input <= 59)
-            {
-                new_calendar_time.second = user_input;
-
-                /* Set the new time. */
-                MSS_RTC_set_calendar_count(&new_calendar_time);
-                MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\rTime set successfully.\n\r");
-            }
-            else
-            {
-                MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\rInvalid seconds input.\n\r");
-            }
-        }
-        else
-        {
-            MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\rInvalid minutes input.\n\r");
-        }
-    }
-    else
-    {
-        MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\rInvalid hours input.\n\r");
-    }
+    MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)text);
 }
 
-/* Set the date based on user input. */
-void set_date(void)
+/* time HH:MM:SS. The date is kept and the RTC keeps running. */
+void cmd_time(console_t *con, uint32_t argc, char *argv[])
 {
+    static const uint32_t min[3] = {0, 0, 0};
+    static const uint32_t max[3] = {23, 59, 59};
+    uint32_t values[3];
     mss_rtc_calender_t new_calendar_time;
-    uint8_t user_input;
-
-    /* Get day from user. */
-    MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\rEnter day (1-31): ");
-    user_input = get_user_input();
-    if (user_input >= 1 && user_input <= 31)
-    {
-        new_calendar_time.day = user_input;
 
-        /* Get month from user. */
-        MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\rEnter month (1-12): ");
-        user_input = get_user_input();
-        if (user_input >= 1 && user_input <= 12)
-        {
-            new_calendar_time.month = user_input;
-
-            /* Get year from user. */
-            MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\rEnter year (0-255): ");
-            user_input = get_user_input();
-            if (user_input >= 0 && user_input <= 255)
-            {
-                new_calendar_time.year = user_input;
-
-                /* Set the new date. */
-                MSS_RTC_set_calendar_count(&new_calendar_time);
-                MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\rDate set successfully.\n\r");
-            }
-            else
-            {
-                MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\rInvalid year input.\n\r");
-            }
-        }
-        else
-        {
-            MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\rInvalid month input.\n\r");
-        }
-    }
-    else
+    if ((argc != 2) || !console_parse_fields(argv[1], ':', 3, min, max, values))
     {
-        MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\rInvalid day input.\n\r");
+        console_print(con, "usage: time HH:MM:SS\r\n");
+        return;
     }
+
+    MSS_RTC_get_calendar_count(&new_calendar_time);
+    new_calendar_time.hour = (uint8_t)values[0];
+    new_calendar_time.minute = (uint8_t)values[1];
+    new_calendar_time.second = (uint8_t)values[2];
+    MSS_RTC_set_calendar_count(&new_calendar_time);
+    console_print(con, "Time set successfully.\r\n");
 }
 
-uint8_t get_user_input(void)
+/* date DD/MM/YYY, year 0-255 as held by the RTC. The time of day is kept. */
+void cmd_date(console_t *con, uint32_t argc, char *argv[])
 {
-    uint8_t rx_buff[2];  // Increase buffer size to handle two characters: one for input and one for '\0'
-    size_t rx_size = 0;
+    static const uint32_t min[3] = {1, 1, 0};
+    static const uint32_t max[3] = {31, 12, 255};
+    uint32_t values[3];
+    mss_rtc_calender_t new_calendar_time;
 
-    // Wait until user input is available and '\r' is not received
-    while (rx_size == 0 || rx_buff[0] != '\r')
+    if ((argc != 2) || !console_parse_fields(argv[1], '/', 3, min, max, values))
     {
-        rx_size = MSS_UART_get_rx(p_uartmap_u54_1, rx_buff, sizeof(rx_buff) - 1);  // Read into buffer, leave space for '\0'
+        console_print(con, "usage: date DD/MM/YYY\r\n");
+        return;
     }
 
-    // Null-terminate the string
-    rx_buff[rx_size] = '\0';
-
-    // Convert ASCII to number
-    uint8_t user_input = 0;
-    sscanf((char *)rx_buff, "%hhu", &user_input);
-
-    return user_input;
+    MSS_RTC_get_calendar_count(&new_calendar_time);
+    new_calendar_time.day = (uint8_t)values[0];
+    new_calendar_time.month = (uint8_t)values[1];
+    new_calendar_time.year = (uint8_t)values[2];
+    MSS_RTC_set_calendar_count(&new_calendar_time);
+    console_print(con, "Date set successfully.\r\n");
 }
@@ -0,0 +1,239 @@
+/*******************************************************************************
+ * @file display_stage.c
+ *
+ * @brief MAX7219 frame builder with predictive staging of the next second.
+ *
+ * See "display_stage.h" for details of how to use this module.
+ */
+
+#include "mpfs_hal/mss_hal.h"
+#include "display_stage.h"
+#include "evtrace.h"
+
+/*------------------------------------------------------------------------------
+  MAX7219 digit registers of the two separators and the decimal point glyph.
+ */
+#define DISPLAY_DP_DIGIT_MIN        0x03u
+#define DISPLAY_DP_DIGIT_HOUR       0x06u
+#define DISPLAY_DP_GLYPH            0x80u
+
+/* 7-segment glyphs for 0-9. */
+static const uint8_t g_digit_glyph[10] =
+        {0x7E, 0x30, 0x6D, 0x79, 0x33, 0x5B, 0x5F, 0x70, 0x7F, 0x7B};
+
+/* MAX7219 digit register for each BCD clock digit, seconds units first. */
+static const uint8_t g_digit_reg[BCD_NUM_DIGITS] =
+        {0x01, 0x02, 0x04, 0x05, 0x07, 0x08};
+
+/*------------------------------------------------------------------------------
+  Frames for one display update.
+ */
+typedef struct display_frame_queue
+{
+    uint16_t frames[DISPLAY_STAGE_MAX_FRAMES];
+    uint32_t count;
+} display_frame_queue_t;
+
+static spi_instance_t * g_spi;
+
+/* Next second, built by display_stage_prepare(). */
+static display_frame_queue_t g_staged;
+static bcd_clock_t g_staged_clock;
+static volatile uint8_t g_staged_ready = 0u;
+
+/* Set by display_stage_commit(), cleared by display_stage_take_committed(). */
+static volatile uint8_t g_committed = 0u;
+static bcd_clock_t g_committed_clock;
+
+static display_latency_stats_t g_stats[DISPLAY_NUM_PATHS];
+
+/*------------------------------------------------------------------------------
+  Local functions.
+ */
+static void build_frames(const bcd_clock_t * clk, uint32_t changed,
+                         display_frame_queue_t * queue);
+static void send_frames(const display_frame_queue_t * queue);
+static void record_latency(uint32_t path, uint64_t edge_mcycle);
+
+/***************************************************************************//**
+ * See "display_stage.h" for details of how to use this function.
+ */
+void display_stage_init(spi_instance_t * spi)
+{
+    uint32_t path;
+
+    g_spi = spi;
+    g_staged_ready = 0u;
+    g_committed = 0u;
+
+    for (path = 0u; path < DISPLAY_NUM_PATHS; path++)
+    {
+        g_stats[path].updates = 0u;
+        g_stats[path].last_cycles = 0u;
+        g_stats[path].min_cycles = UINT32_MAX;
+        g_stats[path].max_cycles = 0u;
+        g_stats[path].total_cycles = 0u;
+    }
+}
+
+/***************************************************************************//**
+ * See "display_stage.h" for details of how to use this function.
+ */
+void display_stage_show(const bcd_clock_t * clk, uint32_t changed,
+                        uint64_t edge_mcycle)
+{
+    display_frame_queue_t queue;
+
+    build_frames(clk, changed, &queue);
+    send_frames(&queue);
+
+    if (0u != edge_mcycle)
+    {
+        record_latency(DISPLAY_PATH_IMMEDIATE, edge_mcycle);
+    }
+}
+
+/***************************************************************************//**
+ * See "display_stage.h" for details of how to use this function.
+ */
+void display_stage_prepare(const bcd_clock_t * current)
+{
+    bcd_clock_t next = *current;
+    uint32_t changed;
+
+    /* Build into the queue with commits held off, then publish it. */
+    g_staged_ready = 0u;
+    __sync_synchronize();
+
+    changed = bcd_clock_tick(&next);
+    build_frames(&next, changed, &g_staged);
+    g_staged_clock = next;
+
+    __sync_synchronize();
+    g_staged_ready = 1u;
+    EVTRACE(EVT_QUEUE_PUSH, g_staged.count);
+}
+
+/***************************************************************************//**
+ * See "display_stage.h" for details of how to use this function.
+ */
+const bcd_clock_t * display_stage_next(void)
+{
+    return &g_staged_clock;
+}
+
+/***************************************************************************//**
+ * See "display_stage.h" for details of how to use this function.
+ */
+void display_stage_discard(void)
+{
+    g_staged_ready = 0u;
+}
+
+/***************************************************************************//**
+ * See "display_stage.h" for details of how to use this function.
+ */
+uint8_t display_stage_commit(uint64_t edge_mcycle)
+{
+    if (0u == g_staged_ready)
+    {
+        return 0u;
+    }
+
+    g_staged_ready = 0u;
+    EVTRACE(EVT_QUEUE_POP, g_staged.count);
+    send_frames(&g_staged);
+    record_latency(DISPLAY_PATH_PREDICTIVE, edge_mcycle);
+
+    g_committed_clock = g_staged_clock;
+    __sync_synchronize();
+    g_committed = 1u;
+
+    return 1u;
+}
+
+/***************************************************************************//**
+ * See "display_stage.h" for details of how to use this function.
+ */
+uint8_t display_stage_take_committed(bcd_clock_t * shown)
+{
+    if (0u == g_committed)
+    {
+        return 0u;
+    }
+
+    *shown = g_committed_clock;
+    g_committed = 0u;
+
+    return 1u;
+}
+
+/***************************************************************************//**
+ * See "display_stage.h" for details of how to use this function.
+ */
+void display_stage_get_stats(uint32_t path, display_latency_stats_t * stats)
+{
+    *stats = g_stats[path];
+}
+
+/*------------------------------------------------------------------------------
+  Turn the changed digits of clk into MAX7219 register writes.
+ */
+static void build_frames(const bcd_clock_t * clk, uint32_t changed,
+                         display_frame_queue_t * queue)
+{
+    uint32_t idx;
+    uint32_t count = 0u;
+
+    for (idx = 0u; idx < BCD_NUM_DIGITS; idx++)
+    {
+        if (changed & (1u << idx))
+        {
+            queue->frames[count++] = (uint16_t)((g_digit_reg[idx] << 8) +
+                    g_digit_glyph[bcd_clock_digit(clk, idx)]);
+        }
+    }
+
+    if (BCD_ALL_DIGITS == (changed & BCD_ALL_DIGITS))
+    {
+        queue->frames[count++] = (uint16_t)((DISPLAY_DP_DIGIT_MIN << 8) + DISPLAY_DP_GLYPH);
+        queue->frames[count++] = (uint16_t)((DISPLAY_DP_DIGIT_HOUR << 8) + DISPLAY_DP_GLYPH);
+    }
+
+    queue->count = count;
+}
+
+static void send_frames(const display_frame_queue_t * queue)
+{
+    uint32_t idx;
+
+    for (idx = 0u; idx < queue->count; idx++)
+    {
+        EVTRACE(EVT_SPI_FRAME_START, queue->frames[idx]);
+        SPI_transfer_frame(g_spi, queue->frames[idx]);
+        EVTRACE(EVT_SPI_FRAME_END, idx);
+    }
+}
+
+/*------------------------------------------------------------------------------
+  SPI_transfer_frame() waits for each frame to complete, so mcycle now is the
+  end of the last frame.
+ */
+static void record_latency(uint32_t path, uint64_t edge_mcycle)
+{
+    display_latency_stats_t * stats = &g_stats[path];
+    uint32_t cycles = (uint32_t)(readmcycle() - edge_mcycle);
+
+    stats->updates++;
+    stats->last_cycles = cycles;
+    stats->total_cycles += cycles;
+
+    if (cycles < stats->min_cycles)
+    {
+        stats->min_cycles = cycles;
+    }
+    if (cycles > stats->max_cycles)
+    {
+        stats->max_cycles = cycles;
+    }
+}
@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * @file display_stage.h
+ *
+ * @brief MAX7219 frame builder with predictive staging of the next second.
+ *
+ * Without staging, the display is only updated after the hart notices the RTC
+ * update flag and has formatted the time and looked up the glyphs, so the
+ * visible change lags the real second by a variable amount.
+ *
+ * In predictive mode the frames for the next second are built during idle time
+ * with display_stage_prepare() and held in a RAM queue. The RTC alarm interrupt
+ * then only has to call display_stage_commit(), which pushes the queued frames
+ * out over CoreSPI.
+ *
+ * Both paths record the latency from the RTC edge to the end of the last SPI
+ * frame, so the two modes can be compared on the console.
+ */
+
+#ifndef DISPLAY_STAGE_H_
+#define DISPLAY_STAGE_H_
+
+#include <stdint.h>
+#include "drivers/fpga_ip/CoreSPI/core_spi.h"
+#include "bcd_clock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+  Six clock digits plus the two separator digits.
+ */
+#define DISPLAY_STAGE_MAX_FRAMES    8u
+
+/*------------------------------------------------------------------------------
+  Latency statistics are kept per update path.
+ */
+#define DISPLAY_PATH_IMMEDIATE      0u
+#define DISPLAY_PATH_PREDICTIVE     1u
+#define DISPLAY_NUM_PATHS           2u
+
+/*------------------------------------------------------------------------------
+  RTC edge to last SPI frame latency, in mcycle ticks.
+ */
+typedef struct display_latency_stats
+{
+    uint32_t updates;
+    uint32_t last_cycles;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+} display_latency_stats_t;
+
+/***************************************************************************//**
+ * display_stage_init() selects the CoreSPI instance driving the MAX7219 and
+ * clears the staged frame and statistics.
+ */
+void display_stage_init(spi_instance_t * spi);
+
+/***************************************************************************//**
+ * display_stage_show() sends the frames for the digits set in changed right
+ * away. A full refresh (BCD_ALL_DIGITS) also rewrites the separators.
+ *
+ * @param edge_mcycle  mcycle at the RTC edge this update belongs to, or 0 if
+ *                     the update should not be counted in the statistics.
+ */
+void display_stage_show(const bcd_clock_t * clk, uint32_t changed,
+                        uint64_t edge_mcycle);
+
+/***************************************************************************//**
+ * display_stage_prepare() builds the frames for the second after current and
+ * queues them for display_stage_commit(). Call it from idle time, after the
+ * display shows current.
+ */
+void display_stage_prepare(const bcd_clock_t * current);
+
+/***************************************************************************//**
+ * display_stage_next() returns the clock value the staged frames will show.
+ */
+const bcd_clock_t * display_stage_next(void);
+
+/***************************************************************************//**
+ * display_stage_discard() drops the staged frames, e.g. when the time is set.
+ */
+void display_stage_discard(void);
+
+/***************************************************************************//**
+ * display_stage_commit() sends the staged frames, if any. Intended to be
+ * called from the RTC interrupt handler.
+ *
+ * @return  1 if frames were sent.
+ */
+uint8_t display_stage_commit(uint64_t edge_mcycle);
+
+/***************************************************************************//**
+ * display_stage_take_committed() reports whether a commit happened since the
+ * last call, and if so copies the clock value now on the display.
+ */
+uint8_t display_stage_take_committed(bcd_clock_t * shown);
+
+/***************************************************************************//**
+ * display_stage_get_stats() returns a copy of the latency statistics for one
+ * of the DISPLAY_PATH_<n> paths.
+ */
+void display_stage_get_stats(uint32_t path, display_latency_stats_t * stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISPLAY_STAGE_H_ */
@@ -1,10 +1,25 @@
-#include <stdio.h>
-#include <string.h>
 #include "mpfs_hal/mss_hal.h"
 #include "drivers/mss/mss_mmuart/mss_uart.h"
 #include "drivers/mss/mss_rtc/mss_rtc.h"
 #include "inc/uart_mapping.h"
 #include "drivers/fpga_ip/CoreSPI/core_spi.h"
+#include "rtc_timestamp.h"
+#include "bcd_clock.h"
+#include "display_stage.h"
+#include "fmt.h"
+#ifdef FMT_BENCH
+#include "fmt_bench.h"
+#endif
+#include "console.h"
+#include "stack_watch.h"
+#include "arena.h"
+#include "telemetry.h"
+#include "sample_prof.h"
+#include "evtrace.h"
+#include "irq_stats.h"
+#include "irq_plan.h"
+#include "irq_affinity.h"
+#include "task_acct.h"
 extern struct mss_uart_instance* p_uartmap_u54_1;
 
 /* Constant used for setting RTC control register. */
@@ -20,31 +35,173 @@ extern struct mss_uart_instance* p_uartmap_u54_1;
 #define RTC_PERIPH_PRESCALER              (1000000u - 1u)
 
 /*------------------------------------------------------------------------------
-  command line interface defines.
+  Display update defines.
+ */
+#define CPU_CYCLES_PER_US   (LIBERO_SETTING_MSS_COREPLEX_CPU_CLK / 1000000u)
+
+/*------------------------------------------------------------------------------
+  Local functions.
+ */
+static void display_greeting(void);
+static void display_time(void);
+static void update_time(const mss_rtc_calender_t *calendar_count);
+static uint32_t tick_clock(const mss_rtc_calender_t *calendar_count);
+static void schedule_next_second(void);
+static void set_predictive_display(uint8_t enable);
+static void display_latency(void);
+static void display_rtc_ts_stats(void);
+static size_t console_rx(uint8_t *buf, size_t size);
+static void console_tx(const char *text);
+static void cmd_time(console_t *con, uint32_t argc, char *argv[]);
+static void cmd_date(console_t *con, uint32_t argc, char *argv[]);
+static void cmd_stats(console_t *con, uint32_t argc, char *argv[]);
+static void cmd_predict(console_t *con, uint32_t argc, char *argv[]);
+#ifdef FMT_BENCH
+static void cmd_bench(console_t *con, uint32_t argc, char *argv[]);
+#endif
+static void cmd_stack(console_t *con, uint32_t argc, char *argv[]);
+static void cmd_mem(console_t *con, uint32_t argc, char *argv[]);
+static void cmd_prof(console_t *con, uint32_t argc, char *argv[]);
+static void cmd_trace(console_t *con, uint32_t argc, char *argv[]);
+static void cmd_irqstat(console_t *con, uint32_t argc, char *argv[]);
+static void cmd_top(console_t *con, uint32_t argc, char *argv[]);
+static void telemetry_write(const uint8_t *buf, size_t len);
+static uint32_t seconds_of_day(const mss_rtc_calender_t *calendar_count);
+
+uint8_t display_buffer[100];
+
+/*------------------------------------------------------------------------------
+  Time of day as BCD digits, advanced once per RTC update.
+ */
+static bcd_clock_t g_clock;
+
+/* UART time line; the clock digits are patched in at TIME_LINE_CLOCK_OFFSET. */
+#define TIME_LINE_CLOCK_OFFSET  15u
+static uint8_t g_time_line[] = " Current Time: 00:00:00\r\n";
+
+/*------------------------------------------------------------------------------
+  Console commands.
+ */
+static const console_command_t g_commands[] =
+{
+    { "time",    "HH:MM:SS      set the time",                    cmd_time    },
+    { "date",    "DD/MM/YY      set the date",                    cmd_date    },
+    { "stats",   "              timestamp and display latency stats", cmd_stats },
+    { "predict", "on|off        predictive display updates",      cmd_predict },
+#ifdef FMT_BENCH
+    { "bench",   "              formatting cost against newlib",  cmd_bench   },
+#endif
+    { "stack",   "              stack high-water marks",          cmd_stack   },
+    { "mem",     "              boot arena usage",                cmd_mem     },
+    { "prof",    "[on|off]      sampling profiler (sample_prof.py)", cmd_prof },
+    { "trace",   "[on|off|clear] event trace dump (evtrace_chrome.py)", cmd_trace },
+    { "irqstat", "[clear]       interrupt counts, cycles and latency", cmd_irqstat },
+    { "top",     "[on|off]      CPU time per task, each second",  cmd_top     },
+};
+
+/*------------------------------------------------------------------------------
+  Objects created once at boot come from this arena rather than the newlib
+  heap. It is in .bss, so everything allocated from it starts zeroed.
  */
-#define INVALID_USER_INPUT  -1
-#define ENTER               0x0D
+#define BOOT_ARENA_SIZE         512u
+ARENA_STORAGE(g_boot_arena_mem, BOOT_ARENA_SIZE);
+static arena_t g_boot_arena;
+
+static console_t *g_console;
 
 /*------------------------------------------------------------------------------
-  Typedefs.
+  Hart stacks as laid out by the MPFS linker script. The symbol names contain
+  '$', so they are bound with asm labels.
  */
-typedef struct menu_item
+extern uint8_t g_stack_bottom_h0[] __asm("__stack_bottom_h0$");
+extern uint8_t g_stack_top_h0[] __asm("__stack_top_h0$");
+extern uint8_t g_stack_bottom_h1[] __asm("__stack_bottom_h1$");
+extern uint8_t g_stack_top_h1[] __asm("__stack_top_h1$");
+extern uint8_t g_stack_bottom_h2[] __asm("__stack_bottom_h2$");
+extern uint8_t g_stack_top_h2[] __asm("__stack_top_h2$");
+extern uint8_t g_stack_bottom_h3[] __asm("__stack_bottom_h3$");
+extern uint8_t g_stack_top_h3[] __asm("__stack_top_h3$");
+extern uint8_t g_stack_bottom_h4[] __asm("__stack_bottom_h4$");
+extern uint8_t g_stack_top_h4[] __asm("__stack_top_h4$");
+
+typedef struct hart_stack
 {
-    uint32_t min;
-    uint32_t max;
-    const char * message;
-} menu_item_t;
+    const char * name;
+    const uint8_t * bottom;
+    const uint8_t * top;
+} hart_stack_t;
 
+static const hart_stack_t g_hart_stacks[] =
+{
+    { "e51  ", g_stack_bottom_h0, g_stack_top_h0 },
+    { "u54_1", g_stack_bottom_h1, g_stack_top_h1 },
+    { "u54_2", g_stack_bottom_h2, g_stack_top_h2 },
+    { "u54_3", g_stack_bottom_h3, g_stack_top_h3 },
+    { "u54_4", g_stack_bottom_h4, g_stack_top_h4 },
+};
+
+/* Harts, by bit, whose stack has been painted; "stack" reports only these. */
+static volatile uint32_t g_painted_stacks = 0u;
+
+/* Stack used by the RTC alarm handler; filled in when built with
+   STACK_WATCH_ISR. */
+static stack_watch_isr_t g_rtc_isr_stack = { "rtc_wakeup", 0u, 0u, 0u, 0u };
+
+/* Calls and run time of each handler on this hart, for "irqstat". */
+static irq_stat_t g_irq_rtc = IRQ_STAT_INIT("rtc_wakeup", RTC_WAKEUP_PLIC, 1u);
+static irq_stat_t g_irq_systick = IRQ_STAT_INIT("systick", IRQ_STAT_TIMER, 1u);
+static irq_stat_t * const g_irq_stats[] = { &g_irq_rtc, &g_irq_systick };
+
+/* The RTC alarm commits the display frames at the second edge, so it is
+   display class; the profiler's timer must not be held off long enough to
+   skew its samples. Neither handler is slow enough to need nesting. */
+static const irq_plan_entry_t g_irq_plan[] =
+{
+    { RTC_WAKEUP_PLIC, IRQ_PRIO_DISPLAY, 0u, 50u * CPU_CYCLES_PER_US, &g_irq_rtc },
+    { IRQ_PLAN_LOCAL, IRQ_PRIO_TIMER, 0u, 100u * CPU_CYCLES_PER_US, &g_irq_systick },
+};
 
 /*------------------------------------------------------------------------------
-  Local functions.
+  CPU time per task on this hart, in windows of one RTC second. "top on"
+  prints each window as it closes.
  */
-static void display_greeting(void);
-static void display_time(mss_rtc_calender_t *seconds_count);
-static void get_time_from_user(void);
-static int32_t get_number_from_user(void);
+#define TASK_IDLE               0u
+#define TASK_RTC                1u
+#define TASK_DISPLAY            2u
+#define TASK_CONSOLE            3u
+#define TASK_TELEMETRY          4u
+#define TASK_IRQ                5u
+#define TASK_COUNT              6u
+
+static const char * const g_task_names[TASK_COUNT] =
+    { "idle", "rtc", "display", "console", "telemetry", "irq" };
+static task_acct_t g_tasks;
+static task_acct_t * const g_task_accts[] = { &g_tasks };
+static uint8_t g_top_on = 0u;
 
-uint8_t display_buffer[100];
+/*------------------------------------------------------------------------------
+  Sampling profiler. The machine timer (the HAL SysTick, HART1_TICK_RATE_MS)
+  samples mepc while "prof on"; the main loop streams the samples as
+  telemetry records on MMUART1 for lib/sample_prof.py. "trace" sends the
+  event trace (evtrace.h) through the same telemetry instance.
+ */
+static sample_prof_t g_prof;
+static telemetry_t g_tlm_prof;
+
+/* Set at each second edge and by "prof off": send the samples that do not
+   fill a record yet. */
+static uint8_t g_prof_flush = 0u;
+
+/*------------------------------------------------------------------------------
+  Predictive display: the next second's frames are staged during idle time and
+  committed from the RTC alarm interrupt at the second edge.
+ */
+static volatile uint8_t g_predictive_display = 1u;
+static volatile uint64_t g_rtc_edge_mcycle = 0u;
+static volatile uint8_t g_rtc_edge_pending = 0u;
+
+/* Time the RTC alarm is set for; written with the alarm masked. */
+static bcd_clock_t g_rtc_alarm;
 
 
 spi_instance_t g_7_seg_core_spi;
@@ -86,8 +243,17 @@ volatile uint8_t g_rx_size = 0U;
 void u54_1(void)
 {
    mss_rtc_calender_t calendar_count;
-   size_t rx_size;
-   uint8_t rx_buff[1];
+
+    /* Paint this hart's stack so "stack" can report how deep it has been.
+       This project only runs code of its own on hart 1; the other harts'
+       stacks are in use by code that does not paint them. */
+    stack_watch_paint((uintptr_t)g_stack_bottom_h1, (uintptr_t)g_stack_top_h1);
+    g_painted_stacks |= (1u << 1);
+
+    /* Boot-time objects; display_time() looks at the console from the start.
+       A failed allocation is reported once the UART is up. */
+    arena_init(&g_boot_arena, "boot", g_boot_arena_mem, sizeof(g_boot_arena_mem));
+    g_console = (console_t *)arena_alloc(&g_boot_arena, sizeof(console_t), 0u);
 
     /* Clear pending software interrupt in case there was any.
      * Enable only the software interrupt so that the E51 core can bring this
@@ -115,7 +281,7 @@ void u54_1(void)
     PLIC_init();
     __enable_irq();
 
-    PLIC_SetPriority(RTC_WAKEUP_PLIC, 2);
+    irq_plan_apply(g_irq_plan, sizeof(g_irq_plan) / sizeof(g_irq_plan[0]));
 
     (void)mss_config_clk_rst(MSS_PERIPH_MMUART_U54_1, (uint8_t) MPFS_HAL_LAST_HART, PERIPHERAL_ON);
     (void)mss_config_clk_rst(MSS_PERIPH_RTC, (uint8_t) MPFS_HAL_LAST_HART, PERIPHERAL_ON);
@@ -130,6 +296,21 @@ void u54_1(void)
             MSS_UART_115200_BAUD,
             MSS_UART_DATA_8_BITS | MSS_UART_NO_PARITY | MSS_UART_ONE_STOP_BIT);
 
+    /* Nothing below can run without the console; say why and stop. */
+    if (NULL == g_console)
+    {
+        MSS_UART_polled_tx_string(p_uartmap_u54_1,
+                (const uint8_t *)"\n\rBoot arena full: raise BOOT_ARENA_SIZE\n\r");
+        for (;;)
+        {
+            __asm("wfi");
+        }
+    }
+
+    telemetry_init(&g_tlm_prof, 1u, telemetry_write);
+    sample_prof_init(&g_prof, 1u);
+    evtrace_sync();
+
     SYSREG->RTC_CLOCK_CR &= ~BIT_SET;
     SYSREG->RTC_CLOCK_CR = LIBERO_SETTING_MSS_EXT_SGMII_REF_CLK / LIBERO_SETTING_MSS_RTC_TOGGLE_CLK;
     SYSREG->RTC_CLOCK_CR |= BIT_SET;
@@ -140,33 +321,77 @@ void u54_1(void)
      /* Enable RTC to start incrementing. */
      MSS_RTC_start();
 
+     /* Interpolate sub-second time between RTC updates using mcycle. */
+     rtc_ts_init(LIBERO_SETTING_MSS_COREPLEX_CPU_CLK);
+
      /* Display greeting message. */
      display_greeting();
 
+     /* Load the BCD clock and draw every digit once. */
+     MSS_RTC_get_calendar_count(&calendar_count);
+     bcd_clock_set(&g_clock, calendar_count.hour, calendar_count.minute,
+                   calendar_count.second);
+     display_stage_init(SPI_INSTANCE);
+     display_stage_show(&g_clock, BCD_ALL_DIGITS, 0u);
+     display_time();
+     schedule_next_second();
+
+     /* The RTC alarm marks each second edge for the display. */
+     MSS_RTC_enable_irq();
+     irq_affinity_set(RTC_WAKEUP_PLIC, 1u, &g_irq_rtc);
+
+     console_init(g_console, console_rx, console_tx, "rtc> ",
+                  g_commands, sizeof(g_commands) / sizeof(g_commands[0]));
+     task_acct_init(&g_tasks, 1u, g_task_names, TASK_COUNT, TASK_IDLE);
+
      /* Display time over UART. */
 
      for (;;)
      {
          volatile uint32_t rtc_count_updated;
 
+         (void)task_acct_switch(&g_tasks, TASK_IDLE);
+
          /* Update displayed time if value read from RTC changed since last read.*/
          rtc_count_updated = MSS_RTC_get_update_flag();
          if(rtc_count_updated)
          {
+             (void)task_acct_switch(&g_tasks, TASK_RTC);
              MSS_RTC_get_calendar_count(&calendar_count);
-             display_time(&calendar_count);
+             rtc_ts_second_edge(seconds_of_day(&calendar_count));
+             update_time(&calendar_count);
              MSS_RTC_clear_update_flag();
+             g_prof_flush = 1u;
+
+             task_acct_sample(&g_tasks);
+             if (g_top_on && !console_is_editing(g_console))
+             {
+                 task_acct_report(g_task_accts, 1u, console_tx);
+             }
          }
 
-         /* Start command line interface if any key is pressed. */
-          rx_size = MSS_UART_get_rx(p_uartmap_u54_1, rx_buff, sizeof(rx_buff));
-          if(rx_size > 0)
-          {
-              if('t' == rx_buff[0])
-              {
-                  get_time_from_user();
-              }
-          }
+         /* Feed any typed characters to the console; never waits. */
+         console_poll(g_console);
+
+         /* Stream profiler samples a full record at a time, and the rest
+            once a second, but not into a line being typed. */
+         if (!console_is_editing(g_console))
+         {
+             if (sample_prof_pending(&g_prof) >= SAMPLE_PROF_PER_RECORD)
+             {
+                 (void)task_acct_switch(&g_tasks, TASK_TELEMETRY);
+                 (void)sample_prof_drain(&g_prof, &g_tlm_prof, 1u);
+             }
+             else if (0u != g_prof_flush)
+             {
+                 g_prof_flush = 0u;
+                 if (0u != sample_prof_pending(&g_prof))
+                 {
+                     (void)task_acct_switch(&g_tasks, TASK_TELEMETRY);
+                     (void)sample_prof_flush(&g_prof, &g_tlm_prof);
+                 }
+             }
+         }
      }
      /* never return*/
 }
@@ -177,125 +402,619 @@ static void display_greeting(void)
     MSS_UART_polled_tx_string(p_uartmap_u54_1,(const uint8_t*)"\n\r\n\r**********************************************************************\n\r");
     MSS_UART_polled_tx_string(p_uartmap_u54_1,(const uint8_t*)"*************** PolarFire SoC Real Time Clock ***************\n\r");
     MSS_UART_polled_tx_string(p_uartmap_u54_1,(const uint8_t*)"**********************************************************************\n\r");
-    MSS_UART_polled_tx_string(p_uartmap_u54_1,(const uint8_t*)"  - Set the RTC time by pressing \"t\" \n\r");
+    MSS_UART_polled_tx_string(p_uartmap_u54_1,(const uint8_t*)"  - Type \"help\" for the list of commands \n\r");
     MSS_UART_polled_tx_string(p_uartmap_u54_1,(const uint8_t*)"----------------------------------------------------------------------\n\r\n\r");
 }
 
 /*------------------------------------------------------------------------------
-  Display time.
+  Seconds since midnight, used as the timestamp service's seconds counter.
  */
-static void display_time(mss_rtc_calender_t *calendar_count) {
-    uint8_t display_buffer[128];
-    snprintf((char *)display_buffer, sizeof(display_buffer), " Current Time: %02d:%02d:%02d\r\n",
-             (int)calendar_count->hour,
-             (int)calendar_count->minute,
-             (int)calendar_count->second);
-    MSS_UART_polled_tx_string(p_uartmap_u54_1, display_buffer);
+static uint32_t seconds_of_day(const mss_rtc_calender_t *calendar_count)
+{
+    return ((uint32_t)calendar_count->hour * 3600u) +
+           ((uint32_t)calendar_count->minute * 60u) +
+           (uint32_t)calendar_count->second;
+}
 
-    uint8_t digit_to_disp[] = {0x7E, 0x30, 0x6D, 0x79, 0x33, 0x5B, 0x5F, 0x70, 0x7F, 0x7B};
+/*------------------------------------------------------------------------------
+  RTC alarm interrupt, raised at the second edge. Commits the staged display
+  frames if predictive mode has one ready, and marks the edge time for the
+  immediate path otherwise. An alarm left pending while update_time() had the
+  source masked is taken as soon as it is unmasked, a second early; it is
+  ignored unless the RTC has reached the time the alarm was set for.
+ */
+uint8_t rtc_wakeup_plic_IRQHandler(void)
+{
+    uint64_t edge_mcycle = readmcycle();
+    uint8_t task;
+    mss_rtc_calender_t now;
 
-    uint8_t sec_units_disp = digit_to_disp[calendar_count->second % 10];
-    uint8_t sec_tens_disp = digit_to_disp[calendar_count->second / 10];
-    uint8_t min_units_disp = digit_to_disp[calendar_count->minute % 10];
-    uint8_t min_tens_disp = digit_to_disp[calendar_count->minute / 10];
-    uint8_t hour_units_disp = digit_to_disp[calendar_count->hour % 10];
-    uint8_t hour_tens_disp = digit_to_disp[calendar_count->hour / 10];
+    IRQ_STATS_ENTER(&g_irq_rtc);
+    task = task_acct_switch(&g_tasks, TASK_IRQ);
+    EVTRACE(EVT_IRQ_ENTER, RTC_WAKEUP_PLIC);
+    STACK_WATCH_ISR_ENTER(&g_rtc_isr_stack);
 
-    uint16_t master_tx_frame;
-    const uint8_t dp = 0x80;
+    MSS_RTC_get_calendar_count(&now);
+    if (bcd_clock_matches(&g_rtc_alarm, now.hour, now.minute, now.second))
+    {
+        (void)display_stage_commit(edge_mcycle);
 
-    master_tx_frame = ((digit1 << 8) + sec_units_disp); // Write sec_units
-    SPI_transfer_frame(SPI_INSTANCE, master_tx_frame);
+        g_rtc_edge_mcycle = edge_mcycle;
+        g_rtc_edge_pending = 1u;
+    }
 
-    master_tx_frame = ((digit2 << 8) + sec_tens_disp);   // Write sec_tens
-    SPI_transfer_frame(SPI_INSTANCE, master_tx_frame);
+    MSS_RTC_clear_irq();
 
-    master_tx_frame = ((digit3 << 8) + dp);  // Write min_units
-    SPI_transfer_frame(SPI_INSTANCE, master_tx_frame);
+    STACK_WATCH_ISR_EXIT(&g_rtc_isr_stack);
+    EVTRACE(EVT_IRQ_EXIT, RTC_WAKEUP_PLIC);
+    (void)task_acct_switch(&g_tasks, task);
+    IRQ_STATS_EXIT(&g_irq_rtc);
+    return EXT_IRQ_KEEP_ENABLED;
+}
 
-    master_tx_frame = ((digit5 << 8) + min_tens_disp);   // Write min_tens
-    SPI_transfer_frame(SPI_INSTANCE, master_tx_frame);
+/*------------------------------------------------------------------------------
+  Display time over UART.
+ */
+static void display_time(void) {
+    /* Hold off while a command is being typed rather than split the line. */
+    if (console_is_editing(g_console))
+    {
+        return;
+    }
 
-    master_tx_frame = ((digit4 << 8) + min_units_disp);  // Write min_units
-    SPI_transfer_frame(SPI_INSTANCE, master_tx_frame);
+    EVTRACE(EVT_FORMAT_BEGIN, 0u);
+    bcd_clock_format(&g_clock, (char *)&g_time_line[TIME_LINE_CLOCK_OFFSET]);
+    EVTRACE(EVT_FORMAT_END, 0u);
+    MSS_UART_polled_tx_string(p_uartmap_u54_1, g_time_line);
+}
 
-    master_tx_frame = ((digit6 << 8) + dp);  // Write min_units
-    SPI_transfer_frame(SPI_INSTANCE, master_tx_frame);
+/*------------------------------------------------------------------------------
+  Handle an RTC update. If the alarm interrupt already put the staged frames
+  on the display only the UART line is left to do, otherwise the changed
+  digits are sent now. The alarm is masked throughout, so its handler cannot
+  use the SPI at the same time or commit frames staged for the next second.
+ */
+static void update_time(const mss_rtc_calender_t *calendar_count)
+{
+    uint64_t edge_mcycle = 0u;
 
-    master_tx_frame = ((digit8 << 8) + hour_tens_disp);  // Write hour_tens
-    SPI_transfer_frame(SPI_INSTANCE, master_tx_frame);
+    EVTRACE(EVT_RTC_TICK, seconds_of_day(calendar_count));
 
-    master_tx_frame = ((digit7 << 8) + hour_units_disp); // Write hour_units
-    SPI_transfer_frame(SPI_INSTANCE, master_tx_frame);
-}
+    PLIC_DisableIRQ(RTC_WAKEUP_PLIC);
+
+    if (g_rtc_edge_pending)
+    {
+        edge_mcycle = g_rtc_edge_mcycle;
+        g_rtc_edge_pending = 0u;
+    }
+
+    (void)task_acct_switch(&g_tasks, TASK_DISPLAY);
+    if (display_stage_take_committed(&g_clock))
+    {
+        if (!bcd_clock_matches(&g_clock, calendar_count->hour,
+                               calendar_count->minute, calendar_count->second))
+        {
+            bcd_clock_set(&g_clock, calendar_count->hour,
+                          calendar_count->minute, calendar_count->second);
+            display_stage_show(&g_clock, BCD_ALL_DIGITS, 0u);
+        }
+    }
+    else
+    {
+        /* The alarm for this edge has not been taken; it must not send
+           anything once it is. */
+        display_stage_discard();
+        display_stage_show(&g_clock, tick_clock(calendar_count), edge_mcycle);
+    }
+    (void)task_acct_switch(&g_tasks, TASK_RTC);
 
+    schedule_next_second();
+    PLIC_EnableIRQ(RTC_WAKEUP_PLIC);
 
+    display_time();
+}
 
 /*------------------------------------------------------------------------------
-  Top level menu.
+  Arm the RTC alarm for the next second and, in predictive mode, stage the
+  frames that will be shown then. Call with the alarm masked.
  */
-static void get_time_from_user(void)
+static void schedule_next_second(void)
 {
-    int32_t user_input;
-    mss_rtc_calender_t new_calendar_time;
+    mss_rtc_calender_t alarm;
+    bcd_clock_t next = g_clock;
 
-    MSS_RTC_get_calendar_count(&new_calendar_time);
+    (void)bcd_clock_tick(&next);
 
-    MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\r\n\rChange time:\n\r Hours: ");
+    /* Drop an alarm for this second that has not been taken yet. */
+    MSS_RTC_clear_irq();
 
-    user_input = get_number_from_user();
-    if((INVALID_USER_INPUT != user_input) && (user_input < 24))
+    if (g_predictive_display)
     {
-        new_calendar_time.hour = (uint8_t)user_input;
-        MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\r Minutes: ");
-        user_input = get_number_from_user();
-        if((INVALID_USER_INPUT != user_input) && (user_input  < 60))
+        uint8_t task = task_acct_switch(&g_tasks, TASK_DISPLAY);
+
+        display_stage_prepare(&g_clock);
+        (void)task_acct_switch(&g_tasks, task);
+    }
+
+    alarm.year = MSS_RTC_CALENDAR_DONT_CARE;
+    alarm.month = MSS_RTC_CALENDAR_DONT_CARE;
+    alarm.day = MSS_RTC_CALENDAR_DONT_CARE;
+    alarm.weekday = MSS_RTC_CALENDAR_DONT_CARE;
+    alarm.week = MSS_RTC_CALENDAR_DONT_CARE;
+    bcd_clock_get(&next, &alarm.hour, &alarm.minute, &alarm.second);
+    g_rtc_alarm = next;
+    MSS_RTC_set_calendar_count_alarm(&alarm);
+}
+
+static void set_predictive_display(uint8_t enable)
+{
+    g_predictive_display = enable;
+
+    if (g_predictive_display)
+    {
+        display_stage_prepare(&g_clock);
+    }
+    else
+    {
+        display_stage_discard();
+    }
+}
+
+/*------------------------------------------------------------------------------
+  Report RTC edge to last SPI frame latency for both update paths. Jitter is
+  the spread between the fastest and slowest update.
+ */
+static void display_latency(void)
+{
+    static const char * const path_name[DISPLAY_NUM_PATHS] = {"immediate ", "predictive"};
+    display_latency_stats_t stats;
+    uint32_t path;
+    char *p;
+
+    for (path = 0u; path < DISPLAY_NUM_PATHS; path++)
+    {
+        display_stage_get_stats(path, &stats);
+
+        p = (char *)display_buffer;
+        p = fmt_str(p, "\n\r ");
+        p = fmt_str(p, path_name[path]);
+        if (0u == stats.updates)
         {
-            new_calendar_time.minute = (uint8_t)user_input;
-            MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\r Seconds: ");
-            user_input = get_number_from_user();
-            if((INVALID_USER_INPUT != user_input) && (user_input < 60))
-            {
-                new_calendar_time.second = (uint8_t)user_input;
-                MSS_RTC_set_calendar_count(&new_calendar_time);
-            }
+            p = fmt_str(p, ": no updates");
         }
+        else
+        {
+            p = fmt_str(p, ": n=");
+            p = fmt_u32(p, stats.updates, 0u, ' ');
+            p = fmt_str(p, " last=");
+            p = fmt_u32(p, stats.last_cycles / CPU_CYCLES_PER_US, 0u, ' ');
+            p = fmt_str(p, "us mean=");
+            p = fmt_u32(p, (uint32_t)(stats.total_cycles / stats.updates) / CPU_CYCLES_PER_US, 0u, ' ');
+            p = fmt_str(p, "us max=");
+            p = fmt_u32(p, stats.max_cycles / CPU_CYCLES_PER_US, 0u, ' ');
+            p = fmt_str(p, "us jitter=");
+            p = fmt_u32(p, (stats.max_cycles - stats.min_cycles) / CPU_CYCLES_PER_US, 0u, ' ');
+            p = fmt_str(p, "us");
+        }
+        *p = '\0';
+        MSS_UART_polled_tx_string(p_uartmap_u54_1, display_buffer);
     }
     MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\r\n\r");
 }
 
 /*------------------------------------------------------------------------------
-  Retrieve a number typed by the user.
+  Advance the BCD clock for an RTC update. Falls back to reloading it from the
+  RTC if the time was set or an update was missed.
+ */
+static uint32_t tick_clock(const mss_rtc_calender_t *calendar_count)
+{
+    uint32_t changed = bcd_clock_tick(&g_clock);
+
+    if (!bcd_clock_matches(&g_clock, calendar_count->hour,
+                           calendar_count->minute, calendar_count->second))
+    {
+        bcd_clock_set(&g_clock, calendar_count->hour,
+                      calendar_count->minute, calendar_count->second);
+        changed = BCD_ALL_DIGITS;
+    }
+
+    return changed;
+}
+
+
+
+/*------------------------------------------------------------------------------
+  Drift filter state of the sub-second timestamp service.
+ */
+static void display_rtc_ts_stats(void)
+{
+    rtc_ts_stats_t stats;
+    char *p;
+
+    rtc_ts_get_stats(&stats);
+
+    p = (char *)display_buffer;
+    p = fmt_str(p, " timestamps: edges=");
+    p = fmt_u32(p, stats.edges, 0u, ' ');
+    p = fmt_str(p, " resyncs=");
+    p = fmt_u32(p, stats.resyncs, 0u, ' ');
+    p = fmt_str(p, " outliers=");
+    p = fmt_u32(p, stats.outliers, 0u, ' ');
+    p = fmt_str(p, " cycles/s=");
+    p = fmt_u32(p, stats.cycles_per_second, 0u, ' ');
+    p = fmt_str(p, " err=");
+    p = fmt_i32(p, stats.last_error_ppm, 0u, ' ');
+    p = fmt_str(p, "ppm\n\r");
+    *p = '\0';
+    MSS_UART_polled_tx_string(p_uartmap_u54_1, display_buffer);
+}
+
+/*------------------------------------------------------------------------------
+  Console I/O on MMUART1.
+ */
+static size_t console_rx(uint8_t *buf, size_t size)
+{
+    size_t count = MSS_UART_get_rx(p_uartmap_u54_1, buf, size);
+    size_t idx;
+
+    /* Polling an idle UART stays idle time; handling input is the console's. */
+    if (0u != count)
+    {
+        (void)task_acct_switch(&g_tasks, TASK_CONSOLE);
+    }
+
+    for (idx = 0u; idx < count; idx++)
+    {
+        EVTRACE(EVT_UART_RX, buf[idx]);
+    }
+
+    return count;
+}
+
+static void console_tx(const char *text)
+{
+    MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)text);
+}
+
+static void telemetry_write(const uint8_t *buf, size_t len)
+{
+    MSS_UART_polled_tx(p_uartmap_u54_1, buf, (uint32_t)len);
+}
+
+/*------------------------------------------------------------------------------
+  Machine timer, only running while the profiler is on.
+ */
+void U54_1_sysTick_IRQHandler(void)
+{
+    uint8_t task;
+
+    IRQ_STATS_ENTER(&g_irq_systick);
+    sample_prof_sample(&g_prof);
+    task = task_acct_switch(&g_tasks, TASK_IRQ);
+    (void)task_acct_switch(&g_tasks, task);
+    IRQ_STATS_EXIT(&g_irq_systick);
+}
+
+/*------------------------------------------------------------------------------
+  time HH:MM:SS. The RTC keeps running; the new time is written in one go.
+ */
+static void cmd_time(console_t *con, uint32_t argc, char *argv[])
+{
+    static const uint32_t min[3] = {0u, 0u, 0u};
+    static const uint32_t max[3] = {23u, 59u, 59u};
+    uint32_t values[3];
+    mss_rtc_calender_t new_calendar_time;
+
+    if ((2u != argc) || !console_parse_fields(argv[1], ':', 3u, min, max, values))
+    {
+        console_print(con, "usage: time HH:MM:SS\r\n");
+        return;
+    }
+
+    /* The staged frames are for a time that is about to change. */
+    display_stage_discard();
+
+    MSS_RTC_get_calendar_count(&new_calendar_time);
+    new_calendar_time.hour = (uint8_t)values[0];
+    new_calendar_time.minute = (uint8_t)values[1];
+    new_calendar_time.second = (uint8_t)values[2];
+    MSS_RTC_set_calendar_count(&new_calendar_time);
+}
+
+/*------------------------------------------------------------------------------
+  date DD/MM/YY.
+ */
+static void cmd_date(console_t *con, uint32_t argc, char *argv[])
+{
+    static const uint32_t min[3] = {1u, 1u, 0u};
+    static const uint32_t max[3] = {31u, 12u, 99u};
+    uint32_t values[3];
+    mss_rtc_calender_t new_calendar_time;
+
+    if ((2u != argc) || !console_parse_fields(argv[1], '/', 3u, min, max, values))
+    {
+        console_print(con, "usage: date DD/MM/YY\r\n");
+        return;
+    }
+
+    MSS_RTC_get_calendar_count(&new_calendar_time);
+    new_calendar_time.day = (uint8_t)values[0];
+    new_calendar_time.month = (uint8_t)values[1];
+    new_calendar_time.year = (uint8_t)values[2];
+    MSS_RTC_set_calendar_count(&new_calendar_time);
+}
+
+static void cmd_stats(console_t *con, uint32_t argc, char *argv[])
+{
+    (void)con;
+    (void)argc;
+    (void)argv;
+
+    display_rtc_ts_stats();
+    display_latency();
+}
+
+/*------------------------------------------------------------------------------
+  predict on|off.
+ */
+static void cmd_predict(console_t *con, uint32_t argc, char *argv[])
+{
+    if ((2u == argc) && ('o' == argv[1][0]) && ('n' == argv[1][1]))
+    {
+        set_predictive_display(1u);
+    }
+    else if ((2u == argc) && ('o' == argv[1][0]) && ('f' == argv[1][1]))
+    {
+        set_predictive_display(0u);
+    }
+    else
+    {
+        console_print(con, "usage: predict on|off\r\n");
+        return;
+    }
+
+    console_print(con, g_predictive_display ? "predictive display on\r\n"
+                                             : "predictive display off\r\n");
+}
+
+/*------------------------------------------------------------------------------
+  prof on|off starts and stops sampling; with no argument, shows the counts.
+ */
+static void cmd_prof(console_t *con, uint32_t argc, char *argv[])
+{
+    char *p;
+
+    if ((2u == argc) && ('o' == argv[1][0]) && ('n' == argv[1][1]))
+    {
+        sample_prof_enable(&g_prof, 1u);
+        (void)SysTick_Config();
+    }
+    else if ((2u == argc) && ('o' == argv[1][0]) && ('f' == argv[1][1]))
+    {
+        clear_csr(mie, MIP_MTIP);
+        sample_prof_enable(&g_prof, 0u);
+        g_prof_flush = 1u;
+    }
+    else if (1u != argc)
+    {
+        console_print(con, "usage: prof [on|off]\r\n");
+        return;
+    }
+
+    p = (char *)display_buffer;
+    p = fmt_str(p, g_prof.enabled ? " profiler on, " : " profiler off, ");
+    p = fmt_u32(p, g_prof.samples, 0u, ' ');
+    p = fmt_str(p, " samples sent, ");
+    p = fmt_u32(p, g_prof.dropped, 0u, ' ');
+    p = fmt_str(p, " dropped\r\n");
+    *p = '\0';
+    console_print(con, (const char *)display_buffer);
+}
+
+/*------------------------------------------------------------------------------
+  trace sends the event trace as telemetry records; on|off starts and stops
+  recording and clear empties the rings.
+ */
+static void cmd_trace(console_t *con, uint32_t argc, char *argv[])
+{
+    char *p;
+
+    if (EVTRACE_CATEGORIES == 0u)
+    {
+        console_print(con, "event trace not built in (EVTRACE_CATEGORIES)\r\n");
+        return;
+    }
+
+    if (1u == argc)
+    {
+        p = (char *)display_buffer;
+        p = fmt_u32(p, evtrace_dump(&g_tlm_prof), 0u, ' ');
+        p = fmt_str(p, " events sent\r\n");
+        *p = '\0';
+        console_print(con, (const char *)display_buffer);
+    }
+    else if ((2u == argc) && ('o' == argv[1][0]) && ('n' == argv[1][1]))
+    {
+        evtrace_enable(1u);
+    }
+    else if ((2u == argc) && ('o' == argv[1][0]) && ('f' == argv[1][1]))
+    {
+        evtrace_enable(0u);
+    }
+    else if ((2u == argc) && ('c' == argv[1][0]))
+    {
+        evtrace_enable(0u);
+        evtrace_clear();
+        evtrace_enable(1u);
+    }
+    else
+    {
+        console_print(con, "usage: trace [on|off|clear]\r\n");
+    }
+}
+
+/*------------------------------------------------------------------------------
+  irqstat lists calls and cycles per interrupt and checks them against the
+  latency targets of the priority plan; irqstat clear zeroes them.
  */
-static int32_t get_number_from_user(void)
+static void cmd_irqstat(console_t *con, uint32_t argc, char *argv[])
 {
-    int32_t user_input = 0;
-    uint8_t rx_buff[1];
-    uint8_t complete = 0;
-    size_t rx_size;
+    uint32_t count = sizeof(g_irq_stats) / sizeof(g_irq_stats[0]);
 
-    while(!complete)
+    if ((2u == argc) && ('c' == argv[1][0]))
+    {
+        irq_stats_clear(g_irq_stats, count);
+    }
+    else if (1u != argc)
+    {
+        console_print(con, "usage: irqstat [clear]\r\n");
+        return;
+    }
+
+    irq_stats_report(g_irq_stats, count, console_tx);
+    (void)irq_plan_check(g_irq_plan, sizeof(g_irq_plan) / sizeof(g_irq_plan[0]),
+                         console_tx);
+}
+
+/*------------------------------------------------------------------------------
+  top shows the last second's CPU time per task; top on|off prints it every
+  second.
+ */
+static void cmd_top(console_t *con, uint32_t argc, char *argv[])
+{
+    if ((2u == argc) && ('o' == argv[1][0]) && ('n' == argv[1][1]))
+    {
+        g_top_on = 1u;
+    }
+    else if ((2u == argc) && ('o' == argv[1][0]) && ('f' == argv[1][1]))
     {
-        rx_size = MSS_UART_get_rx(p_uartmap_u54_1, rx_buff, sizeof(rx_buff));
-        if(rx_size > 0)
+        g_top_on = 0u;
+        return;
+    }
+    else if (1u != argc)
+    {
+        console_print(con, "usage: top [on|off]\r\n");
+        return;
+    }
+
+    task_acct_report(g_task_accts, 1u, console_tx);
+}
+
+/*------------------------------------------------------------------------------
+  Only in builds with FMT_BENCH defined, which also link fmt_bench.c and with
+  it newlib's printf family.
+ */
+#ifdef FMT_BENCH
+static void cmd_bench(console_t *con, uint32_t argc, char *argv[])
+{
+    (void)con;
+    (void)argc;
+    (void)argv;
+
+    fmt_bench_run(console_tx);
+}
+#endif
+
+/*------------------------------------------------------------------------------
+  Deepest use of each painted hart stack since boot, and of the RTC handler.
+ */
+static void cmd_stack(console_t *con, uint32_t argc, char *argv[])
+{
+    uint32_t idx;
+    uint32_t size;
+    uint32_t used;
+    char *p;
+
+    (void)argc;
+    (void)argv;
+
+    for (idx = 0u; idx < (sizeof(g_hart_stacks) / sizeof(g_hart_stacks[0])); idx++)
+    {
+        if (0u == (g_painted_stacks & (1u << idx)))
+        {
+            continue;
+        }
+
+        size = (uint32_t)(g_hart_stacks[idx].top - g_hart_stacks[idx].bottom);
+        used = stack_watch_high_water((uintptr_t)g_hart_stacks[idx].bottom,
+                                      (uintptr_t)g_hart_stacks[idx].top);
+
+        p = (char *)display_buffer;
+        p = fmt_str(p, " ");
+        p = fmt_str(p, g_hart_stacks[idx].name);
+        p = fmt_str(p, " stack ");
+        p = fmt_u32(p, used, 6u, ' ');
+        p = fmt_str(p, " / ");
+        p = fmt_u32(p, size, 0u, ' ');
+        if (used >= size)
+        {
+            /* Every word written: overflowed. */
+            p = fmt_str(p, "  FULL");
+        }
+        else if (stack_watch_overflowed((uintptr_t)g_hart_stacks[idx].bottom))
         {
-            MSS_UART_polled_tx(p_uartmap_u54_1, rx_buff, sizeof(rx_buff));
-            if(ENTER == rx_buff[0])
-            {
-                complete = 1;
-            }
-            else if((rx_buff[0] >= '0') && (rx_buff[0] <= '9'))
-            {
-                user_input = (user_input * 10) + (rx_buff[0] - '0');
-            }
-            else
-            {
-                user_input = INVALID_USER_INPUT;
-                complete = 1;
-            }
+            p = fmt_str(p, "  GUARD HIT");
         }
+        p = fmt_str(p, "\r\n");
+        *p = '\0';
+        console_print(con, (const char *)display_buffer);
+    }
+
+#ifdef STACK_WATCH_ISR
+    p = (char *)display_buffer;
+    p = fmt_str(p, " ");
+    p = fmt_str(p, g_rtc_isr_stack.name);
+    p = fmt_str(p, " handler ");
+    p = fmt_u32(p, g_rtc_isr_stack.max_used, 0u, ' ');
+    p = fmt_str(p, " bytes over ");
+    p = fmt_u32(p, g_rtc_isr_stack.calls, 0u, ' ');
+    p = fmt_str(p, g_rtc_isr_stack.window_full ? " calls, window too small\r\n"
+                                               : " calls\r\n");
+    *p = '\0';
+    console_print(con, (const char *)display_buffer);
+#else
+    console_print(con, " build with STACK_WATCH_ISR for handler stack usage\r\n");
+#endif
+}
+
+/*------------------------------------------------------------------------------
+  "mem": how full the boot arena is, to size BOOT_ARENA_SIZE.
+ */
+static void cmd_mem(console_t *con, uint32_t argc, char *argv[])
+{
+    char *p;
+
+    (void)argc;
+    (void)argv;
+
+    p = (char *)display_buffer;
+    p = fmt_str(p, " ");
+    p = fmt_str(p, g_boot_arena.name);
+    p = fmt_str(p, " arena ");
+    p = fmt_u32(p, arena_used(&g_boot_arena), 6u, ' ');
+    p = fmt_str(p, " / ");
+    p = fmt_u32(p, arena_size(&g_boot_arena), 0u, ' ');
+    p = fmt_str(p, " bytes, peak ");
+    p = fmt_u32(p, g_boot_arena.peak, 0u, ' ');
+    p = fmt_str(p, ", padding ");
+    p = fmt_u32(p, g_boot_arena.padding, 0u, ' ');
+    p = fmt_str(p, ", ");
+    p = fmt_u32(p, g_boot_arena.allocs, 0u, ' ');
+    p = fmt_str(p, " allocs\r\n");
+    *p = '\0';
+    console_print(con, (const char *)display_buffer);
+
+    if (0u != g_boot_arena.failed)
+    {
+        p = (char *)display_buffer;
+        p = fmt_str(p, " ");
+        p = fmt_u32(p, g_boot_arena.failed, 0u, ' ');
+        p = fmt_str(p, " failed, largest ");
+        p = fmt_u32(p, g_boot_arena.max_failed, 0u, ' ');
+        p = fmt_str(p, " bytes\r\n");
+        *p = '\0';
+        console_print(con, (const char *)display_buffer);
     }
-    return user_input;
 }
 
 void init_CoreSPI(void){
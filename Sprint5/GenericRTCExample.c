@@ -1,14 +1,33 @@
+#include "mpfs_hal/mss_hal.h"
 #include "mss_rtc.h"
+#include "rtc_timestamp.h"
 
 int main(void)
 {
-    
+    uint32_t last_count = 0;
+    uint32_t count;
+    rtc_timestamp_t now;
+
     mss_rtc_init(MSS_RTC_BINARY_MODE);    
     mss_rtc_set_time_count(0);    
     mss_rtc_start();
 
+    /* Binary mode counts seconds, which is what the timestamp service wants */
+    rtc_ts_init(LIBERO_SETTING_MSS_COREPLEX_CPU_CLK);
+
     while (1)
     {
+        /* Latch mcycle as soon as the RTC second changes */
+        count = (uint32_t)mss_rtc_get_time_count();
+        if (count != last_count)
+        {
+            rtc_ts_second_edge(count);
+            last_count = count;
+        }
+
+        /* Wall-clock time with microsecond resolution */
+        rtc_ts_now(&now);
+
         //write code to show time on display
     }
 
@@ -0,0 +1,75 @@
+#!/bin/sh
+#
+# Per-region size and usage report for a Mi-V image linked with
+# miv-rv32-envm.Id or miv-rv32-tcm.Id. Every allocated section is counted
+# against the region that holds its run address, and sections loaded from ROM
+# (.data, .sdata, .tcm_text) against the ROM as well, which is where the
+# load images live.
+#
+# Add it as a post-build step in SoftConsole, e.g.
+#     sh ../../Sprint6/miv_size_report.sh ${ProjName}.elf
+# and link with -Wl,--print-memory-usage for the linker's own summary.
+#
+# Usage: Sprint6/miv_size_report.sh image.elf
+#   OBJDUMP  (default riscv64-unknown-elf-objdump)
+#   REGIONS  "name:origin:length ..." (default the miv-rv32-*.Id map)
+
+set -e
+
+ELF=${1:?usage: $0 image.elf}
+OBJDUMP=${OBJDUMP:-riscv64-unknown-elf-objdump}
+REGIONS=${REGIONS:-"rom:0x80000000:0xC000 ram:0x8000C000:0x4000 tcm:0x40000000:0x2000"}
+
+$OBJDUMP -h "$ELF" | awk -v regions="$REGIONS" '
+function hex(s,    n, i, c) {
+    n = 0
+    s = tolower(s)
+    sub(/^0x/, "", s)
+    for (i = 1; i <= length(s); i++) {
+        c = index("0123456789abcdef", substr(s, i, 1)) - 1
+        n = n * 16 + c
+    }
+    return n
+}
+function region_of(addr,    r) {
+    for (r = 1; r <= nreg; r++)
+        if (addr >= origin[r] && addr < origin[r] + len[r])
+            return r
+    return 0
+}
+BEGIN {
+    nreg = split(regions, spec, " ")
+    for (r = 1; r <= nreg; r++) {
+        split(spec[r], f, ":")
+        name[r] = f[1]; origin[r] = hex(f[2]); len[r] = hex(f[3]); used[r] = 0
+    }
+}
+# Section lines: idx name size vma lma offset align, followed by a flags line.
+$1 ~ /^[0-9]+$/ && NF >= 6 {
+    sec = $2; size = hex($3); vma = hex($4); lma = hex($5)
+    getline flags
+    if (flags !~ /ALLOC/ || size == 0)
+        next
+    r = region_of(vma)
+    if (r) {
+        used[r] += size
+        detail[r] = detail[r] sprintf("    %-12s %7d\n", sec, size)
+    }
+    if (lma != vma && flags ~ /LOAD/) {
+        l = region_of(lma)
+        if (l) {
+            used[l] += size
+            detail[l] = detail[l] sprintf("    %-12s %7d  (load image)\n", sec, size)
+        }
+    }
+}
+END {
+    printf "%-8s %8s %8s %6s\n", "region", "used", "size", "use"
+    for (r = 1; r <= nreg; r++) {
+        printf "%-8s %8d %8d %5.1f%%\n", name[r], used[r], len[r], 100.0 * used[r] / len[r]
+        printf "%s", detail[r]
+        if (used[r] > len[r])
+            overflow = 1
+    }
+    exit overflow
+}'
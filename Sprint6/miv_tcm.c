@@ -0,0 +1,39 @@
+/*******************************************************************************
+ * @file miv_tcm.c
+ *
+ * @brief Running hot Mi-V code from the MIV_RV32 TCM.
+ *
+ * See "miv_tcm.h" for details of how to use this module.
+ */
+
+#include <stdint.h>
+#include "miv_tcm.h"
+
+/*------------------------------------------------------------------------------
+  Defined by miv-rv32-tcm.Id and miv-rv32-envm.Id.
+ */
+extern uint32_t __tcm_text_load;
+extern uint32_t __tcm_text_start;
+extern uint32_t __tcm_text_end;
+
+/***************************************************************************//**
+ * See "miv_tcm.h" for details of how to use this function.
+ */
+void miv_tcm_init(void)
+{
+    const uint32_t * load = &__tcm_text_load;
+    uint32_t * dest = &__tcm_text_start;
+
+    /* The section is 16 byte aligned and padded, so whole words can be copied. */
+    while (dest < &__tcm_text_end)
+    {
+        *dest++ = *load++;
+    }
+
+    /* The code was written through the data side. fence.i orders those
+       stores before every later fetch on this hart, whatever the core's
+       fetch path buffers or prefetches; a plain fence only orders data
+       accesses. */
+    __asm volatile ("fence rw, rw" ::: "memory");
+    __asm volatile ("fence.i" ::: "memory");
+}
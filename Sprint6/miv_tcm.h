@@ -0,0 +1,44 @@
+/*******************************************************************************
+ * @file miv_tcm.h
+ *
+ * @brief Running hot Mi-V code from the MIV_RV32 TCM.
+ *
+ * Mark interrupt handlers and other hot code with TCM_TEXT and call
+ * miv_tcm_init() first thing in main(), before interrupts are enabled:
+ *
+ *     void TCM_TEXT SysTick_Handler(void)
+ *     {
+ *         ...
+ *     }
+ *
+ * Linked with miv-rv32-tcm.Id the marked functions run from the TCM. Linked
+ * with miv-rv32-envm.Id they stay in .text and miv_tcm_init() has nothing to
+ * copy, so the same sources build for designs without a TCM.
+ *
+ * Everything a TCM_TEXT function calls still runs from wherever it is linked;
+ * mark the callees too if they are on the hot path.
+ *
+ * miv_tcm_init() ends with a fence.i (Zifencei), which the MIV_RV32 supports.
+ * GCC 12 and later split Zifencei out of the base ISA, so build with
+ * -march=rv32imc_zicsr_zifencei there; older toolchains take -march=rv32imc.
+ */
+
+#ifndef MIV_TCM_H_
+#define MIV_TCM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TCM_TEXT                __attribute__((section(".tcm_text"), noinline))
+
+/***************************************************************************//**
+ * miv_tcm_init() copies the TCM_TEXT code from its load address into the TCM.
+ */
+void miv_tcm_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIV_TCM_H_ */
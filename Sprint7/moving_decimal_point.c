@@ -4,6 +4,8 @@
 #include "core_gpio.h"
 #include "core_uart_apb.h"
 #include "core_spi.h"
+#include "miv_tcm.h"
+#include "sprint7_tick.h"
 #include "string.h"
 #include "stdio.h"
 
@@ -87,10 +89,6 @@ void Software_IRQHandler()
     MRV_clear_soft_irq();
 }
 
-void External_IRQHandler()
-{
-}
-
 void MGEUI_IRQHandler(void)
 {
 }
@@ -127,13 +125,16 @@ void OPSRV_IRQHandler(void)
 {
 }
 
-void SysTick_Handler(void)
+/* Runs from the TCM when linked with miv-rv32-tcm.Id. */
+void TCM_TEXT SysTick_Handler(void)
 {
     static volatile uint32_t val = 9u;
+    uint8_t shown;
+
+    sprint7_tick_begin();
     val ^= 0xFu;
     GPIO_set_outputs(&g_gpio_out, val);
-    UART_polled_tx_string(&g_uart,
-                        (const uint8_t *)"\r\nInternal System Timer Interrupt");
+    shown = count;
 
     /* Drive 7-segment display
      * count0 drives the display value
@@ -339,6 +340,7 @@ void SysTick_Handler(void)
          count=0;
 
     }
+    sprint7_tick_end(val, shown);
 }
 
 /*-------------------------------------------------------------------------//**
@@ -350,6 +352,9 @@ int main(void)
     uint8_t rx_count;
     uint32_t switches;
 
+    /* Before any TCM_TEXT code, including the SysTick handler, can run. */
+    sprint7_tick_init(&g_uart);
+
     UART_init(&g_uart,
               COREUARTAPB0_BASE_ADDR,
               BAUD_VALUE_115200,
@@ -443,7 +448,7 @@ int main(void)
 
     // specify systick timer interrupt interval. Determines speed of LEDs and 7-seg display changing
 //    MRV_systick_config(SYS_CLK_FREQ/4);
-    MRV_systick_config(SYS_CLK_FREQ/2);
+    MRV_systick_config(SYSTICK_PERIOD);
 
     /**************************************************************************
     * Loop
@@ -0,0 +1,107 @@
+/*******************************************************************************
+ * @file sprint7_tick.c
+ *
+ * @brief System timer instrumentation shared by the Sprint7 display demos.
+ *
+ * See "sprint7_tick.h" for details of how to use this module.
+ */
+
+#include "miv_rv32_hal.h"
+#include "hal.h"
+#include "telemetry.h"
+#include "telemetry_records.h"
+#include "irq_stats.h"
+#include "deadline.h"
+#include "stack_watch.h"
+#include "miv_tcm.h"
+#include "sprint7_tick.h"
+
+/* The stack, as laid out by the Sprint6 linker scripts. */
+extern uint32_t __stack_bottom;
+extern uint32_t __stack_top;
+
+static UART_instance_t * g_tick_uart;
+static telemetry_t g_tlm_systick;
+static uint32_t g_tick = 0u;
+
+static irq_stat_t g_irq_external = IRQ_STAT_INIT("external", IRQ_STAT_EXTERNAL, 0u);
+static irq_stat_t g_irq_systick = IRQ_STAT_INIT("systick", IRQ_STAT_TIMER, 0u);
+static irq_stat_t * const g_irq_stats[] = { &g_irq_external, &g_irq_systick };
+
+static deadline_t g_dl_systick = DEADLINE_INIT("systick", 0u, SYSTICK_PERIOD,
+                                               SYSTICK_DEADLINE);
+static deadline_t * const g_deadlines[] = { &g_dl_systick };
+
+static void telemetry_write(const uint8_t * buf, size_t len)
+{
+    UART_send(g_tick_uart, buf, len);
+}
+
+/***************************************************************************//**
+ * See "sprint7_tick.h" for details of how to use this function.
+ */
+void sprint7_tick_init(UART_instance_t * uart)
+{
+    stack_watch_paint((uintptr_t)&__stack_bottom, (uintptr_t)&__stack_top);
+    miv_tcm_init();
+
+    g_tick_uart = uart;
+    telemetry_init(&g_tlm_systick, 0u, telemetry_write);
+}
+
+/***************************************************************************//**
+ * See "sprint7_tick.h" for details of how to use this function.
+ */
+void TCM_TEXT sprint7_tick_begin(void)
+{
+    IRQ_STATS_ENTER(&g_irq_systick);
+    deadline_begin(&g_dl_systick);
+}
+
+/***************************************************************************//**
+ * See "sprint7_tick.h" for details of how to use this function.
+ */
+void TCM_TEXT sprint7_tick_end(uint32_t leds, uint32_t count)
+{
+    deadline_end(&g_dl_systick);
+
+    telemetry_begin(&g_tlm_systick, TLM_SYSTICK);
+    telemetry_put_u32(&g_tlm_systick, g_tick++);
+    telemetry_put_u32(&g_tlm_systick, leds);
+    telemetry_put_u32(&g_tlm_systick, count);
+    (void)telemetry_end(&g_tlm_systick);
+
+    if (0u == (g_tick % SPRINT7_STATS_PERIOD))
+    {
+        irq_stats_send(g_irq_stats, 2u, &g_tlm_systick);
+        deadline_send(g_deadlines, 1u, &g_tlm_systick);
+
+        telemetry_begin(&g_tlm_systick, TLM_STACK);
+        telemetry_put_u32(&g_tlm_systick, 0u);
+        telemetry_put_u32(&g_tlm_systick, sprint7_stack_used());
+        telemetry_put_u32(&g_tlm_systick,
+                          (uint32_t)((uintptr_t)&__stack_top - (uintptr_t)&__stack_bottom));
+        telemetry_put_u32(&g_tlm_systick,
+                          stack_watch_overflowed((uintptr_t)&__stack_bottom));
+        (void)telemetry_end(&g_tlm_systick);
+    }
+
+    /* The HAL reloads the timer once this handler returns. */
+    deadline_reload(&g_dl_systick);
+    IRQ_STATS_EXIT(&g_irq_systick);
+}
+
+/***************************************************************************//**
+ * See "sprint7_tick.h" for details of how to use this function.
+ */
+uint32_t sprint7_stack_used(void)
+{
+    return stack_watch_high_water((uintptr_t)&__stack_bottom,
+                                  (uintptr_t)&__stack_top);
+}
+
+void External_IRQHandler()
+{
+    IRQ_STATS_ENTER(&g_irq_external);
+    IRQ_STATS_EXIT(&g_irq_external);
+}
@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * @file sprint7_tick.h
+ *
+ * @brief System timer instrumentation shared by the Sprint7 display demos.
+ *
+ * Each demo's SysTick_Handler() brackets its display update with
+ * sprint7_tick_begin() and sprint7_tick_end(). Between them they:
+ *
+ *   - count the handler's calls and cycles (irq_stats.h);
+ *   - check the display update against SYSTICK_DEADLINE (deadline.h);
+ *   - send a TLM_SYSTICK record, about a dozen bytes framed, on the UART,
+ *     and every SPRINT7_STATS_PERIOD ticks the interrupt statistics,
+ *     deadline and stack high-water records. Decode the UART with
+ *     lib/telemetry_decode.py.
+ *
+ *     int main(void)
+ *     {
+ *         sprint7_tick_init(&g_uart);
+ *         UART_init(&g_uart, ...);
+ *         ...
+ *         MRV_systick_config(SYSTICK_PERIOD);
+ *     }
+ *
+ *     void TCM_TEXT SysTick_Handler(void)
+ *     {
+ *         sprint7_tick_begin();
+ *         ...update the display...
+ *         sprint7_tick_end(leds, count);
+ *     }
+ *
+ * The telemetry goes out after the deadline window closes: at 115200 baud it
+ * takes about as long as the deadline, so it must not count as the
+ * display's.
+ *
+ * This file also provides External_IRQHandler(), counted in the same
+ * statistics.
+ */
+
+#ifndef SPRINT7_TICK_H_
+#define SPRINT7_TICK_H_
+
+#include <stdint.h>
+#include "hw_platform.h"
+#include "core_uart_apb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+  System timer period, in CPU cycles, and the deadline of each tick: its
+  display update must be out within 1 ms of the tick being due.
+ */
+#define SYSTICK_PERIOD              (SYS_CLK_FREQ / 2u)
+#define SYSTICK_DEADLINE            (SYS_CLK_FREQ / 1000u)
+
+/* Ticks between TLM_IRQ_STATS, TLM_DEADLINE and TLM_STACK records. */
+#define SPRINT7_STATS_PERIOD        16u
+
+/***************************************************************************//**
+ * sprint7_tick_init() paints the stack (stack_watch.h), copies the TCM_TEXT
+ * code into the TCM and sends telemetry on uart. Call it first thing in
+ * main(), before the stack gets deep or any TCM_TEXT code can run; uart can
+ * be initialised after it.
+ */
+void sprint7_tick_init(UART_instance_t * uart);
+
+/***************************************************************************//**
+ * sprint7_tick_begin() opens the handler's statistics and deadline window.
+ * Call it first in SysTick_Handler().
+ */
+void sprint7_tick_begin(void);
+
+/***************************************************************************//**
+ * sprint7_tick_end() closes the deadline window, sends the tick's telemetry
+ * and closes the handler's statistics. Call it last in SysTick_Handler().
+ *
+ * @param leds   value written to the LEDs this tick
+ * @param count  display counter the tick started with
+ */
+void sprint7_tick_end(uint32_t leds, uint32_t count);
+
+/***************************************************************************//**
+ * sprint7_stack_used() returns the deepest the stack has been since
+ * sprint7_tick_init(), in bytes. The Sprint6 linker scripts' STACK_SIZE is
+ * sized from it.
+ */
+uint32_t sprint7_stack_used(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPRINT7_TICK_H_ */
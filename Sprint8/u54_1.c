@@ -1,6 +1,6 @@
-#include <stdio.h>
-#include <string.h>
 #include "inc/common.h"
+#include "fmt.h"
+#include "deadline.h"
 #include "testing_common.h"
 
 
@@ -15,6 +15,7 @@ Type 0  Show hart 1 debug message\r\n\
 Type 1  Show this menu\r\n\
 Type 2  Send message using polled method\r\n\
 Type 3  send message using interrupt method\r\n\
+Type 4  Show system tick deadline misses\r\n\
 ";
 
 const uint8_t polled_message1[] =
@@ -35,6 +36,20 @@ uint8_t tx_buffer[516];
 uint16_t transfer_size;
 uint16_t idx = 0;
 
+/* The LED/PWM cascade runs from the system tick and assumes every tick is
+ * serviced before the next one is due. */
+#define CPU_CYCLES_PER_US       (LIBERO_SETTING_MSS_COREPLEX_CPU_CLK / 1000000u)
+#define SYSTICK_PERIOD          ((LIBERO_SETTING_MSS_COREPLEX_CPU_CLK / 1000u) * HART1_TICK_RATE_MS)
+
+static deadline_t g_dl_systick = DEADLINE_INIT("systick", 0u, SYSTICK_PERIOD,
+                                               SYSTICK_PERIOD);
+static deadline_t * const g_deadlines[] = { &g_dl_systick };
+
+static void print_deadlines(const char *line)
+{
+    MSS_UART_polled_tx_string(&g_mss_uart0_lo, (const uint8_t *)line);
+}
+
 /* Main function for the hart1(U54 processor).
  * Application code running on hart1 is placed here.
  * MMUART1 local interrupt is enabled on hart1.
@@ -47,6 +62,7 @@ void u54_1(void)
     uint64_t mcycle_end = 0U;
     uint64_t delta_mcycle = 0U;
     uint64_t hartid = read_csr(mhartid);
+    char *p;
 
     init_system();
 
@@ -81,10 +97,14 @@ void u54_1(void)
 
                 mcycle_end = readmcycle();
                 delta_mcycle = mcycle_end - mcycle_start;
-                sprintf(info_string1, "hart %ld, %ld delta_mcycle \r\n", hartid,
-                        delta_mcycle);
+                p = (char *)info_string1;
+                p = fmt_str(p, "hart ");
+                p = fmt_u64(p, hartid, 0u, ' ');
+                p = fmt_str(p, ", ");
+                p = fmt_u64(p, delta_mcycle, 0u, ' ');
+                p = fmt_str(p, " delta_mcycle \r\n");
                 MSS_UART_polled_tx(&g_mss_uart0_lo, info_string1,
-                        strlen(info_string1));
+                        (uint32_t)(p - (char *)info_string1));
                 break;
             case '1':
                 /* show menu */
@@ -104,6 +124,10 @@ void u54_1(void)
                 MSS_UART_polled_tx(&g_mss_uart0_lo, intr_message1,
                         sizeof(intr_message1));
                 break;
+            case '4':
+                deadline_report(g_deadlines, 1u, CPU_CYCLES_PER_US,
+                        print_deadlines);
+                break;
 
             default:
                 MSS_UART_polled_tx(&g_mss_uart0_lo, g_rx_buff1,
@@ -127,6 +151,7 @@ uint16_t dual_7_seg_counter = 0;
 
 void U54_1_sysTick_IRQHandler(void)
 {
+    deadline_begin(&g_dl_systick);
     looper += 1;
     if (looper % (systick_loop_divider * 1) == 0){
         if (GPIO_STATES[0] == 0){
@@ -215,4 +240,5 @@ void U54_1_sysTick_IRQHandler(void)
             GPIO_STATES[7] = 0;
         }
     }
+    deadline_end(&g_dl_systick);
 }
@@ -18,22 +18,38 @@
 #include "drivers/mss/mss_rtc/mss_rtc.h"
 #include "inc/uart_mapping.h"
 #include "common.h"
+#include "bcd_clock.h"
+#include "console.h"
+#include "irq_plan.h"
 
 spi_instance_t g_7_seg_core_spi;
 #define SPI_INSTANCE            &g_7_seg_core_spi
 uint16_t master_tx_frame;
 
-uint8_t hour_tens;
-uint8_t hour_units;
-uint8_t min_tens;
-uint8_t min_units;
-uint8_t sec_tens;
-uint8_t sec_units;
-
 uint8_t hex_values[10] = {0x7e, 0x30, 0x6D, 0x79, 0x33, 0x5B, 0x5F, 0x70, 0x7f, 0x73};
 
+/* MAX7219 digit register for each BCD clock digit, seconds units first. */
+const uint8_t bcd_digit_reg[BCD_NUM_DIGITS] = {0x01, 0x02, 0x04, 0x05, 0x07, 0x08};
+
+/* Time of day as BCD digits, advanced once per RTC update. */
+bcd_clock_t g_clock;
+
+/* UART time line; the clock digits are patched in at TIME_LINE_CLOCK_OFFSET. */
+#define TIME_LINE_CLOCK_OFFSET  6u
+uint8_t g_time_line[] = "Time: 00:00:00 \r\n";
+
+void print_changed(uint32_t changed);
+
 extern struct mss_uart_instance* p_uartmap_u54_1;
 
+/* PLIC priority of each source this hart may take (irq_plan.h). The main
+   loop polls the RTC update flag, so the RTC interrupt is not enabled yet;
+   its class is the one the Sprint10 clock gives it. */
+static const irq_plan_entry_t g_irq_plan[] =
+{
+    { RTC_WAKEUP_PLIC, IRQ_PRIO_DISPLAY, 0u, 0u, 0 },
+};
+
 /* Constant used for setting RTC control register. */
 #define BIT_SET 0x00010000U
 
@@ -43,34 +59,31 @@ extern struct mss_uart_instance* p_uartmap_u54_1;
 uint8_t display_buffer[100];
 
 /*------------------------------------------------------------------------------
-  command line interface defines.
+  Command line interface.
  */
-#define INVALID_USER_INPUT  -1
-#define ENTER               0x0D
+size_t console_rx(uint8_t *buf, size_t size);
+void console_tx(const char *text);
+void cmd_time(console_t *con, uint32_t argc, char *argv[]);
 
-/*------------------------------------------------------------------------------
-  Typedefs.
- */
-typedef struct menu_item
+const console_command_t g_commands[] =
 {
-    uint32_t min;
-    uint32_t max;
-    const char * message;
-} menu_item_t;
+    { "time", "HH:MM:SS   set the time", cmd_time },
+};
 
+console_t g_console;
 
 const uint8_t g_greeting_msg[] =
         "\r\n\r\n\t  ******* Polarfire Real Time Clock *******\n\n\n\r\
 The project uses FPGA and MSS to display real time data based on user inputs. The UART\r\n\
-message will be displayed on 7 segment display at each second. \r\n\n\n\
+message will be displayed on 7 segment display at each second. \r\n\
+Type \"help\" for the list of commands. \r\n\n\n\
 ";
 
 void u54_1(void)
 {
 
     mss_rtc_calender_t calendar_count;
-    size_t rx_size;
-    uint8_t rx_buff[1];
+    uint32_t changed;
 
     /* Clear pending software interrupt in case there was any.
        Enable only the software interrupt so that the E51 core can bring this
@@ -93,7 +106,7 @@ void u54_1(void)
     PLIC_init();
     __enable_irq();
 
-    PLIC_SetPriority(RTC_WAKEUP_PLIC, 2);
+    irq_plan_apply(g_irq_plan, sizeof(g_irq_plan) / sizeof(g_irq_plan[0]));
 
     (void)mss_config_clk_rst(MSS_PERIPH_MMUART_U54_1, (uint8_t) MPFS_HAL_LAST_HART, PERIPHERAL_ON);
     (void)mss_config_clk_rst(MSS_PERIPH_RTC, (uint8_t) MPFS_HAL_LAST_HART, PERIPHERAL_ON);
@@ -115,6 +128,15 @@ void u54_1(void)
     /* Enable RTC to start incrementing. */
     MSS_RTC_start();
 
+    /* Set up the display once, then only rewrite digits that change. */
+    MSS_RTC_get_calendar_count(&calendar_count);
+    bcd_clock_set(&g_clock, calendar_count.hour, calendar_count.minute,
+                  calendar_count.second);
+    init_7_seg();
+    print_changed(BCD_ALL_DIGITS);
+
+    console_init(&g_console, console_rx, console_tx, "rtc> ",
+                 g_commands, sizeof(g_commands) / sizeof(g_commands[0]));
 
     for (;;)
     {
@@ -126,93 +148,63 @@ void u54_1(void)
         {
 
             MSS_RTC_get_calendar_count(&calendar_count);
-            uint8_t display_buffer[128];
-
-            hour_tens = (int)calendar_count.hour / 10;
-            hour_units = (int)calendar_count.hour % 10;
-            min_tens = (int)calendar_count.minute / 10;
-            min_units = (int)calendar_count.minute % 10;
-            sec_tens = (int)calendar_count.second / 10;
-            sec_units = (int)calendar_count.second % 10;
-
-            init_7_seg();
-
-            snprintf((char *)display_buffer, sizeof(display_buffer), "Time: %02d:%02d:%02d ",
-                         (int)calendar_count.hour,
-                         (int)calendar_count.minute,
-                         (int)calendar_count.second);
-            MSS_UART_polled_tx_string(p_uartmap_u54_1, display_buffer);
-            MSS_UART_polled_tx_string (p_uartmap_u54_1, "\r\n");
+
+            /* Advance the BCD clock; reload it if the RTC was set meanwhile. */
+            changed = bcd_clock_tick(&g_clock);
+            if (!bcd_clock_matches(&g_clock, calendar_count.hour,
+                                   calendar_count.minute, calendar_count.second))
+            {
+                bcd_clock_set(&g_clock, calendar_count.hour,
+                              calendar_count.minute, calendar_count.second);
+                changed = BCD_ALL_DIGITS;
+            }
+
+            print_changed(changed);
+
+            /* Hold the time line back while a command is being typed. */
+            if (!console_is_editing(&g_console))
+            {
+                bcd_clock_format(&g_clock, (char *)&g_time_line[TIME_LINE_CLOCK_OFFSET]);
+                MSS_UART_polled_tx_string(p_uartmap_u54_1, g_time_line);
+            }
             MSS_RTC_clear_update_flag();
 
 
         }
-        rx_size = MSS_UART_get_rx(p_uartmap_u54_1, rx_buff, sizeof(rx_buff));
-        if(rx_size > 0){
-            get_time_from_user();
-        }
+        /* Feed any typed characters to the console; never waits. */
+        console_poll(&g_console);
     }
 }
 
- void get_time_from_user(void)
+ size_t console_rx(uint8_t *buf, size_t size)
 {
-    int32_t user_input;
-    mss_rtc_calender_t new_calendar_time;
-
-    MSS_RTC_get_calendar_count(&new_calendar_time);
-
-    MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\r\n\rChange time.\n\r Hours: ");
+    return MSS_UART_get_rx(p_uartmap_u54_1, buf, size);
+}
 
-    user_input = get_number_from_user();
-    if((INVALID_USER_INPUT != user_input) && (user_input < 24))
-    {
-        new_calendar_time.hour = (uint8_t)user_input;
-        MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\r Minutes: ");
-        user_input = get_number_from_user();
-        if((INVALID_USER_INPUT != user_input) && (user_input  < 60))
-        {
-            new_calendar_time.minute = (uint8_t)user_input;
-            MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\r Seconds: ");
-            user_input = get_number_from_user();
-            if((INVALID_USER_INPUT != user_input) && (user_input < 60))
-            {
-                new_calendar_time.second = (uint8_t)user_input;
-                MSS_RTC_set_calendar_count(&new_calendar_time);
-            }
-        }
-    }
-    MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)"\n\r\n\r");
+ void console_tx(const char *text)
+{
+    MSS_UART_polled_tx_string(p_uartmap_u54_1, (const uint8_t *)text);
 }
 
-  int32_t get_number_from_user(void)
+ /* time HH:MM:SS. The RTC keeps running; the next update picks it up. */
+ void cmd_time(console_t *con, uint32_t argc, char *argv[])
 {
-    int32_t user_input = 0;
-    uint8_t rx_buff[1];
-    uint8_t complete = 0;
-    size_t rx_size;
+    static const uint32_t min[3] = {0u, 0u, 0u};
+    static const uint32_t max[3] = {23u, 59u, 59u};
+    uint32_t values[3];
+    mss_rtc_calender_t new_calendar_time;
 
-    while(!complete)
+    if((2u != argc) || !console_parse_fields(argv[1], ':', 3u, min, max, values))
     {
-        rx_size = MSS_UART_get_rx(p_uartmap_u54_1, rx_buff, sizeof(rx_buff));
-        if(rx_size > 0)
-        {
-            MSS_UART_polled_tx(p_uartmap_u54_1, rx_buff, sizeof(rx_buff));
-            if(ENTER == rx_buff[0])
-            {
-                complete = 1;
-            }
-            else if((rx_buff[0] >= '0') && (rx_buff[0] <= '9'))
-            {
-                user_input = (user_input * 10) + (rx_buff[0] - '0');
-            }
-            else
-            {
-                user_input = INVALID_USER_INPUT;
-                complete = 1;
-            }
-        }
+        console_print(con, "usage: time HH:MM:SS\r\n");
+        return;
     }
-    return user_input;
+
+    MSS_RTC_get_calendar_count(&new_calendar_time);
+    new_calendar_time.hour = (uint8_t)values[0];
+    new_calendar_time.minute = (uint8_t)values[1];
+    new_calendar_time.second = (uint8_t)values[2];
+    MSS_RTC_set_calendar_count(&new_calendar_time);
 }
 
   void init_7_seg(void){
@@ -248,28 +240,29 @@ void u54_1(void)
       SPI_transfer_frame(SPI_INSTANCE, master_tx_frame);
   }
 
+ /* Write the whole display from g_clock, separators included. */
  void print(void){
 
-         master_tx_frame = (digit8 << 8) + hex_values[hour_tens];
-         SPI_transfer_frame(&g_7_seg_core_spi, master_tx_frame);
-         master_tx_frame = (digit7 << 8) + hex_values[hour_units];
-         SPI_transfer_frame(&g_7_seg_core_spi, master_tx_frame);
-
          master_tx_frame = (digit6 << 8) + dp;
          SPI_transfer_frame(&g_7_seg_core_spi, master_tx_frame);
-
-         master_tx_frame = (digit5 << 8) + hex_values[min_tens];
-         SPI_transfer_frame(&g_7_seg_core_spi, master_tx_frame);
-         master_tx_frame = (digit4 << 8) + hex_values[min_units];
-         SPI_transfer_frame(&g_7_seg_core_spi, master_tx_frame);
-
          master_tx_frame = (digit3 << 8) + dp;
          SPI_transfer_frame(&g_7_seg_core_spi, master_tx_frame);
 
-         master_tx_frame = (digit2 << 8) + hex_values[sec_tens];
-         SPI_transfer_frame(&g_7_seg_core_spi, master_tx_frame);
-         master_tx_frame = (digit1 << 8) + hex_values[sec_units];
-         SPI_transfer_frame(&g_7_seg_core_spi, master_tx_frame);
+         print_changed(BCD_ALL_DIGITS);
 
  }
 
+ /* Send only the digits whose bit is set in changed. */
+ void print_changed(uint32_t changed){
+         uint32_t idx;
+
+         for (idx = 0u; idx < BCD_NUM_DIGITS; idx++)
+         {
+             if (changed & (1u << idx))
+             {
+                 master_tx_frame = (bcd_digit_reg[idx] << 8) +
+                                   hex_values[bcd_clock_digit(&g_clock, idx)];
+                 SPI_transfer_frame(&g_7_seg_core_spi, master_tx_frame);
+             }
+         }
+ }
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * @file arena.c
+ *
+ * @brief Bump arenas with usage statistics.
+ *
+ * See "arena.h" for details of how to use this module.
+ */
+
+#include "arena.h"
+
+/***************************************************************************//**
+ * See "arena.h" for details of how to use this function.
+ */
+void arena_init(arena_t * arena, const char * name, void * storage,
+                size_t size)
+{
+    arena->name = name;
+    arena->base = (uint8_t *)storage;
+    arena->next = arena->base;
+    arena->end = arena->base + size;
+
+    arena->peak = 0u;
+    arena->allocs = 0u;
+    arena->padding = 0u;
+    arena->failed = 0u;
+    arena->max_failed = 0u;
+}
+
+/***************************************************************************//**
+ * See "arena.h" for details of how to use this function.
+ */
+void * arena_alloc(arena_t * arena, size_t size, size_t align)
+{
+    uintptr_t start;
+    uint32_t pad;
+
+    if (0u == align)
+    {
+        align = ARENA_ALIGN;
+    }
+
+    start = ((uintptr_t)arena->next + (align - 1u)) & ~(uintptr_t)(align - 1u);
+    pad = (uint32_t)(start - (uintptr_t)arena->next);
+
+    /* Compare sizes rather than pointers so a huge size cannot wrap. */
+    if ((start > (uintptr_t)arena->end) ||
+        (size > (size_t)((uintptr_t)arena->end - start)))
+    {
+        arena->failed++;
+        if (size > arena->max_failed)
+        {
+            arena->max_failed = (uint32_t)size;
+        }
+        return NULL;
+    }
+
+    arena->next = (uint8_t *)(start + size);
+    arena->padding += pad;
+    arena->allocs++;
+    if (arena_used(arena) > arena->peak)
+    {
+        arena->peak = arena_used(arena);
+    }
+
+    return (void *)start;
+}
+
+/***************************************************************************//**
+ * See "arena.h" for details of how to use this function.
+ */
+void arena_release(arena_t * arena, uint8_t * mark)
+{
+    if ((mark >= arena->base) && (mark <= arena->next))
+    {
+        arena->next = mark;
+    }
+}
@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * @file arena.h
+ *
+ * @brief Bump arenas with usage statistics.
+ *
+ * Objects created once at boot get their memory from here instead of from
+ * malloc(), whose 2k newlib heap is shared with the C library and whose
+ * cost depends on the state of its free lists. An arena works on a static
+ * buffer handed to it at init time and never touches the heap.
+ *
+ * An arena hands out memory by moving a pointer up through its buffer. The
+ * objects are packed with no headers, and arena_alloc() is constant time.
+ * Memory only comes back all at once, with arena_release() to a mark taken
+ * earlier.
+ *
+ *     ARENA_STORAGE(g_boot_mem, 512u);
+ *     static arena_t g_boot;
+ *
+ *     arena_init(&g_boot, "boot", g_boot_mem, sizeof(g_boot_mem));
+ *     con = arena_alloc(&g_boot, sizeof(*con), 0u);
+ *     if (NULL == con) ...raise the size of g_boot_mem...
+ *
+ * An arena does not lock. Give each hart its own, placed in that hart's data
+ * (HART_BSS() in the Blink Lab), and do not allocate from an interrupt
+ * handler.
+ *
+ * The statistics answer the two questions that matter when sizing an arena:
+ * how close the peak came to the limit, and how much of it went to waste in
+ * alignment padding.
+ */
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+  Alignment of arena allocations unless asked otherwise; enough for a
+  uint64_t or a pointer on RV32 and RV64.
+ */
+#define ARENA_ALIGN             8u
+
+/*------------------------------------------------------------------------------
+  Defines a suitably aligned static buffer for an arena of size bytes.
+ */
+#define ARENA_STORAGE(name, size) \
+    static uint64_t name[((size) + sizeof(uint64_t) - 1u) / sizeof(uint64_t)]
+
+typedef struct arena
+{
+    const char * name;
+    uint8_t * base;
+    uint8_t * next;
+    uint8_t * end;
+
+    /* Statistics. */
+    uint32_t peak;          /* most bytes in use at once */
+    uint32_t allocs;
+    uint32_t padding;       /* bytes skipped to align allocations */
+    uint32_t failed;
+    uint32_t max_failed;    /* largest request that did not fit */
+} arena_t;
+
+/***************************************************************************//**
+ * arena_init() hands size bytes of storage to the arena.
+ */
+void arena_init(arena_t * arena, const char * name, void * storage,
+                size_t size);
+
+/***************************************************************************//**
+ * arena_alloc() takes size bytes from the arena.
+ * @param align  power of two alignment of the result, or 0 for ARENA_ALIGN.
+ * @return  the memory, or NULL if there is not enough left.
+ */
+void * arena_alloc(arena_t * arena, size_t size, size_t align);
+
+/***************************************************************************//**
+ * arena_mark() / arena_release() free, in one go, everything allocated from
+ * the arena after the mark was taken, e.g. scratch buffers used during
+ * start-up.
+ */
+static inline uint8_t * arena_mark(const arena_t * arena)
+{
+    return arena->next;
+}
+
+void arena_release(arena_t * arena, uint8_t * mark);
+
+/***************************************************************************//**
+ * arena_used() / arena_size() return the bytes in use and in total.
+ */
+static inline uint32_t arena_used(const arena_t * arena)
+{
+    return (uint32_t)(arena->next - arena->base);
+}
+
+static inline uint32_t arena_size(const arena_t * arena)
+{
+    return (uint32_t)(arena->end - arena->base);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ARENA_H_ */
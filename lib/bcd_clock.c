@@ -0,0 +1,156 @@
+/*******************************************************************************
+ * @file bcd_clock.c
+ *
+ * @brief Time of day kept as packed BCD digits.
+ *
+ * See "bcd_clock.h" for details of how to use this module.
+ */
+
+#include "bcd_clock.h"
+
+#define NIBBLE(d, i)        (((d) >> ((i) * 4u)) & 0xFu)
+
+/*------------------------------------------------------------------------------
+  Local functions.
+ */
+static uint32_t changed_digits(uint32_t before, uint32_t after);
+static uint32_t to_bcd(uint8_t value);
+
+/***************************************************************************//**
+ * See "bcd_clock.h" for details of how to use this function.
+ */
+void bcd_clock_set(bcd_clock_t * clk, uint8_t hour, uint8_t minute,
+                   uint8_t second)
+{
+    clk->digits = (to_bcd(hour) << 16) | (to_bcd(minute) << 8) | to_bcd(second);
+}
+
+/***************************************************************************//**
+ * See "bcd_clock.h" for details of how to use this function.
+ * Each level only runs when the one below it carries, so the common case is a
+ * compare and an add.
+ */
+uint32_t bcd_clock_tick(bcd_clock_t * clk)
+{
+    uint32_t before = clk->digits;
+    uint32_t d = before;
+    uint32_t rollover = 0u;
+
+    if ((d & 0x00000Fu) != 0x000009u)
+    {
+        d += 0x000001u;
+    }
+    else if ((d & 0x0000F0u) != 0x000050u)
+    {
+        d = (d & ~0x00000Fu) + 0x000010u;
+    }
+    else if ((d & 0x000F00u) != 0x000900u)
+    {
+        d = (d & ~0x0000FFu) + 0x000100u;
+    }
+    else if ((d & 0x00F000u) != 0x005000u)
+    {
+        d = (d & ~0x000FFFu) + 0x001000u;
+    }
+    else if ((d & 0xFF0000u) == 0x230000u)
+    {
+        d = 0u;
+        rollover = BCD_DAY_ROLLOVER;
+    }
+    else if ((d & 0x0F0000u) != 0x090000u)
+    {
+        d = (d & ~0x00FFFFu) + 0x010000u;
+    }
+    else
+    {
+        d = (d & ~0x0FFFFFu) + 0x100000u;
+    }
+
+    clk->digits = d;
+
+    return changed_digits(before, d) | rollover;
+}
+
+/***************************************************************************//**
+ * See "bcd_clock.h" for details of how to use this function.
+ */
+uint8_t bcd_clock_matches(const bcd_clock_t * clk, uint8_t hour,
+                          uint8_t minute, uint8_t second)
+{
+    uint8_t h;
+    uint8_t m;
+    uint8_t s;
+
+    bcd_clock_get(clk, &h, &m, &s);
+
+    return (uint8_t)((s == second) && (m == minute) && (h == hour));
+}
+
+/***************************************************************************//**
+ * See "bcd_clock.h" for details of how to use this function.
+ */
+void bcd_clock_get(const bcd_clock_t * clk, uint8_t * hour, uint8_t * minute,
+                   uint8_t * second)
+{
+    uint32_t d = clk->digits;
+
+    /* x * 10 == (x << 3) + (x << 1); no divider needed */
+    *second = (uint8_t)((NIBBLE(d, BCD_SEC_TENS) << 3) +
+                        (NIBBLE(d, BCD_SEC_TENS) << 1) + NIBBLE(d, BCD_SEC_UNITS));
+    *minute = (uint8_t)((NIBBLE(d, BCD_MIN_TENS) << 3) +
+                        (NIBBLE(d, BCD_MIN_TENS) << 1) + NIBBLE(d, BCD_MIN_UNITS));
+    *hour = (uint8_t)((NIBBLE(d, BCD_HOUR_TENS) << 3) +
+                      (NIBBLE(d, BCD_HOUR_TENS) << 1) + NIBBLE(d, BCD_HOUR_UNITS));
+}
+
+/***************************************************************************//**
+ * See "bcd_clock.h" for details of how to use this function.
+ */
+void bcd_clock_format(const bcd_clock_t * clk, char * buf)
+{
+    uint32_t d = clk->digits;
+
+    buf[0] = (char)('0' + NIBBLE(d, BCD_HOUR_TENS));
+    buf[1] = (char)('0' + NIBBLE(d, BCD_HOUR_UNITS));
+    buf[2] = ':';
+    buf[3] = (char)('0' + NIBBLE(d, BCD_MIN_TENS));
+    buf[4] = (char)('0' + NIBBLE(d, BCD_MIN_UNITS));
+    buf[5] = ':';
+    buf[6] = (char)('0' + NIBBLE(d, BCD_SEC_TENS));
+    buf[7] = (char)('0' + NIBBLE(d, BCD_SEC_UNITS));
+}
+
+/*------------------------------------------------------------------------------
+  Fold each differing nibble down to one bit and pack the bits together.
+ */
+static uint32_t changed_digits(uint32_t before, uint32_t after)
+{
+    uint32_t x = before ^ after;
+
+    x |= x >> 1;
+    x |= x >> 2;
+    x &= 0x111111u;
+
+    return ((x      ) & 0x01u) |
+           ((x >>  3) & 0x02u) |
+           ((x >>  6) & 0x04u) |
+           ((x >>  9) & 0x08u) |
+           ((x >> 12) & 0x10u) |
+           ((x >> 15) & 0x20u);
+}
+
+/*------------------------------------------------------------------------------
+  Binary 0-99 to two BCD digits by repeated subtraction.
+ */
+static uint32_t to_bcd(uint8_t value)
+{
+    uint32_t tens = 0u;
+
+    while (value >= 10u)
+    {
+        value -= 10u;
+        tens++;
+    }
+
+    return (tens << 4) | value;
+}
@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * @file bcd_clock.h
+ *
+ * @brief Time of day kept as packed BCD digits.
+ *
+ * The clock is advanced once per RTC second with a BCD increment and carry,
+ * so the digits for the 7-segment display and the UART text never have to be
+ * recomputed with divisions or snprintf(). Each tick returns a bitmask of the
+ * digits that changed, which lets the display only send the frames it needs.
+ *
+ * Packed layout, one nibble per digit:
+ *
+ *   bits 23:20  hour tens      bits 19:16  hour units
+ *   bits 15:12  minute tens    bits 11:8   minute units
+ *   bits 7:4    second tens    bits 3:0    second units
+ */
+
+#ifndef BCD_CLOCK_H_
+#define BCD_CLOCK_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+  Digit indexes. Also the bit positions in the changed-digit mask.
+ */
+#define BCD_SEC_UNITS           0u
+#define BCD_SEC_TENS            1u
+#define BCD_MIN_UNITS           2u
+#define BCD_MIN_TENS            3u
+#define BCD_HOUR_UNITS          4u
+#define BCD_HOUR_TENS           5u
+#define BCD_NUM_DIGITS          6u
+
+#define BCD_ALL_DIGITS          0x3Fu
+
+/*------------------------------------------------------------------------------
+  Set in the mask returned by bcd_clock_tick() when 23:59:59 wraps to 00:00:00.
+ */
+#define BCD_DAY_ROLLOVER        0x40u
+
+/*------------------------------------------------------------------------------
+  Length of the "HH:MM:SS" text written by bcd_clock_format(), without the
+  terminating NUL.
+ */
+#define BCD_CLOCK_TEXT_LEN      8u
+
+typedef struct bcd_clock
+{
+    uint32_t digits;    /* packed BCD, see layout above */
+} bcd_clock_t;
+
+/***************************************************************************//**
+ * bcd_clock_set() loads the clock from binary hours, minutes and seconds.
+ * This is only done when the time is set or re-synchronised, so it is allowed
+ * to be slower than bcd_clock_tick().
+ */
+void bcd_clock_set(bcd_clock_t * clk, uint8_t hour, uint8_t minute,
+                   uint8_t second);
+
+/***************************************************************************//**
+ * bcd_clock_tick() advances the clock by one second.
+ *
+ * @return  Mask of BCD_<digit> bits for the digits that changed, plus
+ *          BCD_DAY_ROLLOVER at midnight.
+ */
+uint32_t bcd_clock_tick(bcd_clock_t * clk);
+
+/***************************************************************************//**
+ * bcd_clock_matches() checks the clock against binary RTC values without
+ * dividing, so the caller can detect that the RTC was set or an update was
+ * missed and re-synchronise with bcd_clock_set().
+ */
+uint8_t bcd_clock_matches(const bcd_clock_t * clk, uint8_t hour,
+                          uint8_t minute, uint8_t second);
+
+/***************************************************************************//**
+ * bcd_clock_get() converts the clock back to binary hours, minutes and
+ * seconds, using shifts and adds only.
+ */
+void bcd_clock_get(const bcd_clock_t * clk, uint8_t * hour, uint8_t * minute,
+                   uint8_t * second);
+
+/***************************************************************************//**
+ * bcd_clock_format() writes "HH:MM:SS" into buf. buf must hold at least
+ * BCD_CLOCK_TEXT_LEN characters; no NUL terminator is written so the text can
+ * be patched into a larger, preformatted line.
+ */
+void bcd_clock_format(const bcd_clock_t * clk, char * buf);
+
+/***************************************************************************//**
+ * bcd_clock_digit() returns one digit (0-9) of the clock.
+ */
+static inline uint8_t bcd_clock_digit(const bcd_clock_t * clk, uint32_t index)
+{
+    return (uint8_t)((clk->digits >> (index * 4u)) & 0xFu);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BCD_CLOCK_H_ */
@@ -0,0 +1,263 @@
+/*******************************************************************************
+ * @file console.c
+ *
+ * @brief Non-blocking command-table console.
+ *
+ * See "console.h" for details of how to use this module.
+ */
+
+#include "console.h"
+#include "coroutine.h"
+#include "fmt.h"
+
+#define KEY_CTRL_C          0x03u
+#define KEY_BACKSPACE       0x08u
+#define KEY_LF              0x0Au
+#define KEY_CR              0x0Du
+#define KEY_CTRL_U          0x15u
+#define KEY_ESC             0x1Bu
+#define KEY_DEL             0x7Fu
+
+/* Bytes taken from the UART per console_poll() call. */
+#define CONSOLE_RX_CHUNK    16u
+
+/*------------------------------------------------------------------------------
+  Local functions.
+ */
+static void editor_feed(console_t * con);
+static void run_line(console_t * con);
+static void print_help(console_t * con);
+
+/***************************************************************************//**
+ * See "console.h" for details of how to use this function.
+ */
+void console_init(console_t * con, console_rx_t rx, console_tx_t tx,
+                  const char * prompt, const console_command_t * commands,
+                  uint32_t num_commands)
+{
+    con->rx = rx;
+    con->tx = tx;
+    con->prompt = prompt;
+    con->commands = commands;
+    con->num_commands = num_commands;
+    con->len = 0u;
+    CO_RESET(con->co_state);
+
+    con->tx(con->prompt);
+}
+
+/***************************************************************************//**
+ * See "console.h" for details of how to use this function.
+ */
+void console_poll(console_t * con)
+{
+    uint8_t rx_buff[CONSOLE_RX_CHUNK];
+    size_t rx_size;
+    size_t idx;
+
+    rx_size = con->rx(rx_buff, sizeof(rx_buff));
+
+    for (idx = 0u; idx < rx_size; idx++)
+    {
+        con->byte = rx_buff[idx];
+        editor_feed(con);
+    }
+}
+
+/***************************************************************************//**
+ * See "console.h" for details of how to use this function.
+ */
+void console_print(console_t * con, const char * text)
+{
+    con->tx(text);
+}
+
+/***************************************************************************//**
+ * See "console.h" for details of how to use this function.
+ */
+uint8_t console_parse_fields(const char * arg, char sep, uint32_t count,
+                             const uint32_t * min, const uint32_t * max,
+                             uint32_t * values)
+{
+    uint32_t idx;
+    uint32_t used;
+
+    for (idx = 0u; idx < count; idx++)
+    {
+        used = fmt_parse_u32(arg, &values[idx]);
+        if ((0u == used) || (values[idx] < min[idx]) || (values[idx] > max[idx]))
+        {
+            return 0u;
+        }
+        arg += used;
+
+        if (idx < (count - 1u))
+        {
+            if (*arg != sep)
+            {
+                return 0u;
+            }
+            arg++;
+        }
+    }
+
+    return (uint8_t)('\0' == *arg);
+}
+
+/*------------------------------------------------------------------------------
+  Line editor. Resumed once per received byte, in con->byte; each CO_YIELD()
+  waits for the next one.
+ */
+static void editor_feed(console_t * con)
+{
+    CO_BEGIN(con->co_state);
+
+    for (;;)
+    {
+        if (KEY_ESC == con->byte)
+        {
+            /* ESC [ <parameters> <final byte 0x40-0x7E>, or ESC <one byte>. */
+            CO_YIELD(con->co_state);
+            if ('[' == con->byte)
+            {
+                do
+                {
+                    CO_YIELD(con->co_state);
+                } while ((con->byte < 0x40u) || (con->byte > 0x7Eu));
+            }
+        }
+        else if ((KEY_CR == con->byte) || (KEY_LF == con->byte))
+        {
+            con->tx("\r\n");
+            con->line[con->len] = '\0';
+            run_line(con);
+            con->len = 0u;
+            con->tx(con->prompt);
+
+            /* Swallow the LF of a CR LF pair so it is not an empty line. */
+            if (KEY_CR == con->byte)
+            {
+                CO_YIELD(con->co_state);
+                if (KEY_LF == con->byte)
+                {
+                    CO_YIELD(con->co_state);
+                }
+                continue;
+            }
+        }
+        else if ((KEY_BACKSPACE == con->byte) || (KEY_DEL == con->byte))
+        {
+            if (con->len > 0u)
+            {
+                con->len--;
+                con->tx("\b \b");
+            }
+        }
+        else if ((KEY_CTRL_C == con->byte) || (KEY_CTRL_U == con->byte))
+        {
+            con->len = 0u;
+            con->tx("^C\r\n");
+            con->tx(con->prompt);
+        }
+        else if ((con->byte >= 0x20u) && (con->byte < 0x7Fu))
+        {
+            if (con->len < (CONSOLE_LINE_MAX - 1u))
+            {
+                char echo[2];
+
+                con->line[con->len++] = (char)con->byte;
+                echo[0] = (char)con->byte;
+                echo[1] = '\0';
+                con->tx(echo);
+            }
+        }
+        else
+        {
+            /* Other control characters are ignored. */
+        }
+
+        CO_YIELD(con->co_state);
+    }
+
+    CO_END(con->co_state);
+}
+
+/*------------------------------------------------------------------------------
+  Split the line into arguments in place and run the matching command.
+ */
+static void run_line(console_t * con)
+{
+    char * argv[CONSOLE_MAX_ARGS];
+    uint32_t argc = 0u;
+    char * p = con->line;
+    uint32_t idx;
+    const char * a;
+    const char * b;
+
+    while ('\0' != *p)
+    {
+        while (' ' == *p)
+        {
+            *p++ = '\0';
+        }
+        if ('\0' == *p)
+        {
+            break;
+        }
+        if (argc == CONSOLE_MAX_ARGS)
+        {
+            con->tx("too many arguments\r\n");
+            return;
+        }
+        argv[argc++] = p;
+        while (('\0' != *p) && (' ' != *p))
+        {
+            p++;
+        }
+    }
+
+    if (0u == argc)
+    {
+        return;
+    }
+
+    for (idx = 0u; idx < con->num_commands; idx++)
+    {
+        a = con->commands[idx].name;
+        b = argv[0];
+        while (('\0' != *a) && (*a == *b))
+        {
+            a++;
+            b++;
+        }
+        if (*a == *b)
+        {
+            con->commands[idx].handler(con, argc, argv);
+            return;
+        }
+    }
+
+    if (('h' == argv[0][0]) && ('e' == argv[0][1]) && ('l' == argv[0][2]) &&
+        ('p' == argv[0][3]) && ('\0' == argv[0][4]))
+    {
+        print_help(con);
+        return;
+    }
+
+    con->tx("unknown command, try \"help\"\r\n");
+}
+
+static void print_help(console_t * con)
+{
+    uint32_t idx;
+
+    for (idx = 0u; idx < con->num_commands; idx++)
+    {
+        con->tx("  ");
+        con->tx(con->commands[idx].name);
+        con->tx(" ");
+        con->tx(con->commands[idx].usage);
+        con->tx("\r\n");
+    }
+    con->tx("  help\r\n");
+}
@@ -0,0 +1,113 @@
+/*******************************************************************************
+ * @file console.h
+ *
+ * @brief Non-blocking command-table console.
+ *
+ * The application registers a table of commands and calls console_poll() from
+ * its main loop. console_poll() takes whatever bytes the UART already has,
+ * feeds them to the line editor and returns straight away; a command handler
+ * only runs once a whole line has been entered. The main loop therefore never
+ * waits for a human, and the RTC keeps running while a time is typed in.
+ *
+ * The line editor is a stackless coroutine (see coroutine.h): its position in
+ * the input grammar, e.g. half way through an escape sequence, is kept in the
+ * console instance rather than on the stack, so it can be resumed one byte at
+ * a time.
+ *
+ * Editing keys: Backspace/DEL delete, Ctrl-C or Ctrl-U discard the line, Enter
+ * runs it. ANSI escape sequences (arrow keys etc.) are swallowed.
+ */
+
+#ifndef CONSOLE_H_
+#define CONSOLE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONSOLE_LINE_MAX        48u
+#define CONSOLE_MAX_ARGS        6u
+
+/*------------------------------------------------------------------------------
+  Byte source and sink. rx returns the number of bytes copied into buf and must
+  not block; tx sends a NUL terminated string.
+ */
+typedef size_t (*console_rx_t)(uint8_t * buf, size_t size);
+typedef void (*console_tx_t)(const char * text);
+
+struct console;
+
+/*------------------------------------------------------------------------------
+  Command handler. argv[0] is the command name.
+ */
+typedef void (*console_handler_t)(struct console * con, uint32_t argc,
+                                  char * argv[]);
+
+typedef struct console_command
+{
+    const char * name;
+    const char * usage;     /* arguments and description, shown by "help" */
+    console_handler_t handler;
+} console_command_t;
+
+typedef struct console
+{
+    console_rx_t rx;
+    console_tx_t tx;
+    const char * prompt;
+    const console_command_t * commands;
+    uint32_t num_commands;
+
+    /* Line editor coroutine state. */
+    uint32_t co_state;
+    uint8_t byte;
+    uint32_t len;
+    char line[CONSOLE_LINE_MAX];
+} console_t;
+
+/***************************************************************************//**
+ * console_init() sets up a console instance and prints the first prompt.
+ * A "help" command listing the table is always available.
+ */
+void console_init(console_t * con, console_rx_t rx, console_tx_t tx,
+                  const char * prompt, const console_command_t * commands,
+                  uint32_t num_commands);
+
+/***************************************************************************//**
+ * console_poll() processes the bytes that are ready and returns. Command
+ * handlers run from inside this call.
+ */
+void console_poll(console_t * con);
+
+/***************************************************************************//**
+ * console_is_editing() returns 1 while a partly typed line is on the terminal,
+ * so periodic output can hold off instead of splitting the line.
+ */
+static inline uint8_t console_is_editing(const console_t * con)
+{
+    return (uint8_t)(con->len > 0u);
+}
+
+/***************************************************************************//**
+ * console_print() sends text to the console's terminal.
+ */
+void console_print(console_t * con, const char * text);
+
+/***************************************************************************//**
+ * console_parse_fields() parses count unsigned numbers separated by sep, e.g.
+ * "12:34:56" with sep ':'. Each value is range checked against min[i]/max[i].
+ *
+ * @return  1 if the whole argument parsed and every value is in range.
+ */
+uint8_t console_parse_fields(const char * arg, char sep, uint32_t count,
+                             const uint32_t * min, const uint32_t * max,
+                             uint32_t * values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONSOLE_H_ */
@@ -0,0 +1,43 @@
+/*******************************************************************************
+ * @file coroutine.h
+ *
+ * @brief Stackless coroutines for byte-at-a-time state machines.
+ *
+ * The resume point is stored in a uint32_t owned by the caller, so a function
+ * can stop in the middle of a loop, return, and carry on from the same place
+ * on the next call without keeping a stack of its own. Locals do not survive a
+ * CO_YIELD(); keep state in the object that holds the resume point.
+ *
+ *     uint32_t co = 0;
+ *
+ *     void feed(uint8_t c)
+ *     {
+ *         CO_BEGIN(co);
+ *         for (;;)
+ *         {
+ *             if (c == 0x1B)
+ *             {
+ *                 CO_YIELD(co);       (wait for the byte after ESC)
+ *                 ...
+ *             }
+ *             CO_YIELD(co);
+ *         }
+ *         CO_END(co);
+ *     }
+ *
+ * CO_YIELD() must not be used inside a switch statement of its own.
+ */
+
+#ifndef COROUTINE_H_
+#define COROUTINE_H_
+
+#define CO_BEGIN(state)     switch (state) { case 0u:
+
+#define CO_YIELD(state)     do { (state) = (uint32_t)__LINE__; return; \
+                                 case __LINE__:; } while (0)
+
+#define CO_RESET(state)     ((state) = 0u)
+
+#define CO_END(state)       } (state) = 0u
+
+#endif /* COROUTINE_H_ */
@@ -0,0 +1,201 @@
+/*******************************************************************************
+ * @file deadline.c
+ *
+ * @brief Deadline misses and release jitter of periodic tasks.
+ *
+ * See "deadline.h" for details of how to use this module.
+ */
+
+#include "deadline.h"
+#include "mcycle.h"
+#include "evtrace.h"
+#include "telemetry_records.h"
+#include "fmt.h"
+
+#define DEADLINE_NAME_WIDTH         12u
+
+/*------------------------------------------------------------------------------
+  Histogram bucket of a response: quarters of the deadline up to it, then
+  [1, 2), [2, 4) and 4 or more deadlines.
+ */
+static uint32_t bucket_of(uint32_t response, uint32_t deadline)
+{
+    uint32_t ratio;
+
+    if (response < deadline)
+    {
+        return (uint32_t)(((uint64_t)response * 4u) / deadline);
+    }
+
+    ratio = response / deadline;
+    if (ratio < 2u)
+    {
+        return 4u;
+    }
+    return (ratio < 4u) ? 5u : 6u;
+}
+
+/***************************************************************************//**
+ * See "deadline.h" for details of how to use this function.
+ */
+void deadline_begin(deadline_t * dl)
+{
+    uint64_t now = mcycle_read();
+    uint64_t due;
+    uint64_t late = 0u;
+
+    if (0u != dl->reload)
+    {
+        due = dl->reload + dl->period;
+        if (now > due)
+        {
+            /* Whole periods past the due time went by without a run. */
+            late = now - due;
+            dl->skipped += (uint32_t)(late / dl->period);
+            late %= dl->period;
+        }
+    }
+
+    dl->start = now;
+    dl->late = (uint32_t)late;
+    if (dl->late > dl->max_jitter)
+    {
+        dl->max_jitter = dl->late;
+    }
+}
+
+/***************************************************************************//**
+ * See "deadline.h" for details of how to use this function.
+ */
+void deadline_end(deadline_t * dl)
+{
+    uint64_t now = mcycle_read();
+    uint32_t response = dl->late + (uint32_t)(now - dl->start);
+
+    dl->reload = now;
+    dl->runs++;
+    dl->hist[bucket_of(response, dl->deadline)]++;
+    if (response > dl->max_response)
+    {
+        dl->max_response = response;
+    }
+    if (response > dl->deadline)
+    {
+        dl->misses++;
+        EVTRACE(EVT_DEADLINE_MISS, dl->id);
+    }
+}
+
+/***************************************************************************//**
+ * See "deadline.h" for details of how to use this function.
+ */
+void deadline_reload(deadline_t * dl)
+{
+    dl->reload = mcycle_read();
+}
+
+/***************************************************************************//**
+ * See "deadline.h" for details of how to use this function.
+ */
+void deadline_report(deadline_t * const * dls, uint32_t count,
+                     uint32_t cycles_per_us, deadline_out_t out)
+{
+    char line[128];
+    char * p;
+    const deadline_t * dl;
+    uint32_t len;
+    uint32_t idx;
+    uint32_t bucket;
+
+    if (0u == cycles_per_us)
+    {
+        cycles_per_us = 1u;
+    }
+
+    out(" task              runs  misses skipped  jitter us    resp us"
+        "  <1/4 <1/2 <3/4   <1 |   <2   <4  >=4\r\n");
+
+    for (idx = 0u; idx < count; idx++)
+    {
+        dl = dls[idx];
+
+        p = line;
+        p = fmt_char(p, ' ');
+        p = fmt_str(p, dl->name);
+        for (len = 0u; ('\0' != dl->name[len]) && (len < DEADLINE_NAME_WIDTH); len++)
+        {
+            ;
+        }
+        for (; len < DEADLINE_NAME_WIDTH; len++)
+        {
+            p = fmt_char(p, ' ');
+        }
+        p = fmt_u32(p, dl->runs, 10u, ' ');
+        p = fmt_u32(p, dl->misses, 8u, ' ');
+        p = fmt_u32(p, dl->skipped, 8u, ' ');
+        p = fmt_u32(p, dl->max_jitter / cycles_per_us, 11u, ' ');
+        p = fmt_u32(p, dl->max_response / cycles_per_us, 11u, ' ');
+        p = fmt_char(p, ' ');
+        for (bucket = 0u; bucket < DEADLINE_BUCKETS; bucket++)
+        {
+            if (4u == bucket)
+            {
+                p = fmt_str(p, " |");
+            }
+            p = fmt_u32(p, dl->hist[bucket], 5u, ' ');
+        }
+        p = fmt_str(p, "\r\n");
+        *p = '\0';
+
+        out(line);
+    }
+}
+
+/***************************************************************************//**
+ * See "deadline.h" for details of how to use this function.
+ */
+void deadline_send(deadline_t * const * dls, uint32_t count, telemetry_t * tlm)
+{
+    const deadline_t * dl;
+    uint32_t idx;
+    uint32_t bucket;
+
+    for (idx = 0u; idx < count; idx++)
+    {
+        dl = dls[idx];
+        telemetry_begin(tlm, TLM_DEADLINE);
+        telemetry_put_u32(tlm, dl->id);
+        telemetry_put_u32(tlm, dl->runs);
+        telemetry_put_u32(tlm, dl->misses);
+        telemetry_put_u32(tlm, dl->skipped);
+        telemetry_put_u32(tlm, dl->max_jitter);
+        telemetry_put_u32(tlm, dl->max_response);
+        for (bucket = 0u; bucket < DEADLINE_BUCKETS; bucket++)
+        {
+            telemetry_put_u32(tlm, dl->hist[bucket]);
+        }
+        (void)telemetry_end(tlm);
+    }
+}
+
+/***************************************************************************//**
+ * See "deadline.h" for details of how to use this function.
+ */
+void deadline_clear(deadline_t * const * dls, uint32_t count)
+{
+    uint32_t idx;
+    uint32_t bucket;
+
+    for (idx = 0u; idx < count; idx++)
+    {
+        dls[idx]->runs = 0u;
+        dls[idx]->misses = 0u;
+        dls[idx]->skipped = 0u;
+        dls[idx]->max_jitter = 0u;
+        dls[idx]->max_response = 0u;
+        for (bucket = 0u; bucket < DEADLINE_BUCKETS; bucket++)
+        {
+            dls[idx]->hist[bucket] = 0u;
+        }
+    }
+}
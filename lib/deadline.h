@@ -0,0 +1,134 @@
+/*******************************************************************************
+ * @file deadline.h
+ *
+ * @brief Deadline misses and release jitter of periodic tasks.
+ *
+ * A periodic task, typically a timer interrupt handler, declares its period
+ * and a deadline, both in mcycles, and brackets each run with
+ * deadline_begin()/deadline_end():
+ *
+ *     static deadline_t g_dl_tick = DEADLINE_INIT("systick", 0u,
+ *                                                 SYSTICK_PERIOD, SYS_CLK_FREQ / 1000u);
+ *
+ *     void SysTick_Handler(void)
+ *     {
+ *         deadline_begin(&g_dl_tick);
+ *         ...
+ *         deadline_end(&g_dl_tick);
+ *     }
+ *
+ * Each run is due one period after the timer was last reloaded. The HAL
+ * SysTick timers reload MTIMECMP from MTIME only once the handler has
+ * returned, so a run is due one period after the previous run ended, not
+ * after it started: measuring from the start would charge every run with
+ * the previous one's runtime. deadline_end() takes the reload point as the
+ * end of the run; a handler that does more work after deadline_end(), such
+ * as sending telemetry it does not want counted against the deadline, calls
+ * deadline_reload() last instead:
+ *
+ *     void SysTick_Handler(void)
+ *     {
+ *         deadline_begin(&g_dl_tick);
+ *         ...
+ *         deadline_end(&g_dl_tick);
+ *         ...send telemetry...
+ *         deadline_reload(&g_dl_tick);
+ *     }
+ *
+ * How late a run starts is its jitter; how long after it was due it
+ * finishes is its response. A run misses when its response is longer than
+ * the deadline, and a gap of whole periods between the reload and a run
+ * counts the ticks in it as skipped: they were never serviced at all.
+ *
+ * Responses are kept in a histogram of DEADLINE_BUCKETS buckets: four
+ * quarters of the deadline, then [1, 2), [2, 4) and 4 or more deadlines.
+ * Anything outside the first four is a miss, so a display that "looks
+ * choppy" turns into counts in the last three.
+ *
+ * When the trace is built with EVTRACE_CAT_DEADLINE (evtrace.h), each miss
+ * also records an EVT_DEADLINE_MISS event with the task's id, so it can be
+ * lined up with what was running at the time.
+ *
+ * A deadline_t belongs to the task it measures; the report reads it without
+ * locking and can be one run behind.
+ */
+
+#ifndef DEADLINE_H_
+#define DEADLINE_H_
+
+#include <stdint.h>
+#include "telemetry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEADLINE_BUCKETS            7u
+
+typedef struct deadline
+{
+    const char * name;
+    uint16_t id;
+    uint32_t period;                /* mcycles between releases */
+    uint32_t deadline;              /* mcycles from release to finish */
+    uint64_t start;                 /* mcycle at the start of the latest run */
+    uint64_t reload;                /* mcycle the timer was last reloaded at */
+    uint32_t late;                  /* its jitter */
+    uint32_t runs;
+    uint32_t misses;
+    uint32_t skipped;
+    uint32_t max_jitter;
+    uint32_t max_response;
+    uint32_t hist[DEADLINE_BUCKETS];
+} deadline_t;
+
+#define DEADLINE_INIT(name, id, period, deadline)                           \
+    { (name), (id), (period), (deadline), 0u, 0u, 0u, 0u, 0u, 0u, 0u, 0u,   \
+      { 0u } }
+
+/*------------------------------------------------------------------------------
+  Called once per report line, e.g. console_tx().
+ */
+typedef void (*deadline_out_t)(const char * line);
+
+/***************************************************************************//**
+ * deadline_begin() marks the start of a run. The first run only sets the
+ * schedule.
+ */
+void deadline_begin(deadline_t * dl);
+
+/***************************************************************************//**
+ * deadline_end() marks the end of the run started by deadline_begin() and
+ * counts it. The next run is due one period from here.
+ */
+void deadline_end(deadline_t * dl);
+
+/***************************************************************************//**
+ * deadline_reload() moves the point the next run is due a period from to
+ * now. Call it last in a handler that keeps working after deadline_end().
+ */
+void deadline_reload(deadline_t * dl);
+
+/***************************************************************************//**
+ * deadline_report() prints one line per task: runs, misses, skipped ticks,
+ * worst jitter and response in microseconds at cycles_per_us, and the
+ * histogram.
+ */
+void deadline_report(deadline_t * const * dls, uint32_t count,
+                     uint32_t cycles_per_us, deadline_out_t out);
+
+/***************************************************************************//**
+ * deadline_send() sends one TLM_DEADLINE record per task.
+ */
+void deadline_send(deadline_t * const * dls, uint32_t count, telemetry_t * tlm);
+
+/***************************************************************************//**
+ * deadline_clear() zeroes the counts; the schedule is kept.
+ */
+void deadline_clear(deadline_t * const * dls, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEADLINE_H_ */
@@ -0,0 +1,140 @@
+/*******************************************************************************
+ * @file evtrace.c
+ *
+ * @brief Per-hart binary event trace with mcycle timestamps.
+ *
+ * See "evtrace.h" for details of how to use this module.
+ */
+
+#include "evtrace.h"
+#include "telemetry_records.h"
+
+#if EVTRACE_CATEGORIES != 0
+
+evtrace_ring_t g_evtrace[EVTRACE_HARTS];
+volatile uint8_t g_evtrace_on = 1u;
+
+/*------------------------------------------------------------------------------
+  64-bit MTIME; on RV32 the halves are read like mcycle's (mcycle.h).
+ */
+static uint64_t mtime_read(void)
+{
+    volatile uint32_t * mtime = (volatile uint32_t *)EVTRACE_MTIME_ADDR;
+    uint32_t hi;
+    uint32_t lo;
+
+    do
+    {
+        hi = mtime[1];
+        lo = mtime[0];
+    } while (hi != mtime[1]);
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+#endif
+
+/***************************************************************************//**
+ * See "evtrace.h" for details of how to use this function.
+ */
+void evtrace_enable(uint8_t enable)
+{
+#if EVTRACE_CATEGORIES != 0
+    g_evtrace_on = enable;
+    __sync_synchronize();
+#else
+    (void)enable;
+#endif
+}
+
+/***************************************************************************//**
+ * See "evtrace.h" for details of how to use this function.
+ */
+void evtrace_sync(void)
+{
+#if EVTRACE_CATEGORIES != 0
+    uintptr_t hart;
+    uint64_t before;
+    uint64_t mtime;
+    uint64_t after;
+
+    __asm volatile ("csrr %0, mhartid" : "=r"(hart));
+    if (hart >= EVTRACE_HARTS)
+    {
+        return;
+    }
+
+    /* The MTIME read is an uncached bus access; pair it with the middle of
+       the mcycle interval around it. */
+    before = mcycle_read();
+    mtime = mtime_read();
+    after = mcycle_read();
+
+    g_evtrace[hart].sync_mcycle = before + ((after - before) / 2u);
+    g_evtrace[hart].sync_mtime = mtime;
+#endif
+}
+
+/***************************************************************************//**
+ * See "evtrace.h" for details of how to use this function.
+ */
+void evtrace_clear(void)
+{
+#if EVTRACE_CATEGORIES != 0
+    uint32_t hart;
+
+    for (hart = 0u; hart < EVTRACE_HARTS; hart++)
+    {
+        g_evtrace[hart].head = 0u;
+    }
+    __sync_synchronize();
+#endif
+}
+
+/***************************************************************************//**
+ * See "evtrace.h" for details of how to use this function.
+ */
+uint32_t evtrace_dump(telemetry_t * tlm)
+{
+    uint32_t sent = 0u;
+#if EVTRACE_CATEGORIES != 0
+    uint8_t was_on = g_evtrace_on;
+    const evtrace_record_t * rec;
+    uint32_t hart;
+    uint32_t head;
+    uint32_t idx;
+
+    /* A record being written on another hart finishes within a few cycles
+       of it seeing the flag; the fence orders the flag before the reads. */
+    evtrace_enable(0u);
+
+    for (hart = 0u; hart < EVTRACE_HARTS; hart++)
+    {
+        head = g_evtrace[hart].head;
+        idx = (head > EVTRACE_RING_SIZE) ? (head - EVTRACE_RING_SIZE) : 0u;
+
+        telemetry_begin(tlm, TLM_EVENT_SYNC);
+        telemetry_put_u32(tlm, hart);
+        telemetry_put_u64(tlm, g_evtrace[hart].sync_mcycle);
+        telemetry_put_u64(tlm, g_evtrace[hart].sync_mtime);
+        (void)telemetry_end(tlm);
+
+        for (; idx != head; idx++)
+        {
+            rec = &g_evtrace[hart].records[idx & (EVTRACE_RING_SIZE - 1u)];
+            telemetry_begin(tlm, TLM_EVENT);
+            telemetry_put_u32(tlm, hart);
+            telemetry_put_u32(tlm, rec->id);
+            telemetry_put_u32(tlm, rec->arg);
+            telemetry_put_u64(tlm, rec->ts);
+            (void)telemetry_end(tlm);
+            sent++;
+        }
+    }
+
+    evtrace_enable(was_on);
+#else
+    (void)tlm;
+#endif
+    return sent;
+}
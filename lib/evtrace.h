@@ -0,0 +1,203 @@
+/*******************************************************************************
+ * @file evtrace.h
+ *
+ * @brief Per-hart binary event trace with mcycle timestamps.
+ *
+ * EVTRACE() stores a 16-byte record, an mcycle timestamp, an event id and a
+ * 32-bit argument, in a ring owned by the calling hart. With the hart's
+ * interrupts masked around the stores that is a dozen instructions and no
+ * calls, so it can go in interrupt handlers and on the display path without
+ * moving their timing by much. When the ring is full the oldest records are
+ * overwritten; the trace always holds the latest EVTRACE_RING_SIZE events.
+ *
+ * Events are grouped in categories, the high byte of the id. Only the
+ * categories set in EVTRACE_CATEGORIES are recorded; the rest of the
+ * EVTRACE() calls compile to nothing, arguments included. The default is 0,
+ * which also leaves out the rings, so a release build carries no trace at
+ * all. Build with, e.g.,
+ *
+ *     -DEVTRACE_CATEGORIES=EVTRACE_ALL
+ *     -DEVTRACE_CATEGORIES="(EVTRACE_CAT_IRQ | EVTRACE_CAT_SPI)"
+ *
+ * evtrace_dump() pauses tracing and sends every ring as TLM_EVENT telemetry
+ * records; lib/evtrace_chrome.py turns them into Chrome trace JSON, which
+ * chrome://tracing and ui.perfetto.dev show as one track per hart.
+ *
+ * The timestamps are each hart's own mcycle, which started counting when
+ * that hart came out of reset, so the harts' counts are not comparable.
+ * evtrace_sync(), called once on each hart before its first event, pairs its
+ * mcycle with the CLINT MTIME that all harts share; evtrace_dump() sends the
+ * pair ahead of the hart's records as a TLM_EVENT_SYNC record, and
+ * evtrace_chrome.py places every hart's events on the MTIME time line.
+ *
+ *     EVTRACE(EVT_IRQ_ENTER, RTC_WAKEUP_PLIC);
+ *     ...
+ *     EVTRACE(EVT_IRQ_EXIT, RTC_WAKEUP_PLIC);
+ *
+ * Begin and end events (the _ENTER/_EXIT, _START/_END and _BEGIN/_END pairs)
+ * must nest on each hart; the others are instants.
+ */
+
+#ifndef EVTRACE_H_
+#define EVTRACE_H_
+
+#include <stdint.h>
+#include "telemetry.h"
+#include "mcycle.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+  Categories.
+ */
+#define EVTRACE_CAT_IRQ         0x01u
+#define EVTRACE_CAT_QUEUE       0x02u
+#define EVTRACE_CAT_SPI         0x04u
+#define EVTRACE_CAT_RTC         0x08u
+#define EVTRACE_CAT_UART        0x10u
+#define EVTRACE_CAT_FORMAT      0x20u
+#define EVTRACE_CAT_DEADLINE    0x40u
+#define EVTRACE_ALL             0xFFu
+
+#ifndef EVTRACE_CATEGORIES
+#define EVTRACE_CATEGORIES      0u
+#endif
+
+/*------------------------------------------------------------------------------
+  Event ids: category number (1 to 8) in the high byte, event in the low
+  byte. lib/evtrace_chrome.py has the same table; add new events to both and
+  never reuse an id.
+ */
+#define EVT_IRQ_ENTER           0x0101u     /* arg: interrupt number */
+#define EVT_IRQ_EXIT            0x0102u
+#define EVT_QUEUE_PUSH          0x0201u     /* arg: entries queued */
+#define EVT_QUEUE_POP           0x0202u     /* arg: entries taken */
+#define EVT_SPI_FRAME_START     0x0301u     /* arg: frame */
+#define EVT_SPI_FRAME_END       0x0302u
+#define EVT_RTC_TICK            0x0401u     /* arg: seconds of the day */
+#define EVT_UART_RX             0x0501u     /* arg: byte */
+#define EVT_FORMAT_BEGIN        0x0601u
+#define EVT_FORMAT_END          0x0602u
+#define EVT_DEADLINE_MISS       0x0701u     /* arg: task id */
+
+#define EVTRACE_CAT_OF(id)      (1u << ((((id) >> 8) & 0x7u) - 1u))
+
+/* Records kept per hart; a power of two. */
+#ifndef EVTRACE_RING_SIZE
+#define EVTRACE_RING_SIZE       64u
+#endif
+
+/* CLINT MTIME, shared by all harts (the MPFS CLINT's; override for others). */
+#ifndef EVTRACE_MTIME_ADDR
+#define EVTRACE_MTIME_ADDR      0x0200BFF8UL
+#endif
+
+/* Rings, indexed by mhartid; events from higher harts are not recorded. */
+#ifndef EVTRACE_HARTS
+#if __riscv_xlen == 64
+#define EVTRACE_HARTS           5u
+#else
+#define EVTRACE_HARTS           1u
+#endif
+#endif
+
+typedef struct evtrace_record
+{
+    uint64_t ts;                    /* mcycle */
+    uint32_t arg;
+    uint16_t id;
+    uint16_t reserved;
+} evtrace_record_t;
+
+typedef struct evtrace_ring
+{
+    volatile uint32_t head;         /* records ever written */
+    uint64_t sync_mcycle;           /* this hart's mcycle ... */
+    uint64_t sync_mtime;            /* ... at this MTIME; both 0 if not synced */
+    evtrace_record_t records[EVTRACE_RING_SIZE];
+} evtrace_ring_t;
+
+/***************************************************************************//**
+ * evtrace_enable() starts or stops recording on every hart. Recording is on
+ * from boot when the trace is built in.
+ */
+void evtrace_enable(uint8_t enable);
+
+/***************************************************************************//**
+ * evtrace_sync() records the calling hart's mcycle against MTIME, so its
+ * events can be lined up with the other harts'. Call it once on each hart
+ * at start-up. Does nothing when the trace is not built in.
+ */
+void evtrace_sync(void);
+
+/***************************************************************************//**
+ * evtrace_clear() empties every ring. Call it with recording stopped.
+ */
+void evtrace_clear(void);
+
+/***************************************************************************//**
+ * evtrace_dump() stops recording, sends each ring, a TLM_EVENT_SYNC record
+ * and then its events, oldest first, as TLM_EVENT records, and then
+ * restores recording as it was. The rings are
+ * left as they were, so a second dump sends the same events again.
+ * @return  the number of records sent; 0 when the trace is not built in.
+ */
+uint32_t evtrace_dump(telemetry_t * tlm);
+
+#if EVTRACE_CATEGORIES != 0
+
+extern evtrace_ring_t g_evtrace[EVTRACE_HARTS];
+extern volatile uint8_t g_evtrace_on;
+
+/***************************************************************************//**
+ * evtrace_put() records one event on the calling hart; use EVTRACE().
+ */
+static inline void evtrace_put(uint16_t id, uint32_t arg)
+{
+    uintptr_t hart;
+    uintptr_t mstatus;
+    evtrace_ring_t * ring;
+    evtrace_record_t * rec;
+    uint32_t head;
+
+    __asm volatile ("csrr %0, mhartid" : "=r"(hart));
+    if ((0u == g_evtrace_on) || (hart >= EVTRACE_HARTS))
+    {
+        return;
+    }
+
+    /* Mask MIE so a handler on this hart cannot take the same slot. */
+    __asm volatile ("csrrci %0, mstatus, 8" : "=r"(mstatus) : : "memory");
+    ring = &g_evtrace[hart];
+    head = ring->head;
+    rec = &ring->records[head & (EVTRACE_RING_SIZE - 1u)];
+    rec->ts = mcycle_read();
+    rec->arg = arg;
+    rec->id = id;
+    ring->head = head + 1u;
+    __asm volatile ("csrs mstatus, %0" : : "r"(mstatus & 8u) : "memory");
+}
+
+#define EVTRACE(id, arg)                                                    \
+    do                                                                      \
+    {                                                                       \
+        if (0u != ((EVTRACE_CATEGORIES) & EVTRACE_CAT_OF(id)))              \
+        {                                                                   \
+            evtrace_put((uint16_t)(id), (uint32_t)(arg));                   \
+        }                                                                   \
+    } while (0)
+
+#else
+
+/* sizeof keeps arg type checked and its variables used, without evaluating it. */
+#define EVTRACE(id, arg)        ((void)sizeof(arg))
+
+#endif /* EVTRACE_CATEGORIES != 0 */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVTRACE_H_ */
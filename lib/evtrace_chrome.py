@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Chrome trace JSON from an on-target event trace dump (evtrace.h).
+
+Reads the TLM_EVENT telemetry records that "trace" (evtrace_dump()) sends,
+from a serial port or a capture, and writes them in the Chrome trace event
+format, for chrome://tracing or ui.perfetto.dev:
+
+    evtrace_chrome.py /dev/ttyUSB1 --seconds 5 -o trace.json
+    evtrace_chrome.py capture.bin --clock-hz 50e6 -o trace.json
+
+Each hart is a track. Begin/end pairs become slices, so an interrupt shows
+on top of what it interrupted and a display update shows its formatting and
+SPI frames nested inside it; other events are instants. Timestamps are
+mcycle counts converted with --clock-hz (the MPFS U54s run at 600 MHz) and
+start from the first event in the dump.
+
+Each hart's mcycle counts from its own reset, so the harts are lined up by
+the TLM_EVENT_SYNC record sent ahead of each hart's events: that hart's
+mcycle at a value of the shared CLINT MTIME, which counts at --mtime-hz
+(1 MHz on the MPFS). A hart that never called evtrace_sync() is left on its
+raw mcycle count, with a warning.
+"""
+
+import argparse
+import json
+import os
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import telemetry_decode  # noqa: E402
+
+TLM_EVENT = 0x04
+TLM_EVENT_SYNC = 0x07
+
+# Keep in step with evtrace.h: id -> (category, name, phase). B and E open and
+# close a slice, i is an instant.
+EVENTS = {
+    0x0101: ("irq", "irq", "B"),
+    0x0102: ("irq", "irq", "E"),
+    0x0201: ("queue", "queue push", "i"),
+    0x0202: ("queue", "queue pop", "i"),
+    0x0301: ("spi", "spi frame", "B"),
+    0x0302: ("spi", "spi frame", "E"),
+    0x0401: ("rtc", "rtc tick", "i"),
+    0x0501: ("uart", "uart rx", "i"),
+    0x0601: ("format", "format", "B"),
+    0x0602: ("format", "format", "E"),
+    0x0701: ("deadline", "deadline miss", "i"),
+}
+
+
+def rebase(records, syncs, clock_hz, mtime_hz):
+    """(hart, id, arg, seconds) tuples on the MTIME time line, from
+    (hart, id, arg, ts) tuples and {hart: (mcycle, mtime)}."""
+    out = []
+    for hart, event, arg, ts in records:
+        mcycle, mtime = syncs.get(hart, (0, 0))
+        if mcycle == 0 and mtime == 0:
+            seconds = ts / clock_hz
+        else:
+            seconds = mtime / mtime_hz + (ts - mcycle) / clock_hz
+        out.append((hart, event, arg, seconds))
+    return out
+
+
+def chrome_events(records, clock_hz, syncs=None, mtime_hz=1e6):
+    """Trace events for a list of (hart, id, arg, ts) tuples, with ts
+    rebased by syncs (see rebase())."""
+    if not records:
+        return []
+    records = rebase(records, syncs or {}, clock_hz, mtime_hz)
+    start = min(record[3] for record in records)
+    out = []
+    for hart in sorted({record[0] for record in records}):
+        out.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": hart,
+                    "args": {"name": "hart %d" % hart}})
+
+    for hart, event, arg, ts in sorted(records, key=lambda record: (record[0], record[3])):
+        cat, name, phase = EVENTS.get(event, ("unknown", "event 0x%04x" % event, "i"))
+        if cat == "irq" and phase == "B":
+            name = "irq %d" % arg
+        entry = {"name": name, "cat": cat, "ph": phase, "pid": 0, "tid": hart,
+                 "ts": (ts - start) * 1e6}
+        if phase == "i":
+            entry["s"] = "t"
+        if phase != "E":
+            entry["args"] = {"arg": arg}
+        out.append(entry)
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="serial port or capture file, - for stdin")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--seconds", type=float, help="stop after this long")
+    parser.add_argument("--clock-hz", type=float, default=600e6,
+                        help="mcycle rate of the traced harts")
+    parser.add_argument("--mtime-hz", type=float, default=1e6,
+                        help="CLINT MTIME rate")
+    parser.add_argument("-o", "--output", help="write the JSON here instead of stdout")
+    args = parser.parse_args()
+
+    records = []
+    syncs = {}
+
+    def on_record(rtype, source, seq, fields):
+        if rtype == TLM_EVENT and isinstance(fields, dict):
+            records.append((fields["hart"], fields["id"], fields["arg"], fields["ts"]))
+        elif rtype == TLM_EVENT_SYNC and isinstance(fields, dict):
+            syncs[fields["hart"]] = (fields["mcycle"], fields["mtime"])
+
+    decoder = telemetry_decode.Decoder(on_record, lambda chunk: None)
+    source = (sys.stdin.buffer if args.input == "-"
+              else telemetry_decode.open_input(args.input, args.baud))
+    deadline = time.monotonic() + args.seconds if args.seconds else None
+    try:
+        while deadline is None or time.monotonic() < deadline:
+            data = source.read(256)
+            if not data:
+                if hasattr(source, "in_waiting"):
+                    continue
+                break
+            decoder.feed(data)
+    except KeyboardInterrupt:
+        pass
+
+    unsynced = sorted({record[0] for record in records
+                       if syncs.get(record[0], (0, 0)) == (0, 0)})
+    if len({record[0] for record in records}) > 1 and unsynced:
+        sys.stderr.write("harts %s have no evtrace_sync(); their times do not "
+                         "line up with the others\n"
+                         % ", ".join(str(hart) for hart in unsynced))
+
+    trace = {"traceEvents": chrome_events(records, args.clock_hz, syncs,
+                                          args.mtime_hz),
+             "displayTimeUnit": "ns"}
+    if args.output:
+        with open(args.output, "w") as handle:
+            json.dump(trace, handle)
+    else:
+        json.dump(trace, sys.stdout)
+        sys.stdout.write("\n")
+
+    sys.stderr.write("%d events, %d records lost on the link\n" % (len(records), decoder.lost))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,351 @@
+/*******************************************************************************
+ * @file fmt.c
+ *
+ * @brief Small, allocation-free text formatting and parsing.
+ *
+ * See "fmt.h" for details of how to use this module.
+ */
+
+#include "fmt.h"
+
+static const char g_hex_digits[16] = "0123456789ABCDEF";
+
+/*------------------------------------------------------------------------------
+  value / 10 for any 32-bit value, as a multiply and shift.
+ */
+static inline uint32_t div10(uint32_t value)
+{
+    return (uint32_t)(((uint64_t)value * 0xCCCCCCCDu) >> 35);
+}
+
+/*------------------------------------------------------------------------------
+  value / 10 for value < 1029, small enough for a 32-bit multiply.
+ */
+static inline uint32_t div10_small(uint32_t value)
+{
+    return (value * 205u) >> 11;
+}
+
+/*------------------------------------------------------------------------------
+  value / 1000000000 for any 64-bit value, without a 64-bit divide (a libgcc
+  call on RV32). 1e9 is 2^9 * 1953125, so the low nine bits are shifted out
+  and the 55-bit remainder is divided by 1953125 with a reciprocal multiply,
+  exact for every 55-bit input. The upper half of the 128-bit product is
+  built from 32-bit multiplies.
+ */
+static inline uint64_t div1e9(uint64_t value)
+{
+    const uint64_t magic = 0x0044B82FA09B5A53ull;   /* ceil(2^75 / 1953125) */
+    uint64_t n = value >> 9;
+    uint32_t n_lo = (uint32_t)n;
+    uint32_t n_hi = (uint32_t)(n >> 32);
+    uint32_t m_lo = (uint32_t)magic;
+    uint32_t m_hi = (uint32_t)(magic >> 32);
+    uint64_t lo_lo = (uint64_t)n_lo * m_lo;
+    uint64_t hi_lo = (uint64_t)n_hi * m_lo;
+    uint64_t lo_hi = (uint64_t)n_lo * m_hi;
+    uint64_t hi_hi = (uint64_t)n_hi * m_hi;
+    uint64_t mid = (lo_lo >> 32) + (uint32_t)hi_lo + (uint32_t)lo_hi;
+
+    return (hi_hi + (hi_lo >> 32) + (lo_hi >> 32) + (mid >> 32)) >> 11;
+}
+
+/*------------------------------------------------------------------------------
+  Local functions.
+ */
+static char * emit_padded(char * p, const char * digits, uint32_t len,
+                          uint32_t width, char pad);
+static uint32_t u32_digits_reversed(uint32_t value, char * tmp);
+
+/***************************************************************************//**
+ * See "fmt.h" for details of how to use this function.
+ */
+char * fmt_str(char * p, const char * s)
+{
+    while ('\0' != *s)
+    {
+        *p++ = *s++;
+    }
+
+    return p;
+}
+
+/***************************************************************************//**
+ * See "fmt.h" for details of how to use this function.
+ */
+char * fmt_u32(char * p, uint32_t value, uint32_t width, char pad)
+{
+    char tmp[FMT_U32_MAX_CHARS];
+    uint32_t len = u32_digits_reversed(value, tmp);
+
+    return emit_padded(p, tmp, len, width, pad);
+}
+
+/***************************************************************************//**
+ * See "fmt.h" for details of how to use this function.
+ */
+char * fmt_i32(char * p, int32_t value, uint32_t width, char pad)
+{
+    char tmp[FMT_I32_MAX_CHARS];
+    uint32_t magnitude;
+    uint32_t len;
+
+    if (value >= 0)
+    {
+        return fmt_u32(p, (uint32_t)value, width, pad);
+    }
+
+    magnitude = 0u - (uint32_t)value;
+    len = u32_digits_reversed(magnitude, tmp);
+
+    if ('0' == pad)
+    {
+        *p++ = '-';
+        return emit_padded(p, tmp, len, (width > 0u) ? (width - 1u) : 0u, pad);
+    }
+
+    tmp[len++] = '-';
+    return emit_padded(p, tmp, len, width, pad);
+}
+
+/***************************************************************************//**
+ * See "fmt.h" for details of how to use this function.
+ * Split into base 1e9 chunks with div1e9(), so that only 32-bit reciprocal
+ * divides are used for the digits themselves.
+ */
+char * fmt_u64(char * p, uint64_t value, uint32_t width, char pad)
+{
+    char tmp[FMT_U64_MAX_CHARS];
+    uint32_t len = 0u;
+    uint32_t chunk;
+    uint32_t i;
+
+    if (value <= UINT32_MAX)
+    {
+        return fmt_u32(p, (uint32_t)value, width, pad);
+    }
+
+    while (value > UINT32_MAX)
+    {
+        uint64_t upper = div1e9(value);
+
+        /* The remainder fits in 32 bits, so the low words are enough. */
+        chunk = (uint32_t)value - ((uint32_t)upper * 1000000000u);
+        value = upper;
+
+        /* Inner chunks are always nine digits wide. */
+        for (i = 0u; i < 9u; i++)
+        {
+            uint32_t q = div10(chunk);
+            tmp[len++] = (char)('0' + (chunk - (q * 10u)));
+            chunk = q;
+        }
+    }
+
+    len += u32_digits_reversed((uint32_t)value, &tmp[len]);
+
+    return emit_padded(p, tmp, len, width, pad);
+}
+
+/***************************************************************************//**
+ * See "fmt.h" for details of how to use this function.
+ */
+char * fmt_hex(char * p, uint64_t value, uint32_t digits)
+{
+    uint32_t shift = digits * 4u;
+
+    while (shift > 0u)
+    {
+        shift -= 4u;
+        *p++ = g_hex_digits[(value >> shift) & 0xFu];
+    }
+
+    return p;
+}
+
+/***************************************************************************//**
+ * See "fmt.h" for details of how to use this function.
+ */
+char * fmt_fixed(char * p, int32_t value, uint32_t frac_bits, uint32_t decimals)
+{
+    uint32_t magnitude = (uint32_t)value;
+    uint32_t mask = (1u << frac_bits) - 1u;
+    uint32_t frac;
+
+    if (value < 0)
+    {
+        *p++ = '-';
+        magnitude = 0u - (uint32_t)value;
+    }
+
+    p = fmt_u32(p, magnitude >> frac_bits, 0u, ' ');
+
+    if (decimals > 0u)
+    {
+        *p++ = '.';
+        frac = magnitude & mask;
+
+        /* Shift one decimal digit at a time out of the top of the fraction. */
+        while (decimals-- > 0u)
+        {
+            frac *= 10u;
+            *p++ = (char)('0' + (frac >> frac_bits));
+            frac &= mask;
+        }
+    }
+
+    return p;
+}
+
+/***************************************************************************//**
+ * See "fmt.h" for details of how to use this function.
+ */
+char * fmt_hms(char * p, uint8_t hour, uint8_t minute, uint8_t second)
+{
+    uint32_t tens;
+
+    tens = div10_small(hour);
+    *p++ = (char)('0' + tens);
+    *p++ = (char)('0' + (hour - (tens * 10u)));
+    *p++ = ':';
+    tens = div10_small(minute);
+    *p++ = (char)('0' + tens);
+    *p++ = (char)('0' + (minute - (tens * 10u)));
+    *p++ = ':';
+    tens = div10_small(second);
+    *p++ = (char)('0' + tens);
+    *p++ = (char)('0' + (second - (tens * 10u)));
+
+    return p;
+}
+
+/***************************************************************************//**
+ * See "fmt.h" for details of how to use this function.
+ */
+uint32_t fmt_parse_u32(const char * s, uint32_t * value)
+{
+    const char * start = s;
+    uint64_t acc = 0u;
+    uint32_t digits = 0u;
+
+    while (' ' == *s)
+    {
+        s++;
+    }
+
+    while ((*s >= '0') && (*s <= '9'))
+    {
+        acc = (acc * 10u) + (uint32_t)(*s - '0');
+        if (acc > UINT32_MAX)
+        {
+            return 0u;
+        }
+        s++;
+        digits++;
+    }
+
+    if (0u == digits)
+    {
+        return 0u;
+    }
+
+    *value = (uint32_t)acc;
+    return (uint32_t)(s - start);
+}
+
+/***************************************************************************//**
+ * See "fmt.h" for details of how to use this function.
+ */
+uint32_t fmt_parse_hex(const char * s, uint32_t * value)
+{
+    const char * start = s;
+    uint32_t acc = 0u;
+    uint32_t digits = 0u;
+    uint32_t nibble;
+
+    while (' ' == *s)
+    {
+        s++;
+    }
+
+    if (('0' == s[0]) && (('x' == s[1]) || ('X' == s[1])))
+    {
+        s += 2;
+    }
+
+    for (;;)
+    {
+        if ((*s >= '0') && (*s <= '9'))
+        {
+            nibble = (uint32_t)(*s - '0');
+        }
+        else if ((*s >= 'a') && (*s <= 'f'))
+        {
+            nibble = (uint32_t)(*s - 'a') + 10u;
+        }
+        else if ((*s >= 'A') && (*s <= 'F'))
+        {
+            nibble = (uint32_t)(*s - 'A') + 10u;
+        }
+        else
+        {
+            break;
+        }
+
+        if (8u == digits)
+        {
+            return 0u;
+        }
+
+        acc = (acc << 4) | nibble;
+        digits++;
+        s++;
+    }
+
+    if (0u == digits)
+    {
+        return 0u;
+    }
+
+    *value = acc;
+    return (uint32_t)(s - start);
+}
+
+/*------------------------------------------------------------------------------
+  Write the decimal digits of value into tmp, least significant first.
+  Returns the number of digits.
+ */
+static uint32_t u32_digits_reversed(uint32_t value, char * tmp)
+{
+    uint32_t len = 0u;
+    uint32_t q;
+
+    do
+    {
+        q = div10(value);
+        tmp[len++] = (char)('0' + (value - (q * 10u)));
+        value = q;
+    } while (0u != value);
+
+    return len;
+}
+
+/*------------------------------------------------------------------------------
+  Pad to width, then copy the reversed digits in tmp out in order.
+ */
+static char * emit_padded(char * p, const char * digits, uint32_t len,
+                          uint32_t width, char pad)
+{
+    while (width > len)
+    {
+        *p++ = pad;
+        width--;
+    }
+
+    while (len > 0u)
+    {
+        *p++ = digits[--len];
+    }
+
+    return p;
+}
@@ -0,0 +1,119 @@
+/*******************************************************************************
+ * @file fmt.h
+ *
+ * @brief Small, allocation-free text formatting and parsing.
+ *
+ * Replaces sprintf()/snprintf()/sscanf() on the console and telemetry paths.
+ * newlib's printf family pulls in several kilobytes of code plus heap for its
+ * reentrancy structures and takes thousands of cycles per call, which is a
+ * big slice of the Mi-V's 64k ROM / 16k RAM.
+ *
+ * Every formatter writes at p and returns the position after the last
+ * character written, so output is built by chaining calls:
+ *
+ *     char line[48];
+ *     char * p = line;
+ *     p = fmt_str(p, "Hart ");
+ *     p = fmt_u32(p, hartid, 0u, ' ');
+ *     p = fmt_str(p, " t=");
+ *     p = fmt_fixed(p, temp_q8, 8u, 2u);
+ *     *p = '\0';
+ *
+ * No NUL terminator is written and no bounds are checked; size buffers for the
+ * widest value (FMT_U32_MAX_CHARS etc.). Divisions by ten are done with a
+ * reciprocal multiply, so the code is also fast on cores without a divider.
+ *
+ * fmt_bench.c compares cycles against newlib on target, in FMT_BENCH builds.
+ */
+
+#ifndef FMT_H_
+#define FMT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+  Widest output of each formatter, sign included.
+ */
+#define FMT_U32_MAX_CHARS       10u
+#define FMT_I32_MAX_CHARS       11u
+#define FMT_U64_MAX_CHARS       20u
+#define FMT_HEX64_MAX_CHARS     16u
+#define FMT_HMS_CHARS           8u
+
+/***************************************************************************//**
+ * fmt_str() copies a NUL terminated string, without the NUL.
+ */
+char * fmt_str(char * p, const char * s);
+
+/***************************************************************************//**
+ * fmt_char() writes one character.
+ */
+static inline char * fmt_char(char * p, char c)
+{
+    *p = c;
+    return p + 1;
+}
+
+/***************************************************************************//**
+ * fmt_u32() writes an unsigned decimal number.
+ *
+ * @param width  Minimum field width, 0 for none. The number is right-aligned.
+ * @param pad    Padding character, normally ' ' or '0'.
+ */
+char * fmt_u32(char * p, uint32_t value, uint32_t width, char pad);
+
+/***************************************************************************//**
+ * fmt_i32() writes a signed decimal number. With '0' padding the sign is
+ * placed before the zeros, as with printf("%05d").
+ */
+char * fmt_i32(char * p, int32_t value, uint32_t width, char pad);
+
+/***************************************************************************//**
+ * fmt_u64() writes a 64-bit unsigned decimal number, e.g. an mcycle value.
+ */
+char * fmt_u64(char * p, uint64_t value, uint32_t width, char pad);
+
+/***************************************************************************//**
+ * fmt_hex() writes value as exactly digits upper case hex digits (1-16), with
+ * no prefix.
+ */
+char * fmt_hex(char * p, uint64_t value, uint32_t digits);
+
+/***************************************************************************//**
+ * fmt_fixed() writes a signed fixed-point number.
+ *
+ * @param value      Value scaled by 2^frac_bits.
+ * @param frac_bits  Number of fractional bits in value (0-24).
+ * @param decimals   Number of decimal places to write (0-6), truncated.
+ */
+char * fmt_fixed(char * p, int32_t value, uint32_t frac_bits, uint32_t decimals);
+
+/***************************************************************************//**
+ * fmt_hms() writes "HH:MM:SS". Each field must be 0-99.
+ */
+char * fmt_hms(char * p, uint8_t hour, uint8_t minute, uint8_t second);
+
+/***************************************************************************//**
+ * fmt_parse_u32() parses an unsigned decimal number at the start of s.
+ * Leading spaces are skipped.
+ *
+ * @return  Number of characters consumed, or 0 if there was no number or it
+ *          did not fit in 32 bits.
+ */
+uint32_t fmt_parse_u32(const char * s, uint32_t * value);
+
+/***************************************************************************//**
+ * fmt_parse_hex() parses up to 8 hex digits at the start of s, with an
+ * optional "0x" prefix. Returns as fmt_parse_u32().
+ */
+uint32_t fmt_parse_hex(const char * s, uint32_t * value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FMT_H_ */
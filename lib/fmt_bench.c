@@ -0,0 +1,192 @@
+/*******************************************************************************
+ * @file fmt_bench.c
+ *
+ * @brief Cycle comparison of fmt against newlib's printf family.
+ *
+ * Each case formats or parses the same text with newlib and with fmt and
+ * reports the fastest of FMT_BENCH_RUNS runs, so the first, cache-cold call
+ * does not skew the result. The cases are the ones the firmware actually
+ * uses: the hart status line, the clock line, a hex dump word and the console
+ * number parser.
+ *
+ * Code size is compared at build time by fmt_size.sh.
+ *
+ * Built only with FMT_BENCH defined, so that other images do not link newlib's
+ * printf family through this file.
+ */
+
+#ifdef FMT_BENCH
+
+#include <stdio.h>
+#include "fmt.h"
+#include "fmt_bench.h"
+
+#define FMT_BENCH_RUNS      16u
+
+/*------------------------------------------------------------------------------
+  Low word of mcycle; enough for the few thousand cycles measured here.
+ */
+static inline unsigned long bench_cycles(void)
+{
+    unsigned long cycles;
+
+    __asm volatile ("csrr %0, mcycle" : "=r"(cycles));
+    return cycles;
+}
+
+typedef struct fmt_bench_case
+{
+    const char * name;
+    void (*newlib)(char * buf);
+    void (*fmt)(char * buf);
+} fmt_bench_case_t;
+
+/* Inputs are volatile so the compiler cannot fold the formatting away. */
+static volatile uint64_t g_hartid = 1u;
+static volatile uint64_t g_delta = 1234567u;
+static volatile uint64_t g_irqs = 42u;
+static volatile uint64_t g_mcycle = 987654321012u;
+static volatile uint8_t g_hour = 12u;
+static volatile uint8_t g_minute = 34u;
+static volatile uint8_t g_second = 56u;
+static volatile uint32_t g_word = 0xDEADBEEFu;
+static const char g_number_text[] = "  1234";
+static volatile uint32_t g_parsed;
+
+static void status_newlib(char * buf)
+{
+    sprintf(buf, "Hart %ld, mcycle_delta=%ld SW_IRQs=%ld mcycle=%ld\r\n",
+            (long)g_hartid, (long)g_delta, (long)g_irqs, (long)g_mcycle);
+}
+
+static void status_fmt(char * buf)
+{
+    char * p = buf;
+
+    p = fmt_str(p, "Hart ");
+    p = fmt_u64(p, g_hartid, 0u, ' ');
+    p = fmt_str(p, ", mcycle_delta=");
+    p = fmt_u64(p, g_delta, 0u, ' ');
+    p = fmt_str(p, " SW_IRQs=");
+    p = fmt_u64(p, g_irqs, 0u, ' ');
+    p = fmt_str(p, " mcycle=");
+    p = fmt_u64(p, g_mcycle, 0u, ' ');
+    p = fmt_str(p, "\r\n");
+    *p = '\0';
+}
+
+static void time_newlib(char * buf)
+{
+    sprintf(buf, " Current Time: %02d:%02d:%02d\r\n",
+            (int)g_hour, (int)g_minute, (int)g_second);
+}
+
+static void time_fmt(char * buf)
+{
+    char * p = buf;
+
+    p = fmt_str(p, " Current Time: ");
+    p = fmt_hms(p, g_hour, g_minute, g_second);
+    p = fmt_str(p, "\r\n");
+    *p = '\0';
+}
+
+static void hex_newlib(char * buf)
+{
+    sprintf(buf, "%08lX", (unsigned long)g_word);
+}
+
+static void hex_fmt(char * buf)
+{
+    char * p = fmt_hex(buf, g_word, 8u);
+    *p = '\0';
+}
+
+static void parse_newlib(char * buf)
+{
+    unsigned int value = 0u;
+
+    (void)buf;
+    (void)sscanf(g_number_text, "%u", &value);
+    g_parsed = value;
+}
+
+static void parse_fmt(char * buf)
+{
+    uint32_t value = 0u;
+
+    (void)buf;
+    (void)fmt_parse_u32(g_number_text, &value);
+    g_parsed = value;
+}
+
+static const fmt_bench_case_t g_cases[] =
+{
+    { "status line", status_newlib, status_fmt },
+    { "clock line ", time_newlib,   time_fmt   },
+    { "hex word   ", hex_newlib,    hex_fmt    },
+    { "parse u32  ", parse_newlib,  parse_fmt  },
+};
+
+/*------------------------------------------------------------------------------
+  Fastest of FMT_BENCH_RUNS calls of fn.
+ */
+static uint32_t best_cycles(void (*fn)(char * buf))
+{
+    char buf[96];
+    uint32_t best = UINT32_MAX;
+    uint32_t run;
+    unsigned long start;
+    uint32_t cycles;
+
+    for (run = 0u; run < FMT_BENCH_RUNS; run++)
+    {
+        start = bench_cycles();
+        fn(buf);
+        cycles = (uint32_t)(bench_cycles() - start);
+
+        if (cycles < best)
+        {
+            best = cycles;
+        }
+    }
+
+    return best;
+}
+
+/***************************************************************************//**
+ * See "fmt_bench.h" for details of how to use this function.
+ */
+void fmt_bench_run(fmt_bench_out_t out)
+{
+    char line[80];
+    char * p;
+    uint32_t idx;
+    uint32_t newlib_cycles;
+    uint32_t fmt_cycles;
+
+    out("\r\nfmt vs newlib, best of 16 runs (cycles):\r\n");
+
+    for (idx = 0u; idx < (sizeof(g_cases) / sizeof(g_cases[0])); idx++)
+    {
+        newlib_cycles = best_cycles(g_cases[idx].newlib);
+        fmt_cycles = best_cycles(g_cases[idx].fmt);
+
+        p = line;
+        p = fmt_str(p, "  ");
+        p = fmt_str(p, g_cases[idx].name);
+        p = fmt_str(p, "  newlib=");
+        p = fmt_u32(p, newlib_cycles, 7u, ' ');
+        p = fmt_str(p, "  fmt=");
+        p = fmt_u32(p, fmt_cycles, 6u, ' ');
+        p = fmt_str(p, "  x");
+        p = fmt_fixed(p, (int32_t)(((uint64_t)newlib_cycles << 8) /
+                                   ((0u != fmt_cycles) ? fmt_cycles : 1u)), 8u, 1u);
+        p = fmt_str(p, "\r\n");
+        *p = '\0';
+
+        out(line);
+    }
+}
+
+#endif /* FMT_BENCH */
@@ -0,0 +1,31 @@
+/*******************************************************************************
+ * @file fmt_bench.h
+ *
+ * @brief Cycle comparison of fmt against newlib's printf family.
+ */
+
+#ifndef FMT_BENCH_H_
+#define FMT_BENCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+  Called once per line of results, e.g. safe_MSS_UART0_polled_tx_string().
+ */
+typedef void (*fmt_bench_out_t)(const char * line);
+
+/***************************************************************************//**
+ * fmt_bench_run() times each benchmark case with newlib and with fmt and
+ * reports the results through out. The newlib calls pull the printf family
+ * into the image, so fmt_bench.c is empty unless FMT_BENCH is defined; only
+ * define it for benchmark builds.
+ */
+void fmt_bench_run(fmt_bench_out_t out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FMT_BENCH_H_ */
@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# Compare the code and data size that newlib's printf family and fmt add to an
+# image. Builds the same three calls (format a status line, format the clock,
+# parse a number) once with each and prints `size` for both, with and without
+# newlib-nano.
+#
+# Usage: lib/fmt_size.sh
+#   CC    cross compiler  (default riscv64-unknown-elf-gcc)
+#   ARCH  -march/-mabi     (default Mi-V: -march=rv32imc -mabi=ilp32)
+
+set -e
+
+CC=${CC:-riscv64-unknown-elf-gcc}
+SIZE=${SIZE:-$(echo "$CC" | sed 's/gcc$/size/')}
+ARCH=${ARCH:-"-march=rv32imc -mabi=ilp32"}
+CFLAGS="$ARCH -Os -ffunction-sections -fdata-sections"
+LDFLAGS="-Wl,--gc-sections -nostartfiles -Wl,-e,main --specs=nosys.specs"
+
+LIB_DIR=$(cd "$(dirname "$0")" && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+cat > "$WORK/with_newlib.c" <<'SRC'
+#include <stdio.h>
+volatile long a = 1, b = 2, c = 3; volatile unsigned v;
+char buf[96];
+int main(void)
+{
+    sprintf(buf, "Hart %ld, mcycle_delta=%ld SW_IRQs=%ld\r\n", a, b, c);
+    snprintf(buf, sizeof(buf), "%02d:%02d:%02d", (int)a, (int)b, (int)c);
+    sscanf("1234", "%u", (unsigned *)&v);
+    return 0;
+}
+SRC
+
+cat > "$WORK/with_fmt.c" <<'SRC'
+#include "fmt.h"
+volatile long a = 1, b = 2, c = 3; volatile uint32_t v;
+char buf[96];
+int main(void)
+{
+    char * p = buf; uint32_t n;
+    p = fmt_str(p, "Hart "); p = fmt_i32(p, a, 0, ' ');
+    p = fmt_str(p, ", mcycle_delta="); p = fmt_i32(p, b, 0, ' ');
+    p = fmt_str(p, " SW_IRQs="); p = fmt_i32(p, c, 0, ' '); *p = 0;
+    p = fmt_hms(buf, a, b, c); *p = 0;
+    fmt_parse_u32("1234", &n); v = n;
+    return 0;
+}
+SRC
+
+for SPECS in "" "--specs=nano.specs"; do
+    echo "== ${SPECS:-newlib (full)} =="
+    $CC $CFLAGS $SPECS "$WORK/with_newlib.c" $LDFLAGS -o "$WORK/newlib.elf"
+    $CC $CFLAGS $SPECS -I"$LIB_DIR" "$WORK/with_fmt.c" "$LIB_DIR/fmt.c" $LDFLAGS -o "$WORK/fmt.elf"
+    $SIZE "$WORK/newlib.elf" "$WORK/fmt.elf" | sed "s|$WORK/||"
+done
@@ -0,0 +1,300 @@
+/*******************************************************************************
+ * @file irq_affinity.c
+ *
+ * @brief Routing PLIC sources to harts at run time, and a load balancer (MPFS).
+ *
+ * See "irq_affinity.h" for details of how to use this module.
+ */
+
+#include "mpfs_hal/mss_hal.h"
+#include "irq_affinity.h"
+#include "irq_plan.h"
+
+/*------------------------------------------------------------------------------
+  PLIC enable bits: one 32-bit word per 32 sources for each context. Hart 0
+  has a machine mode context only; every U54 has machine then supervisor.
+ */
+#define PLIC_BASE                   0x0C000000UL
+#define PLIC_PRIORITY_OFFSET        0x0000UL
+#define PLIC_ENABLE_OFFSET          0x2000UL
+#define PLIC_ENABLE_STRIDE          0x80UL
+
+#define M_CONTEXT(hart)             ((0u == (hart)) ? 0u : ((2u * (hart)) - 1u))
+
+/* Serialises read-modify-writes of the enable words between harts. */
+static volatile uint32_t g_affinity_lock = 0u;
+
+static volatile uint32_t * enable_word(uint32_t hart, uint32_t source)
+{
+    return (volatile uint32_t *)(PLIC_BASE + PLIC_ENABLE_OFFSET +
+                                 (M_CONTEXT(hart) * PLIC_ENABLE_STRIDE) +
+                                 ((source / 32u) * 4u));
+}
+
+static volatile uint32_t * priority_reg(uint32_t source)
+{
+    return (volatile uint32_t *)(PLIC_BASE + PLIC_PRIORITY_OFFSET +
+                                 (source * 4u));
+}
+
+static void settle(void)
+{
+    uint64_t start = mcycle_read();
+
+    while ((mcycle_read() - start) < IRQ_AFFINITY_SETTLE_CYCLES)
+    {
+        ;
+    }
+}
+
+/***************************************************************************//**
+ * See "irq_affinity.h" for details of how to use this function.
+ */
+void irq_affinity_set(uint32_t source, uint32_t hart, const irq_stat_t * stats)
+{
+    uint32_t bit = 1u << (source % 32u);
+    uint32_t priority;
+    uint32_t other;
+
+    while (0u != __atomic_exchange_n(&g_affinity_lock, 1u, __ATOMIC_ACQUIRE))
+    {
+        ;
+    }
+
+    /* On the new hart first, so a request always has somewhere to go, and
+       held off everywhere while the old harts let go of it. */
+    priority = *priority_reg(source);
+    *enable_word(hart, source) |= bit;
+    *priority_reg(source) = 0u;
+    __sync_synchronize();
+
+    /* A call claimed on an old hart must complete while the source is still
+       enabled there, or the PLIC ignores the completion. */
+    if (NULL != stats)
+    {
+        settle();
+        while (0u != irq_stats_busy(stats))
+        {
+            ;
+        }
+        settle();
+    }
+
+    for (other = 0u; other < IRQ_AFFINITY_HARTS; other++)
+    {
+        if (other != hart)
+        {
+            *enable_word(other, source) &= ~bit;
+        }
+    }
+    __sync_synchronize();
+    *priority_reg(source) = priority;
+
+    __atomic_store_n(&g_affinity_lock, 0u, __ATOMIC_RELEASE);
+}
+
+/***************************************************************************//**
+ * See "irq_affinity.h" for details of how to use this function.
+ */
+uint32_t irq_affinity_get(uint32_t source)
+{
+    uint32_t bit = 1u << (source % 32u);
+    uint32_t hart;
+
+    for (hart = 0u; hart < IRQ_AFFINITY_HARTS; hart++)
+    {
+        if (0u != (*enable_word(hart, source) & bit))
+        {
+            return hart;
+        }
+    }
+
+    return IRQ_AFFINITY_NONE;
+}
+
+/***************************************************************************//**
+ * See "irq_affinity.h" for details of how to use this function.
+ */
+void irq_affinity_serve(void)
+{
+    irq_plan_set_threshold(0u);
+    set_csr(mie, MIP_MEIP);
+    __enable_irq();
+}
+
+/***************************************************************************//**
+ * See "irq_affinity.h" for details of how to use this function.
+ */
+void irq_balance_init(irq_balancer_t * bal, irq_balance_src_t * srcs,
+                      uint32_t count, uint32_t hart_mask)
+{
+    uint32_t idx;
+
+    bal->srcs = srcs;
+    bal->count = (count > IRQ_BALANCE_MAX_SOURCES) ? IRQ_BALANCE_MAX_SOURCES
+                                                   : count;
+    bal->hart_mask = hart_mask & ((1u << IRQ_AFFINITY_HARTS) - 1u);
+    bal->runs = 0u;
+    bal->moves = 0u;
+    for (idx = 0u; idx < IRQ_AFFINITY_HARTS; idx++)
+    {
+        bal->hart_load[idx] = 0u;
+    }
+    for (idx = 0u; idx < bal->count; idx++)
+    {
+        srcs[idx].last_total = srcs[idx].stats->total_cycles;
+        srcs[idx].load = 0u;
+    }
+}
+
+/*------------------------------------------------------------------------------
+  Load of each hart in the mask with the current routing; returns 1 if a
+  source is routed outside the mask. Sources that are not routed anywhere
+  are left out.
+ */
+static uint8_t current_loads(const irq_balancer_t * bal, const uint8_t * route,
+                             uint64_t * load)
+{
+    uint8_t stray = 0u;
+    uint32_t idx;
+
+    for (idx = 0u; idx < IRQ_AFFINITY_HARTS; idx++)
+    {
+        load[idx] = 0u;
+    }
+    for (idx = 0u; idx < bal->count; idx++)
+    {
+        if (IRQ_AFFINITY_NONE == route[idx])
+        {
+            continue;
+        }
+        if ((route[idx] >= IRQ_AFFINITY_HARTS) ||
+            (0u == (bal->hart_mask & (1u << route[idx]))))
+        {
+            stray = 1u;
+        }
+        else
+        {
+            load[route[idx]] += bal->srcs[idx].load;
+        }
+    }
+
+    return stray;
+}
+
+/***************************************************************************//**
+ * See "irq_affinity.h" for details of how to use this function.
+ */
+uint32_t irq_balance_run(irq_balancer_t * bal)
+{
+    uint8_t route[IRQ_BALANCE_MAX_SOURCES];
+    uint8_t order[IRQ_BALANCE_MAX_SOURCES];
+    uint64_t load[IRQ_AFFINITY_HARTS];
+    uint32_t sources[IRQ_AFFINITY_HARTS];
+    uint64_t max_load = 0u;
+    uint64_t min_load = UINT64_MAX;
+    uint64_t total;
+    uint32_t moves = 0u;
+    uint32_t best;
+    uint32_t hart;
+    uint32_t idx;
+    uint32_t pos;
+    uint8_t tmp;
+
+    if (0u == bal->hart_mask)
+    {
+        return 0u;
+    }
+    bal->runs++;
+
+    for (idx = 0u; idx < bal->count; idx++)
+    {
+        total = bal->srcs[idx].stats->total_cycles;
+        bal->srcs[idx].load = total - bal->srcs[idx].last_total;
+        bal->srcs[idx].last_total = total;
+        route[idx] = (uint8_t)irq_affinity_get(bal->srcs[idx].source);
+        order[idx] = (uint8_t)idx;
+    }
+
+    if (0u == current_loads(bal, route, load))
+    {
+        for (hart = 0u; hart < IRQ_AFFINITY_HARTS; hart++)
+        {
+            if (0u != (bal->hart_mask & (1u << hart)))
+            {
+                max_load = (load[hart] > max_load) ? load[hart] : max_load;
+                min_load = (load[hart] < min_load) ? load[hart] : min_load;
+            }
+        }
+        if ((max_load - min_load) * 100u <= max_load * IRQ_BALANCE_SLACK_PCT)
+        {
+            for (hart = 0u; hart < IRQ_AFFINITY_HARTS; hart++)
+            {
+                bal->hart_load[hart] = load[hart];
+            }
+            return 0u;
+        }
+    }
+
+    /* Busiest source first; a handful of sources, so a simple sort. */
+    for (idx = 1u; idx < bal->count; idx++)
+    {
+        for (pos = idx; (pos > 0u) &&
+             (bal->srcs[order[pos]].load > bal->srcs[order[pos - 1u]].load); pos--)
+        {
+            tmp = order[pos];
+            order[pos] = order[pos - 1u];
+            order[pos - 1u] = tmp;
+        }
+    }
+
+    for (hart = 0u; hart < IRQ_AFFINITY_HARTS; hart++)
+    {
+        load[hart] = 0u;
+        sources[hart] = 0u;
+    }
+
+    /* Each source to the least loaded hart; on a tie, e.g. before any
+       source has run, to the one with fewest sources, then staying put.
+       Sources that were never enabled are not touched. */
+    for (pos = 0u; pos < bal->count; pos++)
+    {
+        idx = order[pos];
+        if (IRQ_AFFINITY_NONE == route[idx])
+        {
+            continue;
+        }
+
+        best = IRQ_AFFINITY_NONE;
+        for (hart = 0u; hart < IRQ_AFFINITY_HARTS; hart++)
+        {
+            if (0u == (bal->hart_mask & (1u << hart)))
+            {
+                continue;
+            }
+            if ((IRQ_AFFINITY_NONE == best) || (load[hart] < load[best]) ||
+                ((load[hart] == load[best]) &&
+                 ((sources[hart] < sources[best]) ||
+                  ((sources[hart] == sources[best]) && (hart == route[idx])))))
+            {
+                best = hart;
+            }
+        }
+
+        load[best] += bal->srcs[idx].load;
+        sources[best]++;
+        if (best != route[idx])
+        {
+            irq_affinity_set(bal->srcs[idx].source, best, bal->srcs[idx].stats);
+            bal->srcs[idx].stats->hartid = (uint8_t)best;
+            moves++;
+        }
+    }
+
+    for (hart = 0u; hart < IRQ_AFFINITY_HARTS; hart++)
+    {
+        bal->hart_load[hart] = load[hart];
+    }
+    bal->moves += moves;
+    return moves;
+}
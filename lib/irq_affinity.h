@@ -0,0 +1,142 @@
+/*******************************************************************************
+ * @file irq_affinity.h
+ *
+ * @brief Routing PLIC sources to harts at run time, and a load balancer (MPFS).
+ *
+ * The PLIC has one enable bit per source for each hart's machine mode
+ * context. The HAL's PLIC_EnableIRQ() only sets the calling hart's, so a
+ * source is serviced on whichever hart happened to enable it. Here any hart
+ * can move a source to any other with irq_affinity_set():
+ *
+ *   - the source is enabled on the new hart first, and its priority dropped
+ *     to 0 so that no hart claims it while it moves. A request that arrives
+ *     meanwhile stays pending in the PLIC gateway and goes to the new hart;
+ *   - a call already claimed on an old hart finishes there. The source stays
+ *     enabled on that hart until the handler's irq_stats entry and exit
+ *     counts match, and IRQ_AFFINITY_SETTLE_CYCLES more for the HAL to claim
+ *     or complete around them: the PLIC ignores a completion from a context
+ *     the source is no longer enabled in, which would leave the gateway
+ *     closed for good;
+ *   - then it is disabled on every other hart and its priority restored.
+ *
+ * For the short time between the first step and the last the source is
+ * enabled on two harts, but with priority 0 neither takes it, and the PLIC
+ * never delivers a source again before its completion, so a handler never
+ * runs on two harts at once.
+ *
+ * The handlers are the same functions whichever hart runs them, so they
+ * must not depend on running on a particular hart: no hart-local data, and
+ * no lock that the interrupted thread code may already hold.
+ *
+ * A hart takes PLIC interrupts only after irq_affinity_serve(), which
+ * enables its machine external interrupt with a threshold of 0.
+ *
+ * The balancer spreads a set of sources over a mask of harts by the cycles
+ * their handlers took since the last run (irq_stats.h). Each run assigns
+ * the busiest source first, always to the hart with the least load so far,
+ * or among equally loaded harts to the one with fewest sources, and moves
+ * sources only when the busiest hart would otherwise carry more than
+ * IRQ_BALANCE_SLACK_PCT percent above the least busy one, so sources do not
+ * bounce between harts on noise. Sources that are not enabled on any hart
+ * are left alone.
+ *
+ *     static irq_balance_src_t g_srcs[] = {
+ *         IRQ_BALANCE_SRC(GPIO0_NON_DIRECT_PLIC, &g_irq_gpio0_nd), ...
+ *     };
+ *     irq_balance_init(&g_bal, g_srcs, 3u, IRQ_AFFINITY_U54S);
+ *     ...
+ *     moves = irq_balance_run(&g_bal);
+ */
+
+#ifndef IRQ_AFFINITY_H_
+#define IRQ_AFFINITY_H_
+
+#include <stdint.h>
+#include "irq_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IRQ_AFFINITY_HARTS          5u
+#define IRQ_AFFINITY_NONE           0xFFu
+
+/* Hart masks. */
+#define IRQ_AFFINITY_E51            0x01u
+#define IRQ_AFFINITY_U54S           0x1Eu
+
+/* Cycles allowed for the HAL's dispatch between the PLIC claim and
+   IRQ_STATS_ENTER(), and between IRQ_STATS_EXIT() and the completion. */
+#ifndef IRQ_AFFINITY_SETTLE_CYCLES
+#define IRQ_AFFINITY_SETTLE_CYCLES  1000u
+#endif
+
+/* Sources one balancer can handle. */
+#define IRQ_BALANCE_MAX_SOURCES     32u
+
+/* Imbalance, in percent of the busiest hart's load, tolerated before
+   sources are moved. */
+#ifndef IRQ_BALANCE_SLACK_PCT
+#define IRQ_BALANCE_SLACK_PCT       25u
+#endif
+
+typedef struct irq_balance_src
+{
+    uint32_t source;                /* PLIC source number */
+    irq_stat_t * stats;
+    uint64_t last_total;            /* stats->total_cycles at the last run */
+    uint64_t load;                  /* cycles in the last interval */
+} irq_balance_src_t;
+
+#define IRQ_BALANCE_SRC(source, stats)  { (source), (stats), 0u, 0u }
+
+typedef struct irq_balancer
+{
+    irq_balance_src_t * srcs;
+    uint32_t count;
+    uint32_t hart_mask;
+    uint32_t runs;
+    uint32_t moves;
+    uint64_t hart_load[IRQ_AFFINITY_HARTS];     /* after the last run */
+} irq_balancer_t;
+
+/***************************************************************************//**
+ * irq_affinity_set() routes source to hart only. stats is the source
+ * handler's irq_stat_t, used to wait for a call in progress on another hart
+ * to finish; NULL if the source is not yet enabled anywhere else.
+ */
+void irq_affinity_set(uint32_t source, uint32_t hart, const irq_stat_t * stats);
+
+/***************************************************************************//**
+ * irq_affinity_get() returns the lowest hart the source is enabled on, or
+ * IRQ_AFFINITY_NONE.
+ */
+uint32_t irq_affinity_get(uint32_t source);
+
+/***************************************************************************//**
+ * irq_affinity_serve() lets the calling hart take PLIC interrupts routed to
+ * it.
+ */
+void irq_affinity_serve(void);
+
+/***************************************************************************//**
+ * irq_balance_init() sets up a balancer over count (up to
+ * IRQ_BALANCE_MAX_SOURCES) sources and the harts in hart_mask. Sources keep
+ * their routing until the first run.
+ */
+void irq_balance_init(irq_balancer_t * bal, irq_balance_src_t * srcs,
+                      uint32_t count, uint32_t hart_mask);
+
+/***************************************************************************//**
+ * irq_balance_run() measures each source's load since the last run and
+ * reroutes sources if the harts are out of balance, or if a source is
+ * routed to a hart outside the mask.
+ * @return  the number of sources moved.
+ */
+uint32_t irq_balance_run(irq_balancer_t * bal);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IRQ_AFFINITY_H_ */
@@ -0,0 +1,174 @@
+/*******************************************************************************
+ * @file irq_plan.c
+ *
+ * @brief PLIC priority plan, nested interrupts and latency targets (MPFS).
+ *
+ * See "irq_plan.h" for details of how to use this module.
+ */
+
+#include "mpfs_hal/mss_hal.h"
+#include "irq_plan.h"
+#include "fmt.h"
+
+#define IRQ_PLAN_HARTS              5u
+#define IRQ_PLAN_NAME_WIDTH         12u
+
+/* Each hart's PLIC threshold, as last set through this module. */
+static uint32_t g_threshold[IRQ_PLAN_HARTS];
+
+/***************************************************************************//**
+ * See "irq_plan.h" for details of how to use this function.
+ */
+void irq_plan_apply(const irq_plan_entry_t * plan, uint32_t count)
+{
+    uint32_t idx;
+
+    for (idx = 0u; idx < count; idx++)
+    {
+        if (IRQ_PLAN_LOCAL != plan[idx].source)
+        {
+            PLIC_SetPriority((PLIC_IRQn_Type)plan[idx].source, plan[idx].priority);
+        }
+    }
+
+    irq_plan_set_threshold(0u);
+}
+
+/***************************************************************************//**
+ * See "irq_plan.h" for details of how to use this function.
+ */
+void irq_plan_set_threshold(uint32_t threshold)
+{
+    g_threshold[read_csr(mhartid) % IRQ_PLAN_HARTS] = threshold;
+    PLIC_SetPriority_Threshold(threshold);
+}
+
+/***************************************************************************//**
+ * See "irq_plan.h" for details of how to use this function.
+ */
+uint32_t irq_plan_threshold(void)
+{
+    return g_threshold[read_csr(mhartid) % IRQ_PLAN_HARTS];
+}
+
+/***************************************************************************//**
+ * See "irq_plan.h" for details of how to use this function.
+ */
+void irq_nest_enter(irq_nest_t * nest, uint32_t priority, irq_stat_t * stats)
+{
+    nest->mepc = read_csr(mepc);
+    nest->mstatus = read_csr(mstatus);
+    nest->threshold = irq_plan_threshold();
+    nest->stats = stats;
+    nest->opened = mcycle_read();
+
+    irq_plan_set_threshold(priority);
+    set_csr(mstatus, MSTATUS_MIE);
+}
+
+/***************************************************************************//**
+ * See "irq_plan.h" for details of how to use this function.
+ */
+void irq_nest_exit(const irq_nest_t * nest)
+{
+    clear_csr(mstatus, MSTATUS_MIE);
+
+    irq_plan_set_threshold(nest->threshold);
+    write_csr(mepc, nest->mepc);
+    write_csr(mstatus, nest->mstatus);
+
+    nest->stats->nested += (uint32_t)(mcycle_read() - nest->opened);
+}
+
+/*------------------------------------------------------------------------------
+  Longest measured time source idx may have to wait for another handler: the
+  whole run of one that does not nest or nests no lower than idx, and the
+  run outside its window of one that nests below it.
+ */
+static uint32_t worst_blocking(const irq_plan_entry_t * plan, uint32_t count,
+                               uint32_t idx)
+{
+    uint32_t worst = 0u;
+    uint32_t blocking;
+    uint32_t other;
+
+    for (other = 0u; other < count; other++)
+    {
+        if ((other == idx) || (0 == plan[other].stats))
+        {
+            continue;
+        }
+        if ((0u == (plan[other].flags & IRQ_PLAN_NESTS)) ||
+            (plan[other].priority >= plan[idx].priority))
+        {
+            blocking = plan[other].stats->max_cycles;
+        }
+        else
+        {
+            blocking = plan[other].stats->max_masked;
+        }
+        if (blocking > worst)
+        {
+            worst = blocking;
+        }
+    }
+
+    return worst;
+}
+
+/***************************************************************************//**
+ * See "irq_plan.h" for details of how to use this function.
+ */
+uint32_t irq_plan_check(const irq_plan_entry_t * plan, uint32_t count,
+                        irq_plan_out_t out)
+{
+    char line[96];
+    char * p;
+    const char * name;
+    uint32_t over = 0u;
+    uint32_t worst;
+    uint32_t len;
+    uint32_t idx;
+
+    out(" irq          prio  nests   target cycles    worst cycles\r\n");
+
+    for (idx = 0u; idx < count; idx++)
+    {
+        name = (0 != plan[idx].stats) ? plan[idx].stats->name : "?";
+        worst = worst_blocking(plan, count, idx);
+
+        p = line;
+        p = fmt_char(p, ' ');
+        p = fmt_str(p, name);
+        for (len = 0u; ('\0' != name[len]) && (len < IRQ_PLAN_NAME_WIDTH); len++)
+        {
+            ;
+        }
+        for (; len < IRQ_PLAN_NAME_WIDTH; len++)
+        {
+            p = fmt_char(p, ' ');
+        }
+        p = fmt_u32(p, plan[idx].priority, 5u, ' ');
+        p = fmt_str(p, (0u != (plan[idx].flags & IRQ_PLAN_NESTS)) ? "    yes" : "     no");
+        if (0u != plan[idx].max_latency)
+        {
+            p = fmt_u32(p, plan[idx].max_latency, 16u, ' ');
+        }
+        else
+        {
+            p = fmt_str(p, "               -");
+        }
+        p = fmt_u32(p, worst, 16u, ' ');
+        if ((0u != plan[idx].max_latency) && (worst > plan[idx].max_latency))
+        {
+            p = fmt_str(p, "  OVER");
+            over++;
+        }
+        p = fmt_str(p, "\r\n");
+        *p = '\0';
+
+        out(line);
+    }
+
+    return over;
+}
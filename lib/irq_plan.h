@@ -0,0 +1,131 @@
+/*******************************************************************************
+ * @file irq_plan.h
+ *
+ * @brief PLIC priority plan, nested interrupts and latency targets (MPFS).
+ *
+ * Every source is put in a class and gets that class's PLIC priority, so
+ * what may preempt what is decided in one table rather than by scattered
+ * PLIC_SetPriority() calls:
+ *
+ *     IRQ_PRIO_TIMER      7   machine timer, profiler (local, not PLIC)
+ *     IRQ_PRIO_DISPLAY    6   RTC alarm committing display frames
+ *     IRQ_PRIO_IO         4   short GPIO and peripheral handlers
+ *     IRQ_PRIO_CONSOLE    2   console input
+ *     IRQ_PRIO_LOG        1   handlers that print
+ *
+ * Trap entry clears MIE, so by default no handler is ever preempted and a
+ * slow one delays every other source. A slow, low-priority handler opens a
+ * nesting window around its slow part instead:
+ *
+ *     irq_nest_t nest;
+ *
+ *     IRQ_STATS_ENTER(&g_irq_button);
+ *     irq_nest_enter(&nest, IRQ_PRIO_LOG, &g_irq_button);
+ *     MSS_UART_polled_tx_string(...);
+ *     irq_nest_exit(&nest);
+ *     IRQ_STATS_EXIT(&g_irq_button);
+ *
+ * irq_nest_enter() saves mepc and mstatus, which a nested trap overwrites,
+ * raises the hart's PLIC threshold to the handler's own priority, so only
+ * higher sources get through, and sets MIE. Local interrupts (the machine
+ * timer and software interrupts) are not gated by the threshold and can
+ * preempt any open window. irq_nest_exit() undoes all of it in reverse.
+ * The source being handled has been claimed and not yet completed, so it
+ * cannot re-enter itself.
+ *
+ * Each entry may have a latency target in cycles. irq_plan_check() bounds
+ * the worst wait of each source from the irq_stats.h run times measured so
+ * far: a source waits for the whole of any handler that does not nest, or
+ * that does but has the same or a higher priority, and for the part of a
+ * lower priority nesting handler outside its window: before
+ * irq_nest_enter() and after irq_nest_exit(), MIE is clear and nothing gets
+ * in. irq_nest_exit() adds each window's length to the handler's irq_stat_t
+ * for this, so a nesting handler must have one. Sources over their target are
+ * reported, so a handler that has grown too slow for the plan shows up at
+ * run time rather than as a glitch on the display.
+ *
+ * All PLIC threshold changes must go through this module, which keeps a
+ * copy of each hart's threshold to restore.
+ */
+
+#ifndef IRQ_PLAN_H_
+#define IRQ_PLAN_H_
+
+#include <stdint.h>
+#include "irq_stats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IRQ_PRIO_TIMER              7u
+#define IRQ_PRIO_DISPLAY            6u
+#define IRQ_PRIO_IO                 4u
+#define IRQ_PRIO_CONSOLE            2u
+#define IRQ_PRIO_LOG                1u
+
+/* source of a local interrupt; it has no PLIC priority to set */
+#define IRQ_PLAN_LOCAL              0xFFFFFFFFu
+
+/* flags */
+#define IRQ_PLAN_NESTS              0x01u   /* handler opens a nesting window */
+
+typedef struct irq_plan_entry
+{
+    uint32_t source;                /* PLIC source number or IRQ_PLAN_LOCAL */
+    uint8_t priority;
+    uint8_t flags;
+    uint32_t max_latency;           /* cycles; 0 for no target */
+    irq_stat_t * stats;             /* run times of the source's handler */
+} irq_plan_entry_t;
+
+typedef struct irq_nest
+{
+    uintptr_t mepc;
+    uintptr_t mstatus;
+    uint32_t threshold;
+    irq_stat_t * stats;
+    uint64_t opened;                /* mcycle at irq_nest_enter() */
+} irq_nest_t;
+
+/*------------------------------------------------------------------------------
+  Called once per report line, e.g. console_tx().
+ */
+typedef void (*irq_plan_out_t)(const char * line);
+
+/***************************************************************************//**
+ * irq_plan_apply() sets the PLIC priority of every PLIC source in the plan
+ * and sets the calling hart's threshold to 0. Call it after PLIC_init() and
+ * before enabling the sources.
+ */
+void irq_plan_apply(const irq_plan_entry_t * plan, uint32_t count);
+
+/***************************************************************************//**
+ * irq_plan_set_threshold() sets the calling hart's PLIC threshold;
+ * irq_plan_threshold() returns it.
+ */
+void irq_plan_set_threshold(uint32_t threshold);
+uint32_t irq_plan_threshold(void);
+
+/***************************************************************************//**
+ * irq_nest_enter() lets sources above priority preempt the calling handler;
+ * irq_nest_exit() closes the window again. Call both from the same handler,
+ * in that order, between its IRQ_STATS_ENTER() and IRQ_STATS_EXIT() on
+ * stats.
+ */
+void irq_nest_enter(irq_nest_t * nest, uint32_t priority, irq_stat_t * stats);
+void irq_nest_exit(const irq_nest_t * nest);
+
+/***************************************************************************//**
+ * irq_plan_check() prints each source's priority, latency target and
+ * current worst-case bound.
+ * @return  the number of sources over their target.
+ */
+uint32_t irq_plan_check(const irq_plan_entry_t * plan, uint32_t count,
+                        irq_plan_out_t out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IRQ_PLAN_H_ */
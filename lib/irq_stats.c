@@ -0,0 +1,104 @@
+/*******************************************************************************
+ * @file irq_stats.c
+ *
+ * @brief Per-interrupt call counts and run times.
+ *
+ * See "irq_stats.h" for details of how to use this module.
+ */
+
+#include "irq_stats.h"
+#include "telemetry_records.h"
+#include "fmt.h"
+
+#define IRQ_STATS_NAME_WIDTH        12u
+
+/***************************************************************************//**
+ * See "irq_stats.h" for details of how to use this function.
+ */
+void irq_stats_report(irq_stat_t * const * stats, uint32_t count,
+                      irq_stats_out_t out)
+{
+    char line[112];
+    char * p;
+    const irq_stat_t * stat;
+    uint64_t now = mcycle_read();
+    uint32_t calls;
+    uint32_t len;
+    uint32_t idx;
+
+    out(" irq          hart      calls    total cycles    mean       max     since last\r\n");
+
+    for (idx = 0u; idx < count; idx++)
+    {
+        stat = stats[idx];
+        calls = stat->count;
+
+        p = line;
+        p = fmt_char(p, ' ');
+        p = fmt_str(p, stat->name);
+        for (len = 0u; ('\0' != stat->name[len]) && (len < IRQ_STATS_NAME_WIDTH); len++)
+        {
+            ;
+        }
+        for (; len < IRQ_STATS_NAME_WIDTH; len++)
+        {
+            p = fmt_char(p, ' ');
+        }
+        p = fmt_u32(p, stat->hartid, 5u, ' ');
+        p = fmt_u32(p, calls, 11u, ' ');
+        p = fmt_u64(p, stat->total_cycles, 16u, ' ');
+        p = fmt_u64(p, (0u != calls) ? (stat->total_cycles / calls) : 0u, 8u, ' ');
+        p = fmt_u32(p, stat->max_cycles, 10u, ' ');
+        if (0u != calls)
+        {
+            p = fmt_u64(p, now - stat->last, 15u, ' ');
+        }
+        else
+        {
+            p = fmt_str(p, "              -");
+        }
+        p = fmt_str(p, "\r\n");
+        *p = '\0';
+
+        out(line);
+    }
+}
+
+/***************************************************************************//**
+ * See "irq_stats.h" for details of how to use this function.
+ */
+void irq_stats_send(irq_stat_t * const * stats, uint32_t count,
+                    telemetry_t * tlm)
+{
+    const irq_stat_t * stat;
+    uint32_t idx;
+
+    for (idx = 0u; idx < count; idx++)
+    {
+        stat = stats[idx];
+        telemetry_begin(tlm, TLM_IRQ_STATS);
+        telemetry_put_u32(tlm, stat->hartid);
+        telemetry_put_u32(tlm, stat->id);
+        telemetry_put_u32(tlm, stat->count);
+        telemetry_put_u64(tlm, stat->total_cycles);
+        telemetry_put_u32(tlm, stat->max_cycles);
+        telemetry_put_u64(tlm, stat->last);
+        (void)telemetry_end(tlm);
+    }
+}
+
+/***************************************************************************//**
+ * See "irq_stats.h" for details of how to use this function.
+ */
+void irq_stats_clear(irq_stat_t * const * stats, uint32_t count)
+{
+    uint32_t idx;
+
+    for (idx = 0u; idx < count; idx++)
+    {
+        stats[idx]->count = 0u;
+        stats[idx]->total_cycles = 0u;
+        stats[idx]->max_cycles = 0u;
+        stats[idx]->max_masked = 0u;
+    }
+}
@@ -0,0 +1,147 @@
+/*******************************************************************************
+ * @file irq_stats.h
+ *
+ * @brief Per-interrupt call counts and run times.
+ *
+ * Each interrupt source has an irq_stat_t. Bracketing the handler body with
+ * IRQ_STATS_ENTER()/IRQ_STATS_EXIT() counts the calls and accumulates the
+ * mcycle time between the two, so a handler that has started eating the CPU
+ * shows up in the totals and one with a rare long path in the maximum:
+ *
+ *     static irq_stat_t g_rtc_irq = IRQ_STAT_INIT("rtc_wakeup", RTC_WAKEUP_PLIC, 1u);
+ *
+ *     uint8_t rtc_wakeup_plic_IRQHandler(void)
+ *     {
+ *         IRQ_STATS_ENTER(&g_rtc_irq);
+ *         ...
+ *         IRQ_STATS_EXIT(&g_rtc_irq);
+ *         return EXT_IRQ_KEEP_ENABLED;
+ *     }
+ *
+ * A handler that opens a nesting window (irq_plan.h) only holds other
+ * sources off outside it; max_masked is its longest call less the time in
+ * its windows, which irq_nest_exit() adds up in nested.
+ *
+ * That is two mcycle reads and a few loads and stores per interrupt, cheap
+ * enough to leave in production builds. The time from the trap to the first
+ * instruction of the handler, and from its last back to the interrupted
+ * code, is spent in the HAL's dispatch and is not counted.
+ *
+ * irq_stats_report() prints a table of a set of sources, e.g. from a console
+ * command; irq_stats_send() sends them as TLM_IRQ_STATS telemetry records,
+ * for targets with no console.
+ *
+ * An irq_stat_t belongs to the hart that takes its interrupt; the counts are
+ * read without locking from other code, so a report can be one interrupt
+ * behind. The entries and exits counts are never cleared: while they differ
+ * a call is in progress, which irq_affinity_set() waits out before taking
+ * the source away from a hart.
+ */
+
+#ifndef IRQ_STATS_H_
+#define IRQ_STATS_H_
+
+#include <stdint.h>
+#include "mcycle.h"
+#include "telemetry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+  Source ids: the PLIC source number for external interrupts, the mcause
+  interrupt code with IRQ_STAT_LOCAL set for local ones (software, timer and
+  the Mi-V external and local lines).
+ */
+#define IRQ_STAT_LOCAL              0x8000u
+
+#define IRQ_STAT_SOFTWARE           (IRQ_STAT_LOCAL | 3u)
+#define IRQ_STAT_TIMER              (IRQ_STAT_LOCAL | 7u)
+#define IRQ_STAT_EXTERNAL           (IRQ_STAT_LOCAL | 11u)
+
+typedef struct irq_stat
+{
+    const char * name;
+    uint16_t id;
+    uint8_t hartid;
+    uint32_t count;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+    uint64_t last;                  /* mcycle at entry to the latest call */
+    uint32_t entries;               /* calls started, never cleared */
+    uint32_t exits;                 /* calls finished, never cleared */
+    uint32_t nested;                /* cycles of this call in nesting windows */
+    uint32_t max_masked;            /* longest call, less its nesting windows */
+} irq_stat_t;
+
+#define IRQ_STAT_INIT(name, id, hartid)                                     \
+    { (name), (id), (hartid), 0u, 0u, 0u, 0u, 0u, 0u, 0u, 0u }
+
+/*------------------------------------------------------------------------------
+  Called once per report line, e.g. console_tx() or
+  safe_MSS_UART0_polled_tx_string().
+ */
+typedef void (*irq_stats_out_t)(const char * line);
+
+static inline void irq_stats_enter(irq_stat_t * stat)
+{
+    __atomic_store_n(&stat->entries, stat->entries + 1u, __ATOMIC_RELAXED);
+    stat->last = mcycle_read();
+}
+
+static inline void irq_stats_exit(irq_stat_t * stat)
+{
+    uint32_t cycles = (uint32_t)(mcycle_read() - stat->last);
+    uint32_t masked = cycles - stat->nested;
+
+    stat->count++;
+    stat->total_cycles += cycles;
+    if (cycles > stat->max_cycles)
+    {
+        stat->max_cycles = cycles;
+    }
+    if (masked > stat->max_masked)
+    {
+        stat->max_masked = masked;
+    }
+    stat->nested = 0u;
+    __atomic_store_n(&stat->exits, stat->exits + 1u, __ATOMIC_RELEASE);
+}
+
+/*------------------------------------------------------------------------------
+  Non-zero while a call of the handler is in progress on some hart.
+ */
+static inline uint8_t irq_stats_busy(const irq_stat_t * stat)
+{
+    return (uint8_t)(__atomic_load_n(&stat->entries, __ATOMIC_ACQUIRE) !=
+                     __atomic_load_n(&stat->exits, __ATOMIC_ACQUIRE));
+}
+
+#define IRQ_STATS_ENTER(stat)       irq_stats_enter(stat)
+#define IRQ_STATS_EXIT(stat)        irq_stats_exit(stat)
+
+/***************************************************************************//**
+ * irq_stats_report() prints one line per source: hart, calls, total, mean
+ * and maximum cycles, and cycles since the latest call.
+ */
+void irq_stats_report(irq_stat_t * const * stats, uint32_t count,
+                      irq_stats_out_t out);
+
+/***************************************************************************//**
+ * irq_stats_send() sends one TLM_IRQ_STATS record per source.
+ */
+void irq_stats_send(irq_stat_t * const * stats, uint32_t count,
+                    telemetry_t * tlm);
+
+/***************************************************************************//**
+ * irq_stats_clear() zeroes the counts of the given sources. A handler that
+ * is running at the time still adds its call when it exits.
+ */
+void irq_stats_clear(irq_stat_t * const * stats, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IRQ_STATS_H_ */
@@ -0,0 +1,39 @@
+/*******************************************************************************
+ * @file mcycle.h
+ *
+ * @brief 64-bit mcycle read on RV32 and RV64.
+ *
+ * On RV64 mcycle is a single CSR read. On RV32 (Mi-V) the high half is read
+ * before and after the low half and the read repeated if it changed, so a
+ * carry between the two halves cannot give a value 2^32 cycles out.
+ */
+
+#ifndef MCYCLE_H_
+#define MCYCLE_H_
+
+#include <stdint.h>
+
+static inline uint64_t mcycle_read(void)
+{
+#if __riscv_xlen == 64
+    uint64_t cycles;
+
+    __asm volatile ("csrr %0, mcycle" : "=r"(cycles));
+    return cycles;
+#else
+    uint32_t hi;
+    uint32_t lo;
+    uint32_t hi2;
+
+    do
+    {
+        __asm volatile ("csrr %0, mcycleh" : "=r"(hi));
+        __asm volatile ("csrr %0, mcycle" : "=r"(lo));
+        __asm volatile ("csrr %0, mcycleh" : "=r"(hi2));
+    } while (hi != hi2);
+
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+#endif /* MCYCLE_H_ */
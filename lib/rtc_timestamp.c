@@ -0,0 +1,223 @@
+/*******************************************************************************
+ * @file rtc_timestamp.c
+ *
+ * @brief Sub-second wall-clock timestamps for the MSS RTC.
+ *
+ * See "rtc_timestamp.h" for details of how to use this service.
+ */
+
+#include "mpfs_hal/mss_hal.h"
+#include "rtc_timestamp.h"
+
+/*------------------------------------------------------------------------------
+  Gaps of up to this many seconds between two edges are still measured. Larger
+  gaps only re-latch the epoch.
+ */
+#define RTC_TS_MAX_MEASURED_GAP     4u
+
+/*------------------------------------------------------------------------------
+  After this many consecutive outliers the estimate steps to the measurement:
+  the nominal rate was wrong, rather than edges being noticed late.
+ */
+#define RTC_TS_MAX_OUTLIER_RUN      3u
+
+#define US_PER_SECOND               1000000u
+
+/*------------------------------------------------------------------------------
+  State of one RTC second. Two copies are kept; the writer fills the inactive
+  one and then publishes it, so readers (including interrupt handlers that
+  preempt the writer) always see a consistent epoch without taking a lock.
+ */
+typedef struct rtc_ts_epoch
+{
+    uint64_t mcycle;            /* mcycle latched at the RTC edge */
+    uint64_t us_per_cycle_q32;  /* 2^32 * 1e6 / cycles per second */
+    uint32_t cycles_per_second;
+    uint32_t seconds;
+} rtc_ts_epoch_t;
+
+static rtc_ts_epoch_t g_epoch[2];
+static volatile uint32_t g_active_epoch = 0u;
+
+static uint64_t g_cps_q;            /* filtered cycles/second, fixed point */
+static uint8_t g_have_edge = 0u;
+static uint8_t g_outlier_run = 0u;
+static rtc_ts_stats_t g_stats;
+
+/*------------------------------------------------------------------------------
+  Local functions.
+ */
+static void publish_epoch(uint64_t mcycle, uint32_t seconds);
+static void update_rate(uint64_t measured_cycles, uint32_t gap);
+static void interpolate(const rtc_ts_epoch_t * epoch, uint64_t mcycle,
+                        rtc_timestamp_t * ts);
+
+/***************************************************************************//**
+ * See "rtc_timestamp.h" for details of how to use this function.
+ */
+void rtc_ts_init(uint32_t nominal_cycles_per_second)
+{
+    g_cps_q = (uint64_t)nominal_cycles_per_second << RTC_TS_CPS_FRAC_BITS;
+    g_have_edge = 0u;
+    g_outlier_run = 0u;
+
+    g_stats.edges = 0u;
+    g_stats.resyncs = 0u;
+    g_stats.outliers = 0u;
+    g_stats.cycles_per_second = nominal_cycles_per_second;
+    g_stats.last_error_ppm = 0;
+
+    publish_epoch(readmcycle(), 0u);
+}
+
+/***************************************************************************//**
+ * See "rtc_timestamp.h" for details of how to use this function.
+ */
+void rtc_ts_second_edge(uint32_t rtc_seconds)
+{
+    uint64_t now = readmcycle();
+    const rtc_ts_epoch_t * last = &g_epoch[g_active_epoch];
+    uint32_t gap = rtc_seconds - last->seconds;
+
+    g_stats.edges++;
+
+    if ((0u != g_have_edge) && (gap >= 1u) && (gap <= RTC_TS_MAX_MEASURED_GAP))
+    {
+        update_rate(now - last->mcycle, gap);
+    }
+    else if (0u != g_have_edge)
+    {
+        g_stats.resyncs++;
+    }
+
+    g_have_edge = 1u;
+    publish_epoch(now, rtc_seconds);
+}
+
+/***************************************************************************//**
+ * See "rtc_timestamp.h" for details of how to use this function.
+ */
+void rtc_ts_now(rtc_timestamp_t * ts)
+{
+    rtc_ts_from_mcycle(readmcycle(), ts);
+}
+
+/***************************************************************************//**
+ * See "rtc_timestamp.h" for details of how to use this function.
+ */
+uint64_t rtc_ts_now_us(void)
+{
+    rtc_timestamp_t ts;
+
+    rtc_ts_now(&ts);
+
+    return ((uint64_t)ts.seconds * US_PER_SECOND) + ts.microseconds;
+}
+
+/***************************************************************************//**
+ * See "rtc_timestamp.h" for details of how to use this function.
+ */
+void rtc_ts_from_mcycle(uint64_t mcycle, rtc_timestamp_t * ts)
+{
+    rtc_ts_epoch_t epoch;
+    uint32_t active;
+
+    /* Copy the published epoch, retrying if an edge was published meanwhile. */
+    do
+    {
+        active = g_active_epoch;
+        epoch = g_epoch[active];
+        __sync_synchronize();
+    } while (active != g_active_epoch);
+
+    interpolate(&epoch, mcycle, ts);
+}
+
+/***************************************************************************//**
+ * See "rtc_timestamp.h" for details of how to use this function.
+ */
+void rtc_ts_get_stats(rtc_ts_stats_t * stats)
+{
+    *stats = g_stats;
+}
+
+/*------------------------------------------------------------------------------
+  Fill in the inactive epoch and make it the active one.
+ */
+static void publish_epoch(uint64_t mcycle, uint32_t seconds)
+{
+    uint32_t next = g_active_epoch ^ 1u;
+    uint32_t cps = (uint32_t)(g_cps_q >> RTC_TS_CPS_FRAC_BITS);
+
+    g_epoch[next].mcycle = mcycle;
+    g_epoch[next].seconds = seconds;
+    g_epoch[next].cycles_per_second = cps;
+
+    /* One division per second so that readers only need a multiply. */
+    g_epoch[next].us_per_cycle_q32 =
+            (((uint64_t)US_PER_SECOND << 32) + (cps / 2u)) / cps;
+
+    __sync_synchronize();
+    g_active_epoch = next;
+
+    g_stats.cycles_per_second = cps;
+}
+
+/*------------------------------------------------------------------------------
+  Feed one measurement into the drift filter. measured_cycles spans gap RTC
+  seconds.
+ */
+static void update_rate(uint64_t measured_cycles, uint32_t gap)
+{
+    uint64_t measured_q = (measured_cycles << RTC_TS_CPS_FRAC_BITS) / gap;
+    int64_t error_q = (int64_t)(measured_q - g_cps_q);
+    uint64_t abs_error_q = (error_q < 0) ? (uint64_t)(-error_q) : (uint64_t)error_q;
+
+    g_stats.last_error_ppm =
+            (int32_t)((error_q * (int64_t)US_PER_SECOND) / (int64_t)g_cps_q);
+
+    if (abs_error_q > (g_cps_q / RTC_TS_OUTLIER_DIV))
+    {
+        g_stats.outliers++;
+        g_outlier_run++;
+
+        if (g_outlier_run >= RTC_TS_MAX_OUTLIER_RUN)
+        {
+            g_cps_q = measured_q;
+            g_outlier_run = 0u;
+        }
+        return;
+    }
+
+    g_outlier_run = 0u;
+    g_cps_q = (uint64_t)((int64_t)g_cps_q + (error_q >> RTC_TS_DRIFT_SHIFT));
+}
+
+/*------------------------------------------------------------------------------
+  Convert an mcycle value to wall-clock time relative to an epoch. The result
+  is clamped to the last microsecond of the epoch's second so that time does
+  not run ahead of the RTC if the next edge has not been latched yet.
+ */
+static void interpolate(const rtc_ts_epoch_t * epoch, uint64_t mcycle,
+                        rtc_timestamp_t * ts)
+{
+    uint64_t delta = mcycle - epoch->mcycle;
+    uint64_t us;
+
+    if (mcycle < epoch->mcycle)
+    {
+        delta = 0u;
+    }
+
+    if (delta >= epoch->cycles_per_second)
+    {
+        us = US_PER_SECOND - 1u;
+    }
+    else
+    {
+        us = (delta * epoch->us_per_cycle_q32) >> 32;
+    }
+
+    ts->seconds = epoch->seconds;
+    ts->microseconds = (uint32_t)us;
+}
@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * @file rtc_timestamp.h
+ *
+ * @brief Sub-second wall-clock timestamps for the MSS RTC.
+ *
+ * The MSS RTC only resolves to one second. This service latches mcycle each
+ * time the RTC second changes and interpolates between two RTC seconds with
+ * the hart cycle counter, giving microsecond resolution wall-clock time.
+ *
+ * The number of mcycle ticks per RTC second is measured on every edge and
+ * filtered, so drift between the CPU clock and the RTC clock is corrected
+ * over time. The RTC stays the reference: interpolated time never runs past
+ * the next RTC second, so timestamps are monotonic across an edge.
+ */
+
+#ifndef RTC_TIMESTAMP_H_
+#define RTC_TIMESTAMP_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*------------------------------------------------------------------------------
+  The cycles-per-second estimate is kept in fixed point with this many
+  fractional bits.
+ */
+#define RTC_TS_CPS_FRAC_BITS        8u
+
+/*------------------------------------------------------------------------------
+  Weight of a new measurement in the drift filter: 1 / (2^RTC_TS_DRIFT_SHIFT).
+ */
+#define RTC_TS_DRIFT_SHIFT          4u
+
+/*------------------------------------------------------------------------------
+  A measured second that differs from the current estimate by more than
+  1 / RTC_TS_OUTLIER_DIV (0.5%) is not fed into the drift filter. This rejects
+  edges that were noticed late, e.g. while the hart was busy elsewhere.
+ */
+#define RTC_TS_OUTLIER_DIV          200u
+
+/*------------------------------------------------------------------------------
+  Wall-clock timestamp. seconds is in whatever unit the caller passes to
+  rtc_ts_second_edge(), e.g. RTC binary count or seconds of the day.
+ */
+typedef struct rtc_timestamp
+{
+    uint32_t seconds;
+    uint32_t microseconds;
+} rtc_timestamp_t;
+
+/*------------------------------------------------------------------------------
+  Drift filter statistics.
+ */
+typedef struct rtc_ts_stats
+{
+    uint32_t edges;             /* RTC edges latched */
+    uint32_t resyncs;           /* edges that did not follow the previous one */
+    uint32_t outliers;          /* measurements rejected by the filter */
+    uint32_t cycles_per_second; /* current filtered estimate */
+    int32_t  last_error_ppm;    /* last measurement vs. estimate */
+} rtc_ts_stats_t;
+
+/***************************************************************************//**
+ * rtc_ts_init() resets the service.
+ *
+ * @param nominal_cycles_per_second  Expected mcycle rate, used until the first
+ *                                   two RTC edges have been measured.
+ */
+void rtc_ts_init(uint32_t nominal_cycles_per_second);
+
+/***************************************************************************//**
+ * rtc_ts_second_edge() must be called as soon as possible after the RTC
+ * second changes, from the RTC interrupt handler or from the loop polling
+ * MSS_RTC_get_update_flag(). It latches mcycle and updates the drift filter.
+ *
+ * A seconds value that does not follow the previous one (time was set, or
+ * edges were missed) re-synchronises the service. Missed edges are averaged
+ * over, a jump backwards or of more than a few seconds is not measured.
+ *
+ * @param rtc_seconds  Value of the RTC seconds counter after the edge.
+ */
+void rtc_ts_second_edge(uint32_t rtc_seconds);
+
+/***************************************************************************//**
+ * rtc_ts_now() returns the current interpolated wall-clock time. It is safe
+ * to call from interrupt context. mcycle is a per-hart counter, so it must be
+ * called on the hart that calls rtc_ts_second_edge().
+ */
+void rtc_ts_now(rtc_timestamp_t * ts);
+
+/***************************************************************************//**
+ * rtc_ts_now_us() returns the current wall-clock time in microseconds.
+ */
+uint64_t rtc_ts_now_us(void);
+
+/***************************************************************************//**
+ * rtc_ts_from_mcycle() converts an mcycle value previously read on this hart
+ * into wall-clock time, for stamping events after the fact. The value must be
+ * no older than the last RTC edge.
+ */
+void rtc_ts_from_mcycle(uint64_t mcycle, rtc_timestamp_t * ts);
+
+/***************************************************************************//**
+ * rtc_ts_get_stats() returns a copy of the drift filter statistics.
+ */
+void rtc_ts_get_stats(rtc_ts_stats_t * stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RTC_TIMESTAMP_H_ */
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * @file sample_prof.c
+ *
+ * @brief Statistical profiler: samples mepc from a timer interrupt.
+ *
+ * See "sample_prof.h" for details of how to use this module.
+ */
+
+#include "sample_prof.h"
+#include "telemetry_records.h"
+
+/***************************************************************************//**
+ * See "sample_prof.h" for details of how to use this function.
+ */
+void sample_prof_init(sample_prof_t * prof, uint8_t hartid)
+{
+    prof->enabled = 0u;
+    prof->head = 0u;
+    prof->tail = 0u;
+    prof->dropped = 0u;
+    prof->hartid = hartid;
+    prof->samples = 0u;
+}
+
+/*------------------------------------------------------------------------------
+  Send up to max_records records of up to SAMPLE_PROF_PER_RECORD samples;
+  with whole set, only full records.
+ */
+static uint32_t send_records(sample_prof_t * prof, telemetry_t * tlm,
+                             uint32_t max_records, uint8_t whole)
+{
+    uint32_t sent = 0u;
+    uint32_t tail = prof->tail;
+    uint32_t count;
+    uint32_t idx;
+    uintptr_t pc;
+    uintptr_t last;
+
+    while (max_records-- > 0u)
+    {
+        count = prof->head - tail;
+        if (count > SAMPLE_PROF_PER_RECORD)
+        {
+            count = SAMPLE_PROF_PER_RECORD;
+        }
+        if ((0u == count) || (whole && (count < SAMPLE_PROF_PER_RECORD)))
+        {
+            break;
+        }
+
+        /* hartid, dropped so far, first PC, then deltas. */
+        telemetry_begin(tlm, TLM_PROFILE);
+        telemetry_put_u32(tlm, prof->hartid);
+        telemetry_put_u32(tlm, prof->dropped);
+        last = prof->pc[tail & (SAMPLE_PROF_RING_SIZE - 1u)];
+        telemetry_put_u64(tlm, (uint64_t)last);
+        for (idx = 1u; idx < count; idx++)
+        {
+            pc = prof->pc[(tail + idx) & (SAMPLE_PROF_RING_SIZE - 1u)];
+            telemetry_put_i32(tlm, (int32_t)(pc - last));
+            last = pc;
+        }
+        (void)telemetry_end(tlm);
+
+        /* Dropped by the link or not, the samples are gone from the ring. */
+        tail += count;
+        prof->tail = tail;
+        sent += count;
+    }
+
+    prof->samples += sent;
+    return sent;
+}
+
+/***************************************************************************//**
+ * See "sample_prof.h" for details of how to use this function.
+ */
+uint32_t sample_prof_drain(sample_prof_t * prof, telemetry_t * tlm,
+                           uint32_t max_records)
+{
+    return send_records(prof, tlm, max_records, 1u);
+}
+
+/***************************************************************************//**
+ * See "sample_prof.h" for details of how to use this function.
+ */
+uint32_t sample_prof_flush(sample_prof_t * prof, telemetry_t * tlm)
+{
+    return send_records(prof, tlm,
+                        (SAMPLE_PROF_RING_SIZE / SAMPLE_PROF_PER_RECORD) + 1u,
+                        0u);
+}
@@ -0,0 +1,145 @@
+/*******************************************************************************
+ * @file sample_prof.h
+ *
+ * @brief Statistical profiler: samples mepc from a timer interrupt.
+ *
+ * A periodic timer interrupt (the CLINT machine timer through the HAL's
+ * SysTick, or a CoreTimer) calls sample_prof_sample(), which stores the
+ * interrupted PC, read from mepc, in a ring buffer. That is a CSR read, two
+ * loads and two stores, so the profiler can stay on in soak tests; at 1 kHz
+ * it costs well under 0.1% of a U54.
+ *
+ * The main loop moves the samples out with sample_prof_drain(), which packs
+ * them into TLM_PROFILE telemetry records: the first PC of each record in
+ * full and the rest as signed deltas from the one before, so a sample
+ * usually costs one to three bytes on the wire. Every record carries a
+ * hart id, a dropped count and a full PC, so sample_prof_drain() only sends
+ * full records of SAMPLE_PROF_PER_RECORD samples; the loop checks
+ * sample_prof_pending() before calling it, and sends what is left in a
+ * short record with sample_prof_flush() when sampling stops or the samples
+ * have waited long enough. If the ring fills because the loop did not drain
+ * it in time, further samples are counted in dropped and the host reports
+ * them.
+ *
+ * On the host, lib/sample_prof.py reads the telemetry stream, looks every
+ * PC up in the ELF and prints a per-function histogram for each hart.
+ *
+ *     void U54_1_sysTick_IRQHandler(void)
+ *     {
+ *         sample_prof_sample(&g_prof);
+ *     }
+ *
+ *     for (;;)
+ *     {
+ *         ...
+ *         if (sample_prof_pending(&g_prof) >= SAMPLE_PROF_PER_RECORD)
+ *         {
+ *             (void)sample_prof_drain(&g_prof, &g_tlm_prof, 1u);
+ *         }
+ *         else if (once_a_second)
+ *         {
+ *             (void)sample_prof_flush(&g_prof, &g_tlm_prof);
+ *         }
+ *     }
+ *
+ * One sample_prof_t per hart; the hart's timer interrupt is the only
+ * writer of head, the hart's drain the only writer of tail.
+ */
+
+#ifndef SAMPLE_PROF_H_
+#define SAMPLE_PROF_H_
+
+#include <stdint.h>
+#include "telemetry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Samples held between drains; a power of two. */
+#ifndef SAMPLE_PROF_RING_SIZE
+#define SAMPLE_PROF_RING_SIZE       128u
+#endif
+
+/* Samples per TLM_PROFILE record; keeps a record well inside
+   TLM_MAX_RECORD even when every delta needs the full five bytes. */
+#define SAMPLE_PROF_PER_RECORD      8u
+
+typedef struct sample_prof
+{
+    volatile uint32_t head;         /* written by the timer interrupt */
+    volatile uint32_t tail;         /* written by sample_prof_drain() */
+    volatile uint32_t dropped;      /* samples lost to a full ring */
+    volatile uint8_t enabled;
+    uint8_t hartid;
+    uint32_t samples;               /* samples sent */
+    uintptr_t pc[SAMPLE_PROF_RING_SIZE];
+} sample_prof_t;
+
+/***************************************************************************//**
+ * sample_prof_init() clears the ring. Sampling starts disabled.
+ */
+void sample_prof_init(sample_prof_t * prof, uint8_t hartid);
+
+/***************************************************************************//**
+ * sample_prof_enable() starts or stops recording; starting the timer that
+ * drives sample_prof_sample() is up to the caller.
+ */
+static inline void sample_prof_enable(sample_prof_t * prof, uint8_t enable)
+{
+    prof->enabled = enable;
+}
+
+/***************************************************************************//**
+ * sample_prof_pending() returns the number of samples waiting in the ring.
+ */
+static inline uint32_t sample_prof_pending(const sample_prof_t * prof)
+{
+    return prof->head - prof->tail;
+}
+
+/***************************************************************************//**
+ * sample_prof_sample() records the interrupted PC. Call it from the timer
+ * interrupt handler, before anything that could take another trap.
+ */
+static inline void sample_prof_sample(sample_prof_t * prof)
+{
+    uintptr_t pc;
+    uint32_t head = prof->head;
+
+    if (!prof->enabled)
+    {
+        return;
+    }
+    if ((head - prof->tail) >= SAMPLE_PROF_RING_SIZE)
+    {
+        prof->dropped++;
+        return;
+    }
+
+    __asm volatile ("csrr %0, mepc" : "=r"(pc));
+    prof->pc[head & (SAMPLE_PROF_RING_SIZE - 1u)] = pc;
+    prof->head = head + 1u;
+}
+
+/***************************************************************************//**
+ * sample_prof_drain() sends up to max_records full TLM_PROFILE records of
+ * SAMPLE_PROF_PER_RECORD samples each. Fewer samples than that stay in the
+ * ring.
+ * @return  the number of samples sent.
+ */
+uint32_t sample_prof_drain(sample_prof_t * prof, telemetry_t * tlm,
+                           uint32_t max_records);
+
+/***************************************************************************//**
+ * sample_prof_flush() sends every sample in the ring, the last record
+ * partly filled.
+ * @return  the number of samples sent.
+ */
+uint32_t sample_prof_flush(sample_prof_t * prof, telemetry_t * tlm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLE_PROF_H_ */
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""Per-function histogram from the on-target sampling profiler (sample_prof.h).
+
+Reads TLM_PROFILE telemetry records from a serial port or a capture, looks
+every sampled PC up in the ELF and prints, for each hart, the functions that
+were running most often:
+
+    sample_prof.py app.elf /dev/ttyUSB1 --seconds 60
+    sample_prof.py app.elf capture.bin --top 30
+
+Console text on the same UART is dropped unless --text is given. Samples the
+target could not buffer and records lost on the link are reported, so a
+histogram from a lossy run can be judged.
+"""
+
+import argparse
+import bisect
+import os
+import subprocess
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import telemetry_decode  # noqa: E402
+
+TLM_PROFILE = 0x03
+
+
+class Symbols:
+    def __init__(self, elf, nm):
+        output = subprocess.run([nm, "-S", "-n", "--defined-only", elf],
+                                check=True, capture_output=True, text=True).stdout
+        self.starts, self.ends, self.names = [], [], []
+        for line in output.splitlines():
+            parts = line.split()
+            if len(parts) == 4 and parts[2] in "tTwW":
+                self.starts.append(int(parts[0], 16))
+                self.ends.append(int(parts[0], 16) + int(parts[1], 16))
+                self.names.append(parts[3])
+
+    def lookup(self, pc):
+        idx = bisect.bisect_right(self.starts, pc) - 1
+        if idx >= 0 and pc < self.ends[idx]:
+            return self.names[idx]
+        return "[0x%x]" % pc
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="image running on the target")
+    parser.add_argument("input", help="serial port or capture file, - for stdin")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--seconds", type=float, help="stop after this long")
+    parser.add_argument("--top", type=int, default=20, help="functions listed per hart")
+    parser.add_argument("--nm", default=os.environ.get("NM", "riscv64-unknown-elf-nm"))
+    parser.add_argument("--text", action="store_true", help="pass console text through")
+    args = parser.parse_args()
+
+    symbols = Symbols(args.elf, args.nm)
+    pcs = {}        # hart -> {pc: samples}
+    dropped = {}    # hart -> samples the target could not buffer
+
+    def on_record(rtype, source, seq, fields):
+        if rtype != TLM_PROFILE or not isinstance(fields, dict):
+            return
+        hart = fields["hartid"]
+        dropped[hart] = fields["dropped"]
+        pc = fields["pc"]
+        hist = pcs.setdefault(hart, {})
+        hist[pc] = hist.get(pc, 0) + 1
+        for delta in fields["deltas"]:
+            pc += delta
+            hist[pc] = hist.get(pc, 0) + 1
+
+    def on_text(chunk):
+        if args.text:
+            sys.stdout.write(chunk.decode("ascii", "replace"))
+
+    decoder = telemetry_decode.Decoder(on_record, on_text)
+    source = (sys.stdin.buffer if args.input == "-"
+              else telemetry_decode.open_input(args.input, args.baud))
+    deadline = time.monotonic() + args.seconds if args.seconds else None
+    try:
+        while deadline is None or time.monotonic() < deadline:
+            data = source.read(256)
+            if not data:
+                if hasattr(source, "in_waiting"):
+                    continue
+                break
+            decoder.feed(data)
+    except KeyboardInterrupt:
+        pass
+
+    for hart in sorted(pcs):
+        funcs = {}
+        for pc, count in pcs[hart].items():
+            name = symbols.lookup(pc)
+            funcs[name] = funcs.get(name, 0) + count
+        total = sum(funcs.values())
+        print("hart %d: %d samples, %d dropped on target"
+              % (hart, total, dropped.get(hart, 0)))
+        for name, count in sorted(funcs.items(), key=lambda item: -item[1])[:args.top]:
+            print("  %6.1f%% %8d  %s" % (100.0 * count / total, count, name))
+        print()
+
+    sys.stderr.write("%d records, %d lost on the link\n" % (decoder.records, decoder.lost))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,168 @@
+/*******************************************************************************
+ * @file spinlock.c
+ *
+ * @brief Fair spinlocks for harts sharing memory, with contention counts.
+ *
+ * See "spinlock.h" for details of how to use this module.
+ */
+
+#include "spinlock.h"
+#include "mcycle.h"
+#include "fmt.h"
+
+#define LOCK_NAME_WIDTH             12u
+
+/*------------------------------------------------------------------------------
+  Counted by the new holder, under the lock.
+ */
+static void count_acquire(lock_stats_t * stats, uint8_t contended,
+                          uint64_t start)
+{
+    uint32_t wait = (uint32_t)(mcycle_read() - start);
+
+    stats->acquires++;
+    if (0u != contended)
+    {
+        stats->contended++;
+        stats->total_wait += wait;
+        if (wait > stats->max_wait)
+        {
+            stats->max_wait = wait;
+        }
+    }
+}
+
+/***************************************************************************//**
+ * See "spinlock.h" for details of how to use this function.
+ */
+void ticket_lock_acquire(ticket_lock_t * lock)
+{
+    uint64_t start = mcycle_read();
+    uint32_t ticket = __atomic_fetch_add(&lock->next, 1u, __ATOMIC_RELAXED);
+    uint8_t contended = 0u;
+
+    while (ticket != __atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE))
+    {
+        contended = 1u;
+    }
+
+    count_acquire(&lock->stats, contended, start);
+}
+
+/***************************************************************************//**
+ * See "spinlock.h" for details of how to use this function.
+ */
+void ticket_lock_release(ticket_lock_t * lock)
+{
+    /* Only the holder writes owner. */
+    __atomic_store_n(&lock->owner, lock->owner + 1u, __ATOMIC_RELEASE);
+}
+
+/***************************************************************************//**
+ * See "spinlock.h" for details of how to use this function.
+ */
+void mcs_lock_acquire(mcs_lock_t * lock, mcs_node_t * node)
+{
+    uint64_t start = mcycle_read();
+    mcs_node_t * prev;
+    uint8_t contended = 0u;
+
+    node->next = 0;
+    node->waiting = 1u;
+
+    prev = __atomic_exchange_n(&lock->tail, node, __ATOMIC_ACQ_REL);
+    if (0 != prev)
+    {
+        contended = 1u;
+        __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+        while (0u != __atomic_load_n(&node->waiting, __ATOMIC_ACQUIRE))
+        {
+            ;
+        }
+    }
+
+    count_acquire(&lock->stats, contended, start);
+}
+
+/***************************************************************************//**
+ * See "spinlock.h" for details of how to use this function.
+ */
+void mcs_lock_release(mcs_lock_t * lock, mcs_node_t * node)
+{
+    mcs_node_t * next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+    mcs_node_t * expected = node;
+
+    if (0 == next)
+    {
+        /* No one behind us, unless a hart has swapped itself into the tail
+           and not yet linked itself to us. */
+        if (__atomic_compare_exchange_n(&lock->tail, &expected, 0, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+            return;
+        }
+        while (0 == (next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE)))
+        {
+            ;
+        }
+    }
+
+    __atomic_store_n(&next->waiting, 0u, __ATOMIC_RELEASE);
+}
+
+/***************************************************************************//**
+ * See "spinlock.h" for details of how to use this function.
+ */
+void lock_stats_report(lock_stats_t * const * stats, uint32_t count,
+                       lock_stats_out_t out)
+{
+    char line[96];
+    char * p;
+    const lock_stats_t * stat;
+    uint32_t len;
+    uint32_t idx;
+
+    out(" lock            acquires   contended   mean wait    max wait\r\n");
+
+    for (idx = 0u; idx < count; idx++)
+    {
+        stat = stats[idx];
+
+        p = line;
+        p = fmt_char(p, ' ');
+        p = fmt_str(p, stat->name);
+        for (len = 0u; ('\0' != stat->name[len]) && (len < LOCK_NAME_WIDTH); len++)
+        {
+            ;
+        }
+        for (; len < LOCK_NAME_WIDTH; len++)
+        {
+            p = fmt_char(p, ' ');
+        }
+        p = fmt_u32(p, stat->acquires, 12u, ' ');
+        p = fmt_u32(p, stat->contended, 12u, ' ');
+        p = fmt_u64(p, (0u != stat->contended) ? (stat->total_wait / stat->contended) : 0u,
+                    12u, ' ');
+        p = fmt_u32(p, stat->max_wait, 12u, ' ');
+        p = fmt_str(p, "\r\n");
+        *p = '\0';
+
+        out(line);
+    }
+}
+
+/***************************************************************************//**
+ * See "spinlock.h" for details of how to use this function.
+ */
+void lock_stats_clear(lock_stats_t * const * stats, uint32_t count)
+{
+    uint32_t idx;
+
+    for (idx = 0u; idx < count; idx++)
+    {
+        stats[idx]->acquires = 0u;
+        stats[idx]->contended = 0u;
+        stats[idx]->max_wait = 0u;
+        stats[idx]->total_wait = 0u;
+    }
+}
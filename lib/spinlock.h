@@ -0,0 +1,129 @@
+/*******************************************************************************
+ * @file spinlock.h
+ *
+ * @brief Fair spinlocks for harts sharing memory, with contention counts.
+ *
+ * The HAL's mss_take_mutex() is a test-and-set lock: every waiter swaps the
+ * lock word in a loop, so the line holding it moves between the waiting
+ * harts on every attempt, and whichever hart's swap happens to land after
+ * the release gets the lock, however long the others have waited.
+ *
+ * Two replacements, both first come, first served:
+ *
+ *   ticket_lock_t  A hart takes a ticket with one amoadd.w and waits until
+ *                  the owner count reaches it. Waiters only read the owner
+ *                  count, so they spin in their own cache and the line moves
+ *                  once per release. Small, needs no per-hart state; the
+ *                  right lock for a handful of harts.
+ *
+ *   mcs_lock_t     A hart appends its own queue node with one amoswap.d and
+ *                  spins on a flag in that node, on a line of its own, which
+ *                  the previous holder clears. A release touches only the
+ *                  next waiter's line, however many are waiting. Each hart
+ *                  passes its own node, and must pass the same one to
+ *                  release it.
+ *
+ *     static ticket_lock_t g_uart_lock = TICKET_LOCK_INIT("uart0");
+ *
+ *     ticket_lock_acquire(&g_uart_lock);
+ *     MSS_UART_polled_tx_string(&g_mss_uart0_lo, msg);
+ *     ticket_lock_release(&g_uart_lock);
+ *
+ *     static mcs_lock_t g_log_lock = MCS_LOCK_INIT("log");
+ *     static mcs_node_t g_log_node HART_BSS(1);
+ *
+ *     mcs_lock_acquire(&g_log_lock, &g_log_node);
+ *     ...
+ *     mcs_lock_release(&g_log_lock, &g_log_node);
+ *
+ * Each lock counts its acquisitions and those that had to wait, with the
+ * total and longest of their waits in mcycles. The holder updates the
+ * counts, so they cost no extra atomic operations; lock_stats_report()
+ * prints them.
+ *
+ * Neither lock may be taken from an interrupt handler on a hart whose thread
+ * code may hold it.
+ */
+
+#ifndef SPINLOCK_H_
+#define SPINLOCK_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SPINLOCK_LINE_ALIGNED       __attribute__((aligned(64)))
+
+typedef struct lock_stats
+{
+    const char * name;
+    uint32_t acquires;
+    uint32_t contended;             /* acquisitions that had to wait */
+    uint32_t max_wait;              /* mcycles */
+    uint64_t total_wait;            /* mcycles */
+} lock_stats_t;
+
+#define LOCK_STATS_INIT(name)       { (name), 0u, 0u, 0u, 0u }
+
+typedef struct ticket_lock
+{
+    volatile uint32_t next SPINLOCK_LINE_ALIGNED;   /* next ticket to give */
+    volatile uint32_t owner SPINLOCK_LINE_ALIGNED;  /* ticket being served */
+    lock_stats_t stats SPINLOCK_LINE_ALIGNED;
+} ticket_lock_t;
+
+#define TICKET_LOCK_INIT(name)      { 0u, 0u, LOCK_STATS_INIT(name) }
+
+typedef struct mcs_node
+{
+    struct mcs_node * volatile next SPINLOCK_LINE_ALIGNED;
+    volatile uint32_t waiting;
+} mcs_node_t;
+
+typedef struct mcs_lock
+{
+    mcs_node_t * volatile tail SPINLOCK_LINE_ALIGNED;  /* last in the queue */
+    lock_stats_t stats SPINLOCK_LINE_ALIGNED;
+} mcs_lock_t;
+
+#define MCS_LOCK_INIT(name)         { 0, LOCK_STATS_INIT(name) }
+
+/*------------------------------------------------------------------------------
+  Called once per report line, e.g. uart0_tx_string().
+ */
+typedef void (*lock_stats_out_t)(const char * line);
+
+/***************************************************************************//**
+ * ticket_lock_acquire() waits for and takes the lock; ticket_lock_release()
+ * hands it to the next waiter.
+ */
+void ticket_lock_acquire(ticket_lock_t * lock);
+void ticket_lock_release(ticket_lock_t * lock);
+
+/***************************************************************************//**
+ * mcs_lock_acquire() queues node and waits for the lock; mcs_lock_release()
+ * hands it to the next node in the queue. node must stay valid until the
+ * release returns.
+ */
+void mcs_lock_acquire(mcs_lock_t * lock, mcs_node_t * node);
+void mcs_lock_release(mcs_lock_t * lock, mcs_node_t * node);
+
+/***************************************************************************//**
+ * lock_stats_report() prints acquisitions, contended acquisitions and the
+ * mean and longest wait of the contended ones, for each lock.
+ */
+void lock_stats_report(lock_stats_t * const * stats, uint32_t count,
+                       lock_stats_out_t out);
+
+/***************************************************************************//**
+ * lock_stats_clear() zeroes the counts. Call it while no hart uses the locks.
+ */
+void lock_stats_clear(lock_stats_t * const * stats, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPINLOCK_H_ */
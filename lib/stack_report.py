@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+"""Worst case stack depth per entry point from GCC's -fstack-usage output.
+
+Build with -fstack-usage (each object gets a .su file with the frame size of
+every function) and, with GCC 10 or later, -fcallgraph-info=su (a .ci file
+with the calls each function makes). Without .ci files the call graph is
+read from the linked image with objdump instead.
+
+    stack_report.py build/                              # .su and .ci files
+    stack_report.py build/ --elf app.elf                # calls from objdump
+    stack_report.py build/ --elf app.elf --stack-size 2048 --trap-frame 128
+
+Entry points are main, e51, u54_1 .. u54_4 and every *_Handler/*IRQHandler
+found, plus any given with --root. Interrupts run on the interrupted
+stack, so the required size is the deepest thread entry point plus the
+deepest handler plus the trap frame the HAL pushes (--trap-frame; 128 bytes
+on the Mi-V, 256 on the MPFS harts). With --stack-size the script exits
+non-zero if that does not fit.
+
+Results are a lower bound where a function has a dynamic frame (alloca,
+VLAs), calls through a pointer or recurses; those are flagged.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+THREAD_ROOTS = ["main", "e51", "u54_1", "u54_2", "u54_3", "u54_4"]
+ISR_PATTERN = re.compile(r".*(_IRQHandler|_Handler)$")
+
+
+def find_files(paths, suffix):
+    for path in paths:
+        if os.path.isfile(path):
+            if path.endswith(suffix):
+                yield path
+            continue
+        for root, _, files in os.walk(path):
+            for name in files:
+                if name.endswith(suffix):
+                    yield os.path.join(root, name)
+
+
+def read_su(paths):
+    """function -> (bytes, qualifier)"""
+    frames = {}
+    for path in find_files(paths, ".su"):
+        with open(path) as handle:
+            for line in handle:
+                parts = line.rstrip("\n").split("\t")
+                if len(parts) < 3:
+                    continue
+                name = parts[0].rsplit(":", 1)[-1]
+                size = int(parts[1])
+                qualifier = parts[2]
+                if size >= frames.get(name, (0, ""))[0]:
+                    frames[name] = (size, qualifier)
+    return frames
+
+
+def read_ci(paths):
+    """caller -> set of callees, from -fcallgraph-info VCG files."""
+    calls = {}
+    edge = re.compile(r'edge:\s*\{\s*sourcename:\s*"([^"]+)"\s*targetname:\s*"([^"]+)"')
+    for path in find_files(paths, ".ci"):
+        with open(path) as handle:
+            for source, target in edge.findall(handle.read()):
+                # Titles are "file.c:func" for local functions.
+                source = source.rsplit(":", 1)[-1]
+                target = target.rsplit(":", 1)[-1]
+                calls.setdefault(source, set()).add(target)
+    return calls
+
+
+def read_objdump(elf, objdump):
+    """caller -> set of callees, from direct jal/call in the disassembly."""
+    calls = {}
+    current = None
+    header = re.compile(r"^[0-9a-f]+ <([^>]+)>:$")
+    direct = re.compile(r"\s(?:jal|call|tail|j)\s+(?:ra,\s*)?[0-9a-f]+ <([^>+]+)>")
+    indirect = re.compile(r"\sjalr\s")
+    output = subprocess.run([objdump, "-d", "--no-show-raw-insn", elf],
+                            check=True, capture_output=True, text=True).stdout
+    for line in output.splitlines():
+        match = header.match(line)
+        if match:
+            current = match.group(1)
+            calls.setdefault(current, set())
+            continue
+        if current is None:
+            continue
+        match = direct.search(line)
+        if match and match.group(1) != current:
+            calls[current].add(match.group(1))
+        elif indirect.search(line):
+            calls[current].add("__indirect_call")
+    return calls
+
+
+class Analysis:
+    def __init__(self, frames, calls):
+        self.frames = frames
+        self.calls = calls
+        self.memo = {}
+
+    def worst(self, name, stack=()):
+        """(bytes, path, flags) of the deepest call chain from name."""
+        if name in self.memo:
+            return self.memo[name]
+        if name in stack:
+            return 0, [name + " (recursion)"], {"recursion"}
+
+        size, qualifier = self.frames.get(name, (0, "unknown"))
+        flags = set()
+        if qualifier.startswith("dynamic"):
+            flags.add("dynamic")
+        if name == "__indirect_call":
+            return 0, ["(indirect call)"], {"indirect"}
+        if qualifier == "unknown" and name in self.calls:
+            flags.add("no .su")
+
+        best = (0, [], set())
+        for callee in sorted(self.calls.get(name, ())):
+            depth, path, callee_flags = self.worst(callee, stack + (name,))
+            flags |= callee_flags
+            if depth > best[0]:
+                best = (depth, path, callee_flags)
+
+        result = (size + best[0], ["%s (%d)" % (name, size)] + best[1], flags)
+        if not stack or "recursion" not in flags:
+            self.memo[name] = result
+        return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("paths", nargs="+", help=".su/.ci files or build directories")
+    parser.add_argument("--elf", help="read the call graph from this image")
+    parser.add_argument("--objdump", default="riscv64-unknown-elf-objdump")
+    parser.add_argument("--root", action="append", default=[],
+                        help="extra entry point (repeatable)")
+    parser.add_argument("--trap-frame", type=int, default=0,
+                        help="bytes the trap entry code pushes before a handler")
+    parser.add_argument("--stack-size", type=int,
+                        help="fail if the worst case does not fit in this")
+    args = parser.parse_args()
+
+    frames = read_su(args.paths)
+    if not frames:
+        sys.exit("no .su files found; build with -fstack-usage")
+    calls = read_objdump(args.elf, args.objdump) if args.elf else read_ci(args.paths)
+
+    known = set(frames) | set(calls)
+    threads = [name for name in THREAD_ROOTS + args.root if name in known]
+    isrs = sorted(name for name in known if ISR_PATTERN.match(name)
+                  and name not in threads)
+
+    analysis = Analysis(frames, calls)
+    worst_thread = worst_isr = 0
+
+    for title, roots in (("entry points", threads), ("interrupt handlers", isrs)):
+        print("%s:" % title)
+        for root in roots:
+            depth, path, flags = analysis.worst(root)
+            note = "  [%s]" % ", ".join(sorted(flags)) if flags else ""
+            print("  %-40s %6d%s" % (root, depth, note))
+            print("      " + " -> ".join(path))
+            if roots is threads:
+                worst_thread = max(worst_thread, depth)
+            else:
+                worst_isr = max(worst_isr, depth)
+        print()
+
+    total = worst_thread + worst_isr + (args.trap_frame if isrs else 0)
+    print("worst case: %d thread + %d handler + %d trap frame = %d bytes"
+          % (worst_thread, worst_isr, args.trap_frame if isrs else 0, total))
+
+    if args.stack_size is not None:
+        print("stack size: %d bytes, %s" % (args.stack_size,
+              "fits" if total <= args.stack_size else "TOO SMALL"))
+        if total > args.stack_size:
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * @file stack_watch.c
+ *
+ * @brief Stack painting, high-water marks and per-ISR stack usage.
+ *
+ * See "stack_watch.h" for details of how to use this module.
+ */
+
+#include "stack_watch.h"
+
+static inline uintptr_t current_sp(void)
+{
+    uintptr_t sp;
+
+    __asm volatile ("mv %0, sp" : "=r"(sp));
+    return sp;
+}
+
+/*------------------------------------------------------------------------------
+  Lowest address in [bottom, top) whose word is not the pattern, or top.
+ */
+static uintptr_t first_used(uintptr_t bottom, uintptr_t top)
+{
+    const volatile uint32_t * word = (const volatile uint32_t *)bottom;
+
+    while (((uintptr_t)word < top) && (STACK_WATCH_PATTERN == *word))
+    {
+        word++;
+    }
+
+    return (uintptr_t)word;
+}
+
+/***************************************************************************//**
+ * See "stack_watch.h" for details of how to use this function.
+ */
+void stack_watch_paint(uintptr_t bottom, uintptr_t top)
+{
+    volatile uint32_t * word = (volatile uint32_t *)bottom;
+    uintptr_t limit = current_sp() - STACK_WATCH_PAINT_MARGIN;
+
+    if (limit > top)
+    {
+        limit = top;
+    }
+
+    while ((uintptr_t)word < limit)
+    {
+        *word++ = STACK_WATCH_PATTERN;
+    }
+}
+
+/***************************************************************************//**
+ * See "stack_watch.h" for details of how to use this function.
+ */
+uint32_t stack_watch_high_water(uintptr_t bottom, uintptr_t top)
+{
+    return (uint32_t)(top - first_used(bottom, top));
+}
+
+/***************************************************************************//**
+ * See "stack_watch.h" for details of how to use this function.
+ */
+uint8_t stack_watch_overflowed(uintptr_t bottom)
+{
+    return (uint8_t)(first_used(bottom, bottom + STACK_WATCH_GUARD_BYTES) !=
+                     (bottom + STACK_WATCH_GUARD_BYTES));
+}
+
+/***************************************************************************//**
+ * See "stack_watch.h" for details of how to use this function.
+ */
+void stack_watch_isr_enter(stack_watch_isr_t * isr)
+{
+    uintptr_t sp = current_sp();
+    volatile uint32_t * word = (volatile uint32_t *)(sp - STACK_WATCH_ISR_WINDOW);
+
+    /* Paint right up to this function's own stack pointer: everything below
+       it is free, and the handler's callees will reuse it. */
+    isr->entry_sp = sp;
+    while ((uintptr_t)word < sp)
+    {
+        *word++ = STACK_WATCH_PATTERN;
+    }
+}
+
+/***************************************************************************//**
+ * See "stack_watch.h" for details of how to use this function.
+ */
+void stack_watch_isr_exit(stack_watch_isr_t * isr)
+{
+    uintptr_t window_bottom = isr->entry_sp - STACK_WATCH_ISR_WINDOW;
+    uintptr_t used_from = first_used(window_bottom, isr->entry_sp);
+    uint32_t used = (uint32_t)(isr->entry_sp - used_from);
+
+    /* The bottom word gone means the handler may have gone deeper still. */
+    if (used_from == window_bottom)
+    {
+        isr->window_full = 1u;
+    }
+    if (used > isr->max_used)
+    {
+        isr->max_used = used;
+    }
+    isr->calls++;
+}
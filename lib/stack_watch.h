@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * @file stack_watch.h
+ *
+ * @brief Stack painting, high-water marks and per-ISR stack usage.
+ *
+ * At boot each hart fills the unused part of its stack with a known pattern;
+ * later, the first word from the bottom that no longer holds the pattern
+ * marks the deepest the stack has ever been. Reading this is cheap enough to
+ * do from a console command at any time, and from another hart.
+ *
+ * The lowest STACK_WATCH_GUARD_BYTES of a stack are a guard: once they have
+ * been written the stack has overflowed, or is about to, and whatever lies
+ * below it may already be damaged. stack_watch_overflowed() checks it.
+ *
+ *     stack_watch_paint(bottom, top);                  (first thing in main)
+ *     used = stack_watch_high_water(bottom, top);      (any time later)
+ *
+ * Per-ISR usage: build with STACK_WATCH_ISR defined and bracket the handler
+ * body with STACK_WATCH_ISR_ENTER()/STACK_WATCH_ISR_EXIT(). On entry the
+ * STACK_WATCH_ISR_WINDOW bytes below the stack pointer are painted; on exit
+ * they are scanned to see how much of them the handler used. That costs a
+ * few hundred cycles per interrupt, so leave it out of release builds, where
+ * the macros compile to nothing.
+ *
+ * lib/stack_report.py gives the matching worst case from the compiler's
+ * -fstack-usage output at build time.
+ */
+
+#ifndef STACK_WATCH_H_
+#define STACK_WATCH_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STACK_WATCH_PATTERN         0xA5A5A5A5u
+
+/* Bytes at the bottom of each stack that must never be written. */
+#define STACK_WATCH_GUARD_BYTES     16u
+
+/* Bytes left unpainted below the caller of stack_watch_paint(). */
+#define STACK_WATCH_PAINT_MARGIN    64u
+
+#ifndef STACK_WATCH_ISR_WINDOW
+#define STACK_WATCH_ISR_WINDOW      512u
+#endif
+
+/*------------------------------------------------------------------------------
+  Stack usage of one interrupt handler.
+ */
+typedef struct stack_watch_isr
+{
+    const char * name;
+    uintptr_t entry_sp;
+    uint32_t calls;
+    uint32_t max_used;      /* bytes below the handler's entry stack pointer */
+    uint8_t window_full;    /* the handler used the whole window; raise it */
+} stack_watch_isr_t;
+
+/***************************************************************************//**
+ * stack_watch_paint() fills [bottom, top) with the pattern, stopping
+ * STACK_WATCH_PAINT_MARGIN bytes below the caller's stack pointer if that is
+ * inside the range. Call it on the hart that owns the stack, before that
+ * stack gets deep.
+ */
+void stack_watch_paint(uintptr_t bottom, uintptr_t top);
+
+/***************************************************************************//**
+ * stack_watch_high_water() returns the deepest use of the stack, in bytes
+ * down from top.
+ */
+uint32_t stack_watch_high_water(uintptr_t bottom, uintptr_t top);
+
+/***************************************************************************//**
+ * stack_watch_overflowed() returns 1 if the guard at the bottom of the stack
+ * has been written, or was never painted.
+ */
+uint8_t stack_watch_overflowed(uintptr_t bottom);
+
+/***************************************************************************//**
+ * stack_watch_isr_enter() / stack_watch_isr_exit(); use the macros below.
+ */
+void stack_watch_isr_enter(stack_watch_isr_t * isr);
+void stack_watch_isr_exit(stack_watch_isr_t * isr);
+
+#ifdef STACK_WATCH_ISR
+#define STACK_WATCH_ISR_ENTER(isr)  stack_watch_isr_enter(isr)
+#define STACK_WATCH_ISR_EXIT(isr)   stack_watch_isr_exit(isr)
+#else
+#define STACK_WATCH_ISR_ENTER(isr)  ((void)(isr))
+#define STACK_WATCH_ISR_EXIT(isr)   ((void)(isr))
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STACK_WATCH_H_ */
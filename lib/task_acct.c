@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * @file task_acct.c
+ *
+ * @brief Per-task CPU time accounting for event-driven main loops.
+ *
+ * See "task_acct.h" for details of how to use this module.
+ */
+
+#include "task_acct.h"
+#include "fmt.h"
+
+#define TASK_ACCT_NAME_WIDTH        12u
+
+/***************************************************************************//**
+ * See "task_acct.h" for details of how to use this function.
+ */
+void task_acct_init(task_acct_t * acct, uint8_t hartid,
+                    const char * const * names, uint8_t count, uint8_t first)
+{
+    uint32_t idx;
+
+    acct->names = names;
+    acct->count = (count > TASK_ACCT_MAX_TASKS) ? (uint8_t)TASK_ACCT_MAX_TASKS
+                                                : count;
+    acct->hartid = hartid;
+    acct->current = first;
+    acct->switches = 0u;
+    acct->window_cycles = 0u;
+    acct->window_switches = 0u;
+    for (idx = 0u; idx < TASK_ACCT_MAX_TASKS; idx++)
+    {
+        acct->cycles[idx] = 0u;
+        acct->window[idx] = 0u;
+    }
+    acct->switched = mcycle_read();
+}
+
+/***************************************************************************//**
+ * See "task_acct.h" for details of how to use this function.
+ */
+void task_acct_sample(task_acct_t * acct)
+{
+    uintptr_t mstatus;
+    uint64_t now;
+    uint64_t total = 0u;
+    uint32_t idx;
+
+    __asm volatile ("csrrci %0, mstatus, 8" : "=r"(mstatus) : : "memory");
+    now = mcycle_read();
+    acct->cycles[acct->current] += now - acct->switched;
+    acct->switched = now;
+
+    for (idx = 0u; idx < acct->count; idx++)
+    {
+        acct->window[idx] = acct->cycles[idx];
+        total += acct->cycles[idx];
+        acct->cycles[idx] = 0u;
+    }
+    acct->window_cycles = total;
+    acct->window_switches = acct->switches;
+    acct->switches = 0u;
+    __asm volatile ("csrs mstatus, %0" : : "r"(mstatus & 8u) : "memory");
+}
+
+/***************************************************************************//**
+ * See "task_acct.h" for details of how to use this function.
+ */
+void task_acct_report(task_acct_t * const * accts, uint32_t count,
+                      task_acct_out_t out)
+{
+    char line[80];
+    char * p;
+    const task_acct_t * acct;
+    uint64_t total;
+    uint32_t permille;
+    uint32_t len;
+    uint32_t hart;
+    uint32_t task;
+
+    for (hart = 0u; hart < count; hart++)
+    {
+        acct = accts[hart];
+        total = acct->window_cycles;
+
+        p = line;
+        p = fmt_str(p, " hart ");
+        p = fmt_u32(p, acct->hartid, 0u, ' ');
+        p = fmt_str(p, ": ");
+        p = fmt_u64(p, total, 0u, ' ');
+        p = fmt_str(p, " cycles, ");
+        p = fmt_u32(p, acct->window_switches, 0u, ' ');
+        p = fmt_str(p, " switches\r\n");
+        *p = '\0';
+        out(line);
+
+        for (task = 0u; task < acct->count; task++)
+        {
+            permille = (0u != total)
+                     ? (uint32_t)((acct->window[task] * 1000u) / total) : 0u;
+
+            p = line;
+            p = fmt_str(p, "   ");
+            p = fmt_str(p, acct->names[task]);
+            for (len = 0u; ('\0' != acct->names[task][len]) &&
+                           (len < TASK_ACCT_NAME_WIDTH); len++)
+            {
+                ;
+            }
+            for (; len < TASK_ACCT_NAME_WIDTH; len++)
+            {
+                p = fmt_char(p, ' ');
+            }
+            p = fmt_u32(p, permille / 10u, 3u, ' ');
+            p = fmt_char(p, '.');
+            p = fmt_u32(p, permille % 10u, 1u, '0');
+            p = fmt_str(p, "%  ");
+            p = fmt_u64(p, acct->window[task], 12u, ' ');
+            p = fmt_str(p, "\r\n");
+            *p = '\0';
+            out(line);
+        }
+    }
+}
@@ -0,0 +1,128 @@
+/*******************************************************************************
+ * @file task_acct.h
+ *
+ * @brief Per-task CPU time accounting for event-driven main loops.
+ *
+ * Each hart has a task_acct_t and a list of task names; one of the tasks is
+ * always current. task_acct_switch() charges the mcycle time since the last
+ * switch to the current task and makes another one current, so every cycle
+ * of the hart ends up charged to exactly one task:
+ *
+ *     for (;;)
+ *     {
+ *         (void)task_acct_switch(&g_tasks, TASK_IDLE);
+ *         if (rtc_count_updated)
+ *         {
+ *             (void)task_acct_switch(&g_tasks, TASK_RTC);
+ *             ...
+ *         }
+ *     }
+ *
+ * Work done on behalf of another task, or by an interrupt handler, switches
+ * and then switches back to what it returned:
+ *
+ *     prev = task_acct_switch(&g_tasks, TASK_IRQ);
+ *     ...
+ *     (void)task_acct_switch(&g_tasks, prev);
+ *
+ * A switch to the task that is already current returns after one compare,
+ * so the idle switch at the top of a polling loop costs almost nothing while
+ * the loop has nothing to do. A real switch is an mcycle read and a few
+ * stores with the hart's interrupts masked, which is what lets a handler
+ * switch in the middle of one made by thread code.
+ *
+ * task_acct_sample() closes the accounting window, e.g. once a second, and
+ * task_acct_report() prints each task's share of the last closed window.
+ * The report's own cost is charged to whichever task prints it, so it shows
+ * up in the figures it produces.
+ *
+ * A task_acct_t belongs to one hart; only that hart may switch or sample
+ * it. Any hart may print the report.
+ */
+
+#ifndef TASK_ACCT_H_
+#define TASK_ACCT_H_
+
+#include <stdint.h>
+#include "mcycle.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TASK_ACCT_MAX_TASKS         8u
+
+typedef struct task_acct
+{
+    const char * const * names;
+    uint8_t count;
+    uint8_t hartid;
+    volatile uint8_t current;
+    uint64_t switched;                          /* mcycle of the last switch */
+    uint32_t switches;
+    uint64_t cycles[TASK_ACCT_MAX_TASKS];       /* open window */
+    uint64_t window[TASK_ACCT_MAX_TASKS];       /* last closed window */
+    uint64_t window_cycles;
+    uint32_t window_switches;
+} task_acct_t;
+
+/*------------------------------------------------------------------------------
+  Called once per report line, e.g. console_tx().
+ */
+typedef void (*task_acct_out_t)(const char * line);
+
+/***************************************************************************//**
+ * task_acct_init() clears the counts and makes task first current. names
+ * must hold count (up to TASK_ACCT_MAX_TASKS) names and outlive acct.
+ */
+void task_acct_init(task_acct_t * acct, uint8_t hartid,
+                    const char * const * names, uint8_t count, uint8_t first);
+
+/***************************************************************************//**
+ * task_acct_switch() charges the time since the last switch to the current
+ * task and makes task current.
+ * @return  the task that was current.
+ */
+static inline uint8_t task_acct_switch(task_acct_t * acct, uint8_t task)
+{
+    uintptr_t mstatus;
+    uint64_t now;
+    uint8_t prev = acct->current;
+
+    if (prev == task)
+    {
+        return prev;
+    }
+
+    __asm volatile ("csrrci %0, mstatus, 8" : "=r"(mstatus) : : "memory");
+    /* An interrupt may have switched between the read above and the mask. */
+    prev = acct->current;
+    now = mcycle_read();
+    acct->cycles[prev] += now - acct->switched;
+    acct->switched = now;
+    acct->current = task;
+    acct->switches++;
+    __asm volatile ("csrs mstatus, %0" : : "r"(mstatus & 8u) : "memory");
+
+    return prev;
+}
+
+/***************************************************************************//**
+ * task_acct_sample() charges the current task up to now and closes the
+ * window: its counts become the ones task_acct_report() prints and a new
+ * window starts.
+ */
+void task_acct_sample(task_acct_t * acct);
+
+/***************************************************************************//**
+ * task_acct_report() prints, for each hart, the cycles and switches in its
+ * last closed window and each task's share of them.
+ */
+void task_acct_report(task_acct_t * const * accts, uint32_t count,
+                      task_acct_out_t out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TASK_ACCT_H_ */
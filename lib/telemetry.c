@@ -0,0 +1,186 @@
+/*******************************************************************************
+ * @file telemetry.c
+ *
+ * @brief Compact binary telemetry records over a byte stream.
+ *
+ * See "telemetry.h" for details of how to use this module.
+ */
+
+#include "telemetry.h"
+
+#define TLM_CRC_INIT        0xFFFFu
+
+/* Space left at the end of raw[] for the CRC. */
+#define TLM_CRC_BYTES       2u
+
+/*------------------------------------------------------------------------------
+  CRC-16/CCITT-FALSE (poly 0x1021), four bits at a time from a 16 entry table.
+ */
+static const uint16_t g_crc_nibble[16] =
+{
+    0x0000u, 0x1021u, 0x2042u, 0x3063u, 0x4084u, 0x50A5u, 0x60C6u, 0x70E7u,
+    0x8108u, 0x9129u, 0xA14Au, 0xB16Bu, 0xC18Cu, 0xD1ADu, 0xE1CEu, 0xF1EFu,
+};
+
+static uint16_t crc16(const uint8_t * data, uint32_t len)
+{
+    uint16_t crc = TLM_CRC_INIT;
+    uint32_t idx;
+
+    for (idx = 0u; idx < len; idx++)
+    {
+        crc = (uint16_t)((crc << 4) ^ g_crc_nibble[(crc >> 12) ^ (data[idx] >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ g_crc_nibble[(crc >> 12) ^ (data[idx] & 0x0Fu)]);
+    }
+
+    return crc;
+}
+
+/*------------------------------------------------------------------------------
+  Append one byte, keeping room for the CRC.
+ */
+static inline void put_byte(telemetry_t * tlm, uint8_t value)
+{
+    if (tlm->len < (TLM_MAX_RECORD - TLM_CRC_BYTES))
+    {
+        tlm->raw[tlm->len++] = value;
+    }
+    else
+    {
+        tlm->overflow = 1u;
+    }
+}
+
+/*------------------------------------------------------------------------------
+  COBS encode src into dst, which must hold len + len / 254 + 1 bytes.
+  Returns the encoded length.
+ */
+static uint32_t cobs_encode(const uint8_t * src, uint32_t len, uint8_t * dst)
+{
+    uint32_t code_idx = 0u;
+    uint32_t out = 1u;
+    uint8_t code = 1u;
+    uint32_t idx;
+
+    for (idx = 0u; idx < len; idx++)
+    {
+        if (0u == src[idx])
+        {
+            dst[code_idx] = code;
+            code_idx = out++;
+            code = 1u;
+        }
+        else
+        {
+            dst[out++] = src[idx];
+            code++;
+            if (0xFFu == code)
+            {
+                dst[code_idx] = code;
+                code_idx = out++;
+                code = 1u;
+            }
+        }
+    }
+    dst[code_idx] = code;
+
+    return out;
+}
+
+/***************************************************************************//**
+ * See "telemetry.h" for details of how to use this function.
+ */
+void telemetry_init(telemetry_t * tlm, uint8_t source, telemetry_write_t write)
+{
+    tlm->write = write;
+    tlm->source = source;
+    tlm->seq = 0u;
+    tlm->len = 0u;
+    tlm->overflow = 0u;
+    tlm->frames = 0u;
+    tlm->bytes = 0u;
+    tlm->dropped = 0u;
+}
+
+/***************************************************************************//**
+ * See "telemetry.h" for details of how to use this function.
+ */
+void telemetry_begin(telemetry_t * tlm, uint8_t type)
+{
+    tlm->len = 0u;
+    tlm->overflow = 0u;
+    put_byte(tlm, type);
+    put_byte(tlm, tlm->source);
+    put_byte(tlm, tlm->seq);
+}
+
+/***************************************************************************//**
+ * See "telemetry.h" for details of how to use this function.
+ */
+void telemetry_put_u32(telemetry_t * tlm, uint32_t value)
+{
+    while (value >= 0x80u)
+    {
+        put_byte(tlm, (uint8_t)(value | 0x80u));
+        value >>= 7;
+    }
+    put_byte(tlm, (uint8_t)value);
+}
+
+/***************************************************************************//**
+ * See "telemetry.h" for details of how to use this function.
+ */
+void telemetry_put_u64(telemetry_t * tlm, uint64_t value)
+{
+    /* Most fields are small; only loop in 64-bit arithmetic when needed. */
+    while (value > 0xFFFFFFFFu)
+    {
+        put_byte(tlm, (uint8_t)(value | 0x80u));
+        value >>= 7;
+    }
+    telemetry_put_u32(tlm, (uint32_t)value);
+}
+
+/***************************************************************************//**
+ * See "telemetry.h" for details of how to use this function.
+ */
+void telemetry_put_i32(telemetry_t * tlm, int32_t value)
+{
+    /* Zigzag: 0, -1, 1, -2 ... map to 0, 1, 2, 3 ... so small magnitudes stay
+       short whatever their sign. */
+    telemetry_put_u32(tlm, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+/***************************************************************************//**
+ * See "telemetry.h" for details of how to use this function.
+ */
+uint8_t telemetry_end(telemetry_t * tlm)
+{
+    uint8_t frame[TLM_MAX_FRAME];
+    uint32_t frame_len;
+    uint16_t crc;
+
+    if (tlm->overflow)
+    {
+        tlm->dropped++;
+        tlm->len = 0u;
+        return 0u;
+    }
+
+    crc = crc16(tlm->raw, tlm->len);
+    tlm->raw[tlm->len++] = (uint8_t)(crc >> 8);
+    tlm->raw[tlm->len++] = (uint8_t)crc;
+
+    frame[0] = 0u;
+    frame_len = 1u + cobs_encode(tlm->raw, tlm->len, &frame[1]);
+    frame[frame_len++] = 0u;
+
+    tlm->write(frame, frame_len);
+
+    tlm->seq++;
+    tlm->frames++;
+    tlm->bytes += frame_len;
+    tlm->len = 0u;
+
+    return 1u;
+}
@@ -0,0 +1,107 @@
+/*******************************************************************************
+ * @file telemetry.h
+ *
+ * @brief Compact binary telemetry records over a byte stream.
+ *
+ * A record is a type byte, the source instance, a sequence number and a list
+ * of fields, each field a LEB128 varint (signed fields zigzag encoded first),
+ * followed by a CRC-16/CCITT-FALSE of everything before it:
+ *
+ *     type | source | seq | field0 | field1 | ... | crc_hi | crc_lo
+ *
+ * Every telemetry_t instance has its own source number, e.g. the hart id, and
+ * counts its records, so the host can tell which records were lost even when
+ * several harts share the UART.
+ *
+ * The record is COBS encoded, so it contains no 0x00 bytes, and sent between
+ * two 0x00 delimiters. The leading delimiter ends any console text that was
+ * sent before it, so records and ordinary ASCII output can share one UART:
+ * the host decoder (telemetry_decode.py) passes chunks that fail to decode
+ * through as text and prints the rest as records. A status line such as
+ * "Hart 1, mcycle_delta=... SW_IRQs=... mcycle=..." shrinks from ~70 bytes to
+ * ~20.
+ *
+ * Record types and their fields are listed in telemetry_records.h; keep the
+ * table in telemetry_decode.py in step with it.
+ *
+ *     telemetry_begin(&tlm, TLM_HART_STATUS);
+ *     telemetry_put_u64(&tlm, hartid);
+ *     telemetry_put_u64(&tlm, delta);
+ *     telemetry_end(&tlm);
+ *
+ * A telemetry_t instance is not reentrant; give an interrupt handler that
+ * sends records an instance of its own.
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest record before framing: type, seq, fields and CRC. */
+#define TLM_MAX_RECORD          64u
+
+/* COBS adds one byte per 254 plus one; two delimiters are added around it. */
+#define TLM_MAX_FRAME           (TLM_MAX_RECORD + (TLM_MAX_RECORD / 254u) + 3u)
+
+/*------------------------------------------------------------------------------
+  Byte sink, e.g. a wrapper around MSS_UART_polled_tx(). Frames contain 0x00,
+  so this cannot be a NUL terminated string function.
+ */
+typedef void (*telemetry_write_t)(const uint8_t * buf, size_t len);
+
+typedef struct telemetry
+{
+    telemetry_write_t write;
+    uint8_t source;
+    uint8_t seq;
+
+    /* Record being built. */
+    uint32_t len;
+    uint8_t overflow;
+    uint8_t raw[TLM_MAX_RECORD];
+
+    /* Totals, for working out the link budget. */
+    uint32_t frames;
+    uint32_t bytes;
+    uint32_t dropped;
+} telemetry_t;
+
+/***************************************************************************//**
+ * telemetry_init() sets up an instance that sends its frames through write.
+ * source must be unique among the instances sharing one link.
+ */
+void telemetry_init(telemetry_t * tlm, uint8_t source, telemetry_write_t write);
+
+/***************************************************************************//**
+ * telemetry_begin() starts a record of the given type, discarding any record
+ * that was begun but not ended.
+ */
+void telemetry_begin(telemetry_t * tlm, uint8_t type);
+
+/***************************************************************************//**
+ * telemetry_put_u32() / telemetry_put_u64() append an unsigned field.
+ * telemetry_put_i32() appends a signed field.
+ */
+void telemetry_put_u32(telemetry_t * tlm, uint32_t value);
+void telemetry_put_u64(telemetry_t * tlm, uint64_t value);
+void telemetry_put_i32(telemetry_t * tlm, int32_t value);
+
+/***************************************************************************//**
+ * telemetry_end() adds the CRC, frames the record and writes it.
+ *
+ * @return  1 if the record was sent, 0 if it was dropped because its fields
+ *          did not fit in TLM_MAX_RECORD.
+ */
+uint8_t telemetry_end(telemetry_t * tlm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TELEMETRY_H_ */
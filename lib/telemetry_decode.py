@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+"""Decode telemetry frames (see telemetry.h) from a serial port or a capture.
+
+Frames are COBS encoded records between 0x00 delimiters. Anything between
+delimiters that does not decode with a good CRC is console text and is passed
+through unchanged, so the normal terminal output stays readable.
+
+    telemetry_decode.py /dev/ttyUSB1            # print records and text
+    telemetry_decode.py capture.bin --csv out/  # one CSV file per record type
+    telemetry_decode.py /dev/ttyUSB1 --json     # one JSON object per line
+
+Reading a serial port needs pyserial.
+"""
+
+import argparse
+import csv
+import json
+import os
+import sys
+
+# Keep in step with telemetry_records.h: type -> (name, [(field, kind)]).
+# A kind ending in "*" takes every remaining value, as a list.
+RECORDS = {
+    0x01: ("hart_status", [("hartid", "u"), ("mcycle_delta", "u"),
+                           ("sw_irqs", "u"), ("mcycle", "u")]),
+    0x02: ("systick", [("tick", "u"), ("leds", "u"), ("count", "u")]),
+    0x03: ("profile", [("hartid", "u"), ("dropped", "u"), ("pc", "u"),
+                       ("deltas", "i*")]),
+    0x04: ("event", [("hart", "u"), ("id", "u"), ("arg", "u"), ("ts", "u")]),
+    0x05: ("irq_stats", [("hart", "u"), ("irq", "u"), ("count", "u"),
+                         ("total_cycles", "u"), ("max_cycles", "u"), ("last", "u")]),
+    0x06: ("deadline", [("task", "u"), ("runs", "u"), ("misses", "u"), ("skipped", "u"),
+                        ("max_jitter", "u"), ("max_response", "u"), ("hist", "u*")]),
+    0x07: ("event_sync", [("hart", "u"), ("mcycle", "u"), ("mtime", "u")]),
+    0x08: ("stack", [("hart", "u"), ("used", "u"), ("size", "u"), ("overflowed", "u")]),
+}
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, as computed by telemetry.c."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    idx = 0
+    while idx < len(data):
+        code = data[idx]
+        if code == 0 or idx + code > len(data):
+            return None
+        out += data[idx + 1:idx + code]
+        idx += code
+        if code != 0xFF and idx < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data):
+            raise ValueError("truncated varint")
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def decode_record(chunk):
+    """Return (type, source, seq, fields dict or raw list), or None if the
+    chunk is not a record."""
+    raw = cobs_decode(chunk)
+    if raw is None or len(raw) < 5:
+        return None
+    body, crc = raw[:-2], (raw[-2] << 8) | raw[-1]
+    if crc16(body) != crc:
+        return None
+
+    rtype, source, seq = body[0], body[1], body[2]
+    values = []
+    pos = 3
+    try:
+        while pos < len(body):
+            value, pos = read_varint(body, pos)
+            values.append(value)
+    except ValueError:
+        return None
+
+    if rtype not in RECORDS:
+        return rtype, source, seq, values
+
+    name, fields = RECORDS[rtype]
+    if fields[-1][1].endswith("*"):
+        if len(values) < len(fields) - 1:
+            return None
+    elif len(values) != len(fields):
+        return None
+    decoded = {}
+    for idx, (field, kind) in enumerate(fields):
+        if kind.endswith("*"):
+            decoded[field] = [zigzag(value) if kind[0] == "i" else value
+                              for value in values[idx:]]
+        else:
+            decoded[field] = zigzag(values[idx]) if kind == "i" else values[idx]
+    return rtype, source, seq, decoded
+
+
+def zigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+# Bytes console text is made of. The byte after a frame's COBS code byte is
+# its record type, which is never one of these.
+TEXT_BYTES = frozenset(b"\b\t\n\r" + bytes(range(0x20, 0x7F)))
+
+
+class Decoder:
+    def __init__(self, on_record, on_text):
+        self.on_record = on_record
+        self.on_text = on_text
+        self.pending = bytearray()
+        self.last_seq = {}
+        self.lost = 0
+        self.records = 0
+        self.record_bytes = 0
+
+    def feed(self, data):
+        for byte in data:
+            if byte != 0:
+                self.pending.append(byte)
+                # A whole line of text is passed on without waiting for the
+                # next delimiter. A single byte could be a frame's COBS code
+                # byte, so that waits for flush().
+                if byte == 0x0A and len(self.pending) > 1 and \
+                        all(b in TEXT_BYTES for b in self.pending):
+                    self.on_text(bytes(self.pending))
+                    self.pending.clear()
+                continue
+            chunk = bytes(self.pending)
+            self.pending.clear()
+            if not chunk:
+                continue
+            record = decode_record(chunk)
+            if record is None:
+                self.on_text(chunk)
+                continue
+
+            source, seq = record[1], record[2]
+            if source in self.last_seq:
+                self.lost += (seq - self.last_seq[source] - 1) & 0xFF
+            self.last_seq[source] = seq
+            self.records += 1
+            self.record_bytes += len(chunk) + 2
+            self.on_record(*record)
+
+    def flush(self):
+        """Pass on what is left after a quiet spell or at the end of the
+        input. Frames are sent in one piece with their closing delimiter, so
+        it is console text."""
+        if self.pending:
+            self.on_text(bytes(self.pending))
+            self.pending.clear()
+
+
+def record_name(rtype):
+    return RECORDS[rtype][0] if rtype in RECORDS else "type_0x%02x" % rtype
+
+
+def open_input(path, baud):
+    if os.path.exists(path) and not path.startswith("/dev/"):
+        return open(path, "rb")
+    import serial  # pyserial
+    return serial.Serial(path, baud, timeout=0.1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="serial port or capture file, - for stdin")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--json", action="store_true",
+                        help="print records as JSON lines")
+    parser.add_argument("--csv", metavar="DIR",
+                        help="write one CSV file per record type into DIR")
+    parser.add_argument("--quiet-text", action="store_true",
+                        help="do not pass console text through")
+    args = parser.parse_args()
+
+    writers = {}
+
+    def on_record(rtype, source, seq, fields):
+        name = record_name(rtype)
+        if args.csv:
+            if name not in writers:
+                handle = open(os.path.join(args.csv, name + ".csv"), "w", newline="")
+                columns = ["source", "seq"] + (list(fields) if isinstance(fields, dict) else [])
+                writer = csv.writer(handle)
+                writer.writerow(columns)
+                writers[name] = (handle, writer)
+            row = [source, seq] + (list(fields.values()) if isinstance(fields, dict) else fields)
+            writers[name][1].writerow(row)
+        elif args.json:
+            print(json.dumps({"type": name, "source": source, "seq": seq,
+                              "fields": fields}), flush=True)
+        else:
+            if isinstance(fields, dict):
+                text = " ".join("%s=%s" % item for item in fields.items())
+            else:
+                text = " ".join(str(value) for value in fields)
+            print("[%s %d#%d] %s" % (name, source, seq, text), flush=True)
+
+    def on_text(chunk):
+        if not args.quiet_text and not args.json:
+            sys.stdout.write(chunk.decode("ascii", "replace"))
+            sys.stdout.flush()
+
+    if args.csv:
+        os.makedirs(args.csv, exist_ok=True)
+
+    decoder = Decoder(on_record, on_text)
+    source = sys.stdin.buffer if args.input == "-" else open_input(args.input, args.baud)
+    try:
+        while True:
+            data = source.read(256)
+            if not data:
+                decoder.flush()
+                if hasattr(source, "in_waiting"):
+                    continue
+                break
+            decoder.feed(data)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        decoder.flush()
+        for handle, _ in writers.values():
+            handle.close()
+
+    sys.stderr.write("%d records, %d bytes, %d lost\n"
+                     % (decoder.records, decoder.record_bytes, decoder.lost))
+
+
+if __name__ == "__main__":
+    main()
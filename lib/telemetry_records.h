@@ -0,0 +1,67 @@
+/*******************************************************************************
+ * @file telemetry_records.h
+ *
+ * @brief Telemetry record types and their fields, in the order they are put.
+ *
+ * u = unsigned varint, i = signed (zigzag) varint; a trailing "..." field
+ * repeats to the end of the record. The host decoder,
+ * telemetry_decode.py, has the same table; add new types to both and never
+ * reuse a number.
+ */
+
+#ifndef TELEMETRY_RECORDS_H_
+#define TELEMETRY_RECORDS_H_
+
+/*------------------------------------------------------------------------------
+  Per-hart status, once per benchmark loop.
+    u hartid, u mcycle_delta, u sw_irqs, u mcycle
+ */
+#define TLM_HART_STATUS         0x01u
+
+/*------------------------------------------------------------------------------
+  Mi-V system timer tick.
+    u tick, u leds, u count
+ */
+#define TLM_SYSTICK             0x02u
+
+/*------------------------------------------------------------------------------
+  Profiler samples (sample_prof.h); each delta is a PC minus the one before.
+    u hartid, u dropped, u pc, i delta...
+ */
+#define TLM_PROFILE             0x03u
+
+/*------------------------------------------------------------------------------
+  Event trace record (evtrace.h); ts is mcycle on that hart.
+    u hart, u id, u arg, u ts
+ */
+#define TLM_EVENT               0x04u
+
+/*------------------------------------------------------------------------------
+  Interrupt statistics (irq_stats.h), one record per source.
+    u hart, u irq, u count, u total_cycles, u max_cycles, u last
+ */
+#define TLM_IRQ_STATS           0x05u
+
+/*------------------------------------------------------------------------------
+  Periodic task deadlines (deadline.h), one record per task; hist holds the
+  DEADLINE_BUCKETS response histogram counts.
+    u task, u runs, u misses, u skipped, u max_jitter, u max_response, u hist...
+ */
+#define TLM_DEADLINE            0x06u
+
+/*------------------------------------------------------------------------------
+  Event trace time base (evtrace.h), one record per hart ahead of its
+  TLM_EVENT records: the hart's mcycle at a CLINT MTIME; both 0 if the hart
+  never called evtrace_sync().
+    u hart, u mcycle, u mtime
+ */
+#define TLM_EVENT_SYNC          0x07u
+
+/*------------------------------------------------------------------------------
+  Stack high-water mark (stack_watch.h), in bytes used of size; overflowed
+  is 1 once the guard at the bottom has been written.
+    u hart, u used, u size, u overflowed
+ */
+#define TLM_STACK               0x08u
+
+#endif /* TELEMETRY_RECORDS_H_ */
@@ -0,0 +1,144 @@
+/*******************************************************************************
+ * @file deadline_test.c
+ *
+ * @brief Host test of deadline.c against a simulated HAL SysTick timer.
+ *
+ * The timer is modelled the way the HAL drives it: the interrupt is taken
+ * when mcycle reaches MTIMECMP, and MTIMECMP is reloaded a period from the
+ * time the handler returns. Run with run_tests.sh.
+ *
+ * Links: fmt.c telemetry.c
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Stand in for mcycle.h: deadline.c reads this simulated clock instead. */
+#define MCYCLE_H_
+static uint64_t g_now;
+
+static inline uint64_t mcycle_read(void)
+{
+    return g_now;
+}
+
+#include "../deadline.c"
+
+#define TEST_PERIOD                 1000u
+#define TEST_DEADLINE               800u
+#define TEST_ENTRY                  5u      /* trap entry to deadline_begin() */
+
+static uint32_t g_failures = 0u;
+
+static void check(int ok, const char * what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+/*------------------------------------------------------------------------------
+  Run the handler ticks times from now. Each run spends runtime cycles
+  inside the deadline window and tail cycles after it, then the HAL reloads
+  the timer. A non-zero masked delays the interrupt of one tick by that many
+  cycles.
+ */
+static void run_ticks(deadline_t * dl, uint32_t ticks, uint32_t runtime,
+                      uint32_t tail, uint32_t masked_tick, uint32_t masked)
+{
+    uint64_t mtimecmp = g_now + TEST_PERIOD;
+    uint32_t tick;
+
+    for (tick = 0u; tick < ticks; tick++)
+    {
+        g_now = mtimecmp + TEST_ENTRY;
+        if ((0u != masked) && (tick == masked_tick))
+        {
+            g_now += masked;
+        }
+
+        deadline_begin(dl);
+        g_now += runtime;
+        deadline_end(dl);
+        if (0u != tail)
+        {
+            g_now += tail;
+            deadline_reload(dl);
+        }
+
+        mtimecmp = g_now + TEST_PERIOD;
+    }
+}
+
+/*------------------------------------------------------------------------------
+  A handler that runs for 60% of its period is still released on time: its
+  jitter is only the trap entry and it never misses.
+ */
+static void test_long_handler(void)
+{
+    deadline_t dl = DEADLINE_INIT("long", 0u, TEST_PERIOD, TEST_DEADLINE);
+
+    g_now = 1u;
+    run_ticks(&dl, 100u, 600u, 0u, 0u, 0u);
+
+    check(100u == dl.runs, "long handler: every tick runs");
+    check(0u == dl.misses, "long handler: no misses");
+    check(0u == dl.skipped, "long handler: no skipped ticks");
+    check(TEST_ENTRY == dl.max_jitter, "long handler: jitter is the trap entry");
+    check((TEST_ENTRY + 600u) == dl.max_response,
+          "long handler: response is entry plus runtime");
+}
+
+/*------------------------------------------------------------------------------
+  Work after deadline_end() moves the reload point when deadline_reload()
+  marks it, so it does not show up as jitter on the next run either.
+ */
+static void test_work_after_end(void)
+{
+    deadline_t dl = DEADLINE_INIT("tail", 0u, TEST_PERIOD, TEST_DEADLINE);
+
+    g_now = 1u;
+    run_ticks(&dl, 100u, 300u, 500u, 0u, 0u);
+
+    check(0u == dl.misses, "tail: no misses");
+    check(TEST_ENTRY == dl.max_jitter, "tail: jitter is the trap entry");
+    check((TEST_ENTRY + 300u) == dl.max_response,
+          "tail: response excludes the work after deadline_end()");
+}
+
+/*------------------------------------------------------------------------------
+  An interrupt held off for two and a half periods counts two skipped ticks
+  and a miss, and the schedule recovers from the late run's reload.
+ */
+static void test_masked(void)
+{
+    deadline_t dl = DEADLINE_INIT("masked", 0u, TEST_PERIOD, TEST_DEADLINE);
+
+    g_now = 1u;
+    run_ticks(&dl, 20u, 600u, 0u, 10u, (5u * TEST_PERIOD) / 2u);
+
+    check(20u == dl.runs, "masked: every interrupt taken runs");
+    check(2u == dl.skipped, "masked: two ticks skipped");
+    check(1u == dl.misses, "masked: the late run misses");
+    check((TEST_ENTRY + (TEST_PERIOD / 2u)) == dl.max_jitter,
+          "masked: jitter is the part period late");
+}
+
+int main(void)
+{
+    test_long_handler();
+    test_work_after_end();
+    test_masked();
+
+    if (0u != g_failures)
+    {
+        printf("deadline_test: %u failed\n", (unsigned)g_failures);
+        return EXIT_FAILURE;
+    }
+
+    printf("deadline_test: passed\n");
+    return EXIT_SUCCESS;
+}
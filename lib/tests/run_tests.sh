@@ -0,0 +1,33 @@
+#!/bin/sh
+#
+# Builds and runs the host tests of the lib/ modules: every *_test.c here is
+# compiled with the host compiler against the modules it includes or names
+# in its "Links:" line, and run.
+#
+#     ./run_tests.sh            # CC defaults to cc
+
+set -e
+
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:-"-std=c99 -O2 -Wall -Wextra -Werror"}
+HERE=$(cd "$(dirname "$0")" && pwd)
+LIB=$(dirname "$HERE")
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+
+status=0
+for test in "$HERE"/*_test.c; do
+    name=$(basename "$test" .c)
+    links=$(sed -n 's/^ \* Links: *//p' "$test")
+    srcs=""
+    for module in $links; do
+        srcs="$srcs $LIB/$module"
+    done
+    # shellcheck disable=SC2086
+    $CC $CFLAGS -I"$LIB" -o "$OUT/$name" "$test" $srcs
+    if ! "$OUT/$name"; then
+        status=1
+    fi
+done
+
+exit $status
@@ -0,0 +1,134 @@
+/*******************************************************************************
+ * @file sample_prof_test.c
+ *
+ * @brief Host test of how full sample_prof.c's TLM_PROFILE records are.
+ *
+ * Samples are put in the ring directly, as sample_prof_sample() would from
+ * the timer interrupt, and the records sent are counted at the telemetry
+ * link. Run with run_tests.sh.
+ *
+ * Links: sample_prof.c telemetry.c
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "sample_prof.h"
+
+static uint32_t g_failures = 0u;
+static uint32_t g_frames = 0u;
+
+static void check(int ok, const char * what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        g_failures++;
+    }
+}
+
+static void count_frame(const uint8_t * buf, size_t len)
+{
+    (void)buf;
+    (void)len;
+    g_frames++;
+}
+
+static void add_samples(sample_prof_t * prof, uint32_t count)
+{
+    while (count-- > 0u)
+    {
+        prof->pc[prof->head & (SAMPLE_PROF_RING_SIZE - 1u)] =
+            0x80000000u + (prof->head * 4u);
+        prof->head++;
+    }
+}
+
+/*------------------------------------------------------------------------------
+  A part record stays in the ring until enough samples arrive to fill it.
+ */
+static void test_drain_waits_for_full_record(void)
+{
+    sample_prof_t prof;
+    telemetry_t tlm;
+
+    sample_prof_init(&prof, 1u);
+    telemetry_init(&tlm, 1u, count_frame);
+    g_frames = 0u;
+
+    add_samples(&prof, SAMPLE_PROF_PER_RECORD - 1u);
+    check(0u == sample_prof_drain(&prof, &tlm, 1u), "part record: nothing sent");
+    check(0u == g_frames, "part record: no frame");
+    check((SAMPLE_PROF_PER_RECORD - 1u) == sample_prof_pending(&prof),
+          "part record: samples kept");
+
+    add_samples(&prof, 1u);
+    check(SAMPLE_PROF_PER_RECORD == sample_prof_drain(&prof, &tlm, 1u),
+          "full record: sent");
+    check(1u == g_frames, "full record: one frame");
+    check(0u == sample_prof_pending(&prof), "full record: ring empty");
+}
+
+/*------------------------------------------------------------------------------
+  Every drained record is full, with the leftovers held back.
+ */
+static void test_drain_sends_only_full_records(void)
+{
+    sample_prof_t prof;
+    telemetry_t tlm;
+    uint32_t sent;
+
+    sample_prof_init(&prof, 1u);
+    telemetry_init(&tlm, 1u, count_frame);
+    g_frames = 0u;
+
+    add_samples(&prof, (3u * SAMPLE_PROF_PER_RECORD) + 3u);
+    sent = sample_prof_drain(&prof, &tlm, 10u);
+
+    check((3u * SAMPLE_PROF_PER_RECORD) == sent, "drain: three full records");
+    check(3u == g_frames, "drain: three frames");
+    check((sent / g_frames) == SAMPLE_PROF_PER_RECORD, "drain: records full");
+    check(3u == sample_prof_pending(&prof), "drain: leftovers kept");
+    check(0u == tlm.dropped, "drain: records fit TLM_MAX_RECORD");
+}
+
+/*------------------------------------------------------------------------------
+  A flush sends everything, the last record short.
+ */
+static void test_flush_sends_the_rest(void)
+{
+    sample_prof_t prof;
+    telemetry_t tlm;
+
+    sample_prof_init(&prof, 1u);
+    telemetry_init(&tlm, 1u, count_frame);
+    g_frames = 0u;
+
+    add_samples(&prof, SAMPLE_PROF_PER_RECORD + 3u);
+    check((SAMPLE_PROF_PER_RECORD + 3u) == sample_prof_flush(&prof, &tlm),
+          "flush: every sample sent");
+    check(2u == g_frames, "flush: a full and a short record");
+    check(0u == sample_prof_pending(&prof), "flush: ring empty");
+    check((SAMPLE_PROF_PER_RECORD + 3u) == prof.samples, "flush: samples counted");
+
+    /* A full ring empties in one flush. */
+    add_samples(&prof, SAMPLE_PROF_RING_SIZE);
+    (void)sample_prof_flush(&prof, &tlm);
+    check(0u == sample_prof_pending(&prof), "flush: full ring emptied");
+}
+
+int main(void)
+{
+    test_drain_waits_for_full_record();
+    test_drain_sends_only_full_records();
+    test_flush_sends_the_rest();
+
+    if (0u != g_failures)
+    {
+        printf("sample_prof_test: %u failed\n", (unsigned)g_failures);
+        return EXIT_FAILURE;
+    }
+
+    printf("sample_prof_test: passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,387 @@
+/*******************************************************************************
+ * @file workq.c
+ *
+ * @brief Fork-join work stealing runtime for the U54 harts (MPFS).
+ *
+ * See "workq.h" for details of how to use this module.
+ */
+
+#include "mpfs_hal/mss_hal.h"
+#include "workq.h"
+#include "fmt.h"
+
+#define WORKQ_LINE_ALIGNED          __attribute__((aligned(64)))
+#define WORKQ_DEQUE_MASK            ((int64_t)WORKQ_DEQUE_SIZE - 1)
+
+typedef struct workq_task
+{
+    workq_fn_t fn;
+    void * arg;
+    workq_group_t * group;
+    uint32_t begin;
+    uint32_t end;
+    uint32_t grain;
+} workq_task_t;
+
+/*------------------------------------------------------------------------------
+  One hart's deque (Chase and Lev): the owner pushes and pops at bottom,
+  thieves take from top with a compare-and-swap, and the two only race for
+  the last task. top and bottom are on lines of their own so thieves polling
+  top do not slow the owner down.
+ */
+typedef struct workq_hart
+{
+    volatile int64_t top WORKQ_LINE_ALIGNED;
+    volatile int64_t bottom WORKQ_LINE_ALIGNED;
+    uint32_t tasks;                 /* run by this hart */
+    uint32_t steals;                /* taken by this hart from others */
+    uint32_t sleeps;
+    workq_task_t slots[WORKQ_DEQUE_SIZE];
+} workq_hart_t;
+
+static workq_hart_t g_harts[WORKQ_HARTS];
+
+/* Harts asleep in workq_worker(), by bit. */
+static volatile uint32_t g_sleepers WORKQ_LINE_ALIGNED;
+
+/* Harts taking part, by bit; see workq_set_harts(). */
+static volatile uint32_t g_active WORKQ_LINE_ALIGNED = (1u << WORKQ_HARTS) - 1u;
+
+/*------------------------------------------------------------------------------
+  Runtime index of the calling hart; WORKQ_HARTS or more if it has none.
+ */
+static inline uint32_t self_index(void)
+{
+    return (uint32_t)read_csr(mhartid) - WORKQ_FIRST_HART;
+}
+
+static uint8_t push(uint32_t self, const workq_task_t * task)
+{
+    workq_hart_t * h = &g_harts[self];
+    int64_t b = __atomic_load_n(&h->bottom, __ATOMIC_RELAXED);
+    int64_t t = __atomic_load_n(&h->top, __ATOMIC_ACQUIRE);
+
+    if ((b - t) >= (int64_t)WORKQ_DEQUE_SIZE)
+    {
+        return 0u;
+    }
+
+    h->slots[b & WORKQ_DEQUE_MASK] = *task;
+    __atomic_store_n(&h->bottom, b + 1, __ATOMIC_RELEASE);
+    return 1u;
+}
+
+static uint8_t pop(uint32_t self, workq_task_t * task)
+{
+    workq_hart_t * h = &g_harts[self];
+    int64_t b = __atomic_load_n(&h->bottom, __ATOMIC_RELAXED) - 1;
+    int64_t t;
+    uint8_t taken = 1u;
+
+    __atomic_store_n(&h->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    t = __atomic_load_n(&h->top, __ATOMIC_RELAXED);
+
+    if (t > b)
+    {
+        /* Empty. */
+        __atomic_store_n(&h->bottom, b + 1, __ATOMIC_RELAXED);
+        return 0u;
+    }
+
+    *task = h->slots[b & WORKQ_DEQUE_MASK];
+    if (t == b)
+    {
+        /* The last task: whoever moves top first has it. */
+        taken = __atomic_compare_exchange_n(&h->top, &t, t + 1, 0,
+                                            __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+        __atomic_store_n(&h->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+
+    return taken;
+}
+
+static uint8_t steal(uint32_t victim, workq_task_t * task)
+{
+    workq_hart_t * h = &g_harts[victim];
+    int64_t t = __atomic_load_n(&h->top, __ATOMIC_ACQUIRE);
+    int64_t b;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    b = __atomic_load_n(&h->bottom, __ATOMIC_ACQUIRE);
+    if (t >= b)
+    {
+        return 0u;
+    }
+
+    /* The copy is only used if top is still t, so the owner cannot have
+       reused the slot. */
+    *task = h->slots[t & WORKQ_DEQUE_MASK];
+    return __atomic_compare_exchange_n(&h->top, &t, t + 1, 0,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+/*------------------------------------------------------------------------------
+  Own deque first, newest task; then the other harts' oldest.
+ */
+static uint8_t find_task(uint32_t self, workq_task_t * task)
+{
+    uint32_t idx;
+    uint32_t victim;
+
+    if (0u != pop(self, task))
+    {
+        return 1u;
+    }
+
+    for (idx = 1u; idx < WORKQ_HARTS; idx++)
+    {
+        victim = (self + idx) % WORKQ_HARTS;
+        if (0u != steal(victim, task))
+        {
+            g_harts[self].steals++;
+            return 1u;
+        }
+    }
+
+    return 0u;
+}
+
+/*------------------------------------------------------------------------------
+  Wakes one sleeping hart, if there is one, after a push. Pairs with the
+  sleeper setting its bit before it looks at the deques for the last time,
+  so either the sleeper sees the task or the pusher sees the bit.
+ */
+static void ring_doorbell(void)
+{
+    uint32_t idle;
+    uint32_t bit;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    idle = __atomic_load_n(&g_sleepers, __ATOMIC_RELAXED) & g_active;
+    if (0u != idle)
+    {
+        bit = idle & (0u - idle);
+        if (0u != (__atomic_fetch_and(&g_sleepers, ~bit, __ATOMIC_SEQ_CST) & bit))
+        {
+            raise_soft_interrupt(WORKQ_FIRST_HART + (uint32_t)__builtin_ctz(bit));
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------
+  Splits off upper halves for others to steal, runs what is left.
+ */
+static void run_task(uint32_t self, workq_task_t * task)
+{
+    workq_task_t half;
+    uint32_t mid;
+
+    while ((task->end - task->begin) > task->grain)
+    {
+        mid = task->begin + ((task->end - task->begin) / 2u);
+        half = *task;
+        half.begin = mid;
+
+        __atomic_add_fetch(&task->group->pending, 1u, __ATOMIC_RELAXED);
+        if (0u == push(self, &half))
+        {
+            __atomic_sub_fetch(&task->group->pending, 1u, __ATOMIC_RELAXED);
+            break;
+        }
+        task->end = mid;
+        ring_doorbell();
+    }
+
+    task->fn(task->arg, task->begin, task->end);
+    g_harts[self].tasks++;
+    __atomic_sub_fetch(&task->group->pending, 1u, __ATOMIC_RELEASE);
+}
+
+/***************************************************************************//**
+ * See "workq.h" for details of how to use this function.
+ */
+void workq_spawn(workq_group_t * group, workq_fn_t fn, void * arg,
+                 uint32_t begin, uint32_t end, uint32_t grain)
+{
+    uint32_t self = self_index();
+    workq_task_t task;
+
+    if (begin >= end)
+    {
+        return;
+    }
+    if (self >= WORKQ_HARTS)
+    {
+        fn(arg, begin, end);
+        return;
+    }
+
+    task.fn = fn;
+    task.arg = arg;
+    task.group = group;
+    task.begin = begin;
+    task.end = end;
+    task.grain = (0u != grain) ? grain : 1u;
+
+    __atomic_add_fetch(&group->pending, 1u, __ATOMIC_RELAXED);
+    if (0u != push(self, &task))
+    {
+        ring_doorbell();
+    }
+    else
+    {
+        run_task(self, &task);
+    }
+}
+
+/***************************************************************************//**
+ * See "workq.h" for details of how to use this function.
+ */
+void workq_wait(workq_group_t * group)
+{
+    uint32_t self = self_index();
+    workq_task_t task;
+
+    if (self >= WORKQ_HARTS)
+    {
+        return;
+    }
+
+    while (0u != __atomic_load_n(&group->pending, __ATOMIC_ACQUIRE))
+    {
+        if (0u != find_task(self, &task))
+        {
+            run_task(self, &task);
+        }
+    }
+}
+
+/***************************************************************************//**
+ * See "workq.h" for details of how to use this function.
+ */
+void workq_parallel_for(workq_fn_t fn, void * arg, uint32_t begin,
+                        uint32_t end, uint32_t grain)
+{
+    workq_group_t group = WORKQ_GROUP_INIT;
+    uint32_t self = self_index();
+    workq_task_t task;
+
+    if (begin >= end)
+    {
+        return;
+    }
+    if (self >= WORKQ_HARTS)
+    {
+        fn(arg, begin, end);
+        return;
+    }
+
+    task.fn = fn;
+    task.arg = arg;
+    task.group = &group;
+    task.begin = begin;
+    task.end = end;
+    task.grain = (0u != grain) ? grain : 1u;
+
+    group.pending = 1u;
+    run_task(self, &task);
+    workq_wait(&group);
+}
+
+/***************************************************************************//**
+ * See "workq.h" for details of how to use this function.
+ */
+void workq_worker(void)
+{
+    uint32_t self = self_index();
+    uint32_t bit = 1u << self;
+    workq_task_t task;
+    uint8_t found;
+
+    while (self >= WORKQ_HARTS)
+    {
+        __asm volatile ("wfi");
+    }
+
+    while (1)
+    {
+        found = 0u;
+        if (0u != (g_active & bit))
+        {
+            found = find_task(self, &task);
+        }
+
+        if (0u == found)
+        {
+            /* With MIE clear a doorbell still ends wfi but is not taken, so
+               one that comes after the last look cannot be lost. */
+            __disable_irq();
+            __atomic_fetch_or(&g_sleepers, bit, __ATOMIC_SEQ_CST);
+            if (0u != (g_active & bit))
+            {
+                found = find_task(self, &task);
+            }
+            if (0u == found)
+            {
+                g_harts[self].sleeps++;
+                __asm volatile ("wfi");
+            }
+            __atomic_fetch_and(&g_sleepers, ~bit, __ATOMIC_SEQ_CST);
+            clear_soft_interrupt();
+
+            /* Take any external interrupt that ended the wfi. */
+            __enable_irq();
+        }
+
+        if (0u != found)
+        {
+            run_task(self, &task);
+        }
+    }
+}
+
+/***************************************************************************//**
+ * See "workq.h" for details of how to use this function.
+ */
+void workq_set_harts(uint32_t count)
+{
+    if (0u == count)
+    {
+        count = 1u;
+    }
+    if (count > WORKQ_HARTS)
+    {
+        count = WORKQ_HARTS;
+    }
+
+    __atomic_store_n(&g_active, (1u << count) - 1u, __ATOMIC_RELEASE);
+}
+
+/***************************************************************************//**
+ * See "workq.h" for details of how to use this function.
+ */
+void workq_report(workq_out_t out)
+{
+    char line[80];
+    char * p;
+    uint32_t idx;
+
+    out("\r\nwork stealing runtime:\r\n");
+    for (idx = 0u; idx < WORKQ_HARTS; idx++)
+    {
+        p = line;
+        p = fmt_str(p, "  hart ");
+        p = fmt_u32(p, WORKQ_FIRST_HART + idx, 0u, ' ');
+        p = fmt_str(p, "  tasks=");
+        p = fmt_u32(p, g_harts[idx].tasks, 8u, ' ');
+        p = fmt_str(p, "  stolen=");
+        p = fmt_u32(p, g_harts[idx].steals, 8u, ' ');
+        p = fmt_str(p, "  sleeps=");
+        p = fmt_u32(p, g_harts[idx].sleeps, 8u, ' ');
+        p = fmt_str(p, "\r\n");
+        *p = '\0';
+
+        out(line);
+    }
+}
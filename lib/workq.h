@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * @file workq.h
+ *
+ * @brief Fork-join work stealing runtime for the U54 harts (MPFS).
+ *
+ * Harts WORKQ_FIRST_HART to WORKQ_FIRST_HART + WORKQ_HARTS - 1 (U54_1 to
+ * U54_4) each own a deque of tasks. A hart pushes the tasks it forks onto
+ * the bottom of its own deque and pops them back from the bottom, newest
+ * first, so it keeps working on data it has just touched. A hart with
+ * nothing to do steals the oldest task from the top of another hart's
+ * deque, which for a split range is the biggest piece left.
+ *
+ * A task is a function over a range of indices. When it runs, a range
+ * longer than its grain is halved, the upper half pushed as a new task and
+ * the lower half kept, until the piece left is no longer than the grain;
+ * only then is the function called. Idle harts therefore always find big
+ * pieces to steal, and uneven work (rows of a frame that take longer than
+ * others) spreads out by itself.
+ *
+ *     static void scale(void * arg, uint32_t begin, uint32_t end)
+ *     {
+ *         for (uint32_t i = begin; i < end; i++) { ... }
+ *     }
+ *
+ *     workq_parallel_for(scale, &buf, 0u, BUF_LEN, 256u);
+ *
+ * workq_spawn() and workq_wait() fork and join explicitly; a group counts
+ * the tasks forked into it that have not finished, and workq_wait() is the
+ * completion barrier. The waiting hart runs and steals tasks until the
+ * group is done instead of spinning.
+ *
+ * Worker harts call workq_worker(), which never returns. When no deque has
+ * work, a worker sleeps in wfi until a hart that pushes a task rings its
+ * doorbell: a machine software interrupt (MIP_MSIP), which must be enabled
+ * in its mie. Interrupts routed to a sleeping worker (irq_affinity.h) are
+ * still taken.
+ *
+ * Functions called from other harts than these run the work serially.
+ */
+
+#ifndef WORKQ_H_
+#define WORKQ_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WORKQ_FIRST_HART            1u
+#define WORKQ_HARTS                 4u
+
+/* Tasks per deque, a power of 2. A range is split at most log2(len/grain)
+   times before its first piece runs; when a deque is full the rest of the
+   range runs on the hart that has it. */
+#ifndef WORKQ_DEQUE_SIZE
+#define WORKQ_DEQUE_SIZE            64u
+#endif
+
+typedef void (*workq_fn_t)(void * arg, uint32_t begin, uint32_t end);
+
+/* Tasks forked and not yet finished. */
+typedef struct workq_group
+{
+    volatile uint32_t pending;
+} workq_group_t;
+
+#define WORKQ_GROUP_INIT            { 0u }
+
+/*------------------------------------------------------------------------------
+  Called once per report line, e.g. safe_MSS_UART0_polled_tx_string().
+ */
+typedef void (*workq_out_t)(const char * line);
+
+/***************************************************************************//**
+ * workq_spawn() forks fn over [begin, end) into group, split down to grain
+ * indices per call.
+ */
+void workq_spawn(workq_group_t * group, workq_fn_t fn, void * arg,
+                 uint32_t begin, uint32_t end, uint32_t grain);
+
+/***************************************************************************//**
+ * workq_wait() returns when every task forked into group has finished,
+ * running tasks in the meantime.
+ */
+void workq_wait(workq_group_t * group);
+
+/***************************************************************************//**
+ * workq_parallel_for() runs fn over [begin, end) on the runtime's harts and
+ * returns when it is done.
+ */
+void workq_parallel_for(workq_fn_t fn, void * arg, uint32_t begin,
+                        uint32_t end, uint32_t grain);
+
+/***************************************************************************//**
+ * workq_worker() runs and steals tasks on the calling hart for ever.
+ */
+void workq_worker(void);
+
+/***************************************************************************//**
+ * workq_set_harts() limits the runtime to the first count harts (at least
+ * one); the others sleep and are not sent work. For measuring how work
+ * scales with the number of harts.
+ */
+void workq_set_harts(uint32_t count);
+
+/***************************************************************************//**
+ * workq_report() prints the tasks each hart has run, how many it stole and
+ * how often it went to sleep.
+ */
+void workq_report(workq_out_t out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WORKQ_H_ */